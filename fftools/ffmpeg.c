@@ -166,6 +166,7 @@ static int restore_tty;
 
 #if HAVE_THREADS
 static void free_input_threads(void);
+static void stop_encoder_thread(OutputStream *ost);
 #endif
 
 /* sub2video hack:
@@ -489,6 +490,12 @@ static void ffmpeg_cleanup(int ret)
         av_log(NULL, AV_LOG_INFO, "bench: maxrss=%ikB\n", maxrss);
     }
 
+#if HAVE_THREADS
+    for (i = 0; i < nb_output_streams; i++)
+        if (output_streams[i])
+            stop_encoder_thread(output_streams[i]);
+#endif
+
     for (i = 0; i < nb_filtergraphs; i++) {
         FilterGraph *fg = filtergraphs[i];
         avfilter_graph_free(&fg->graph);
@@ -907,6 +914,231 @@ static int check_recording_time(OutputStream *ost)
     return 1;
 }
 
+#if HAVE_THREADS
+typedef struct EncoderResult {
+    AVPacket pkt;
+    char *stats_out;    /* copy of the encoder stats_out for two-pass logging */
+    /* 0 for a packet; for the message ending the output of one frame:
+     * 1, AVERROR_EOF once the encoder is flushed, or an error code */
+    int ret;
+} EncoderResult;
+
+static void *encoder_thread(void *arg)
+{
+    OutputStream *ost = arg;
+    AVCodecContext *enc = ost->enc_ctx;
+    const char *desc = enc->codec_type == AVMEDIA_TYPE_VIDEO ? "video" : "audio";
+    EncoderResult res;
+    AVFrame *frame;
+    int64_t pts;
+    int ret;
+
+    while (av_thread_message_queue_recv(ost->enc_frame_queue, &frame, 0) >= 0) {
+        pts = frame ? frame->pts : AV_NOPTS_VALUE;
+        ret = avcodec_send_frame(enc, frame);
+        av_frame_free(&frame);
+
+        while (ret >= 0) {
+            memset(&res, 0, sizeof(res));
+            av_init_packet(&res.pkt);
+
+            ret = avcodec_receive_packet(enc, &res.pkt);
+            if (ret == AVERROR(EAGAIN)) {
+                ret = 1;
+                break;
+            }
+            if (ret < 0)
+                break;
+
+            if (debug_ts) {
+                av_log(NULL, AV_LOG_INFO, "encoder -> type:%s "
+                       "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n", desc,
+                       av_ts2str(res.pkt.pts), av_ts2timestr(res.pkt.pts, &enc->time_base),
+                       av_ts2str(res.pkt.dts), av_ts2timestr(res.pkt.dts, &enc->time_base));
+            }
+
+            if (enc->codec_type == AVMEDIA_TYPE_VIDEO && res.pkt.pts == AV_NOPTS_VALUE &&
+                !(enc->codec->capabilities & AV_CODEC_CAP_DELAY))
+                res.pkt.pts = pts;
+            av_packet_rescale_ts(&res.pkt, enc->time_base, ost->mux_timebase);
+
+            if (ost->logfile && enc->stats_out)
+                res.stats_out = av_strdup(enc->stats_out);
+
+            ret = av_thread_message_queue_send(ost->enc_pkt_queue, &res, 0);
+            if (ret < 0) {
+                av_packet_unref(&res.pkt);
+                av_freep(&res.stats_out);
+            }
+        }
+
+        memset(&res, 0, sizeof(res));
+        res.ret = ret;
+        if (ret == AVERROR_EOF && ost->logfile && enc->stats_out)
+            res.stats_out = av_strdup(enc->stats_out);
+        if (av_thread_message_queue_send(ost->enc_pkt_queue, &res, 0) < 0) {
+            av_freep(&res.stats_out);
+            break;
+        }
+        if (ret < 0)
+            break;
+    }
+
+    return NULL;
+}
+
+static int init_encoder_thread(OutputStream *ost)
+{
+    int ret;
+
+    ret = av_thread_message_queue_alloc(&ost->enc_frame_queue,
+                                        ost->enc_thread_queue_size, sizeof(AVFrame *));
+    if (ret < 0)
+        return ret;
+    /* room for the output of all queued frames in the common case of at most
+     * one packet per frame, the encoder thread waits if there are more */
+    ret = av_thread_message_queue_alloc(&ost->enc_pkt_queue,
+                                        2 * ost->enc_thread_queue_size + 1,
+                                        sizeof(EncoderResult));
+    if (ret < 0)
+        goto fail;
+
+    if ((ret = pthread_create(&ost->enc_thread, NULL, encoder_thread, ost))) {
+        av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s\n", strerror(ret));
+        ret = AVERROR(ret);
+        goto fail;
+    }
+    return 0;
+fail:
+    av_thread_message_queue_free(&ost->enc_frame_queue);
+    av_thread_message_queue_free(&ost->enc_pkt_queue);
+    return ret;
+}
+
+static void stop_encoder_thread(OutputStream *ost)
+{
+    EncoderResult res;
+    AVFrame *frame;
+
+    if (!ost->enc_frame_queue)
+        return;
+
+    av_thread_message_queue_set_err_recv(ost->enc_frame_queue, AVERROR_EOF);
+    av_thread_message_queue_set_err_send(ost->enc_pkt_queue, AVERROR_EOF);
+    while (av_thread_message_queue_recv(ost->enc_frame_queue, &frame,
+                                        AV_THREAD_MESSAGE_NONBLOCK) >= 0)
+        av_frame_free(&frame);
+    while (av_thread_message_queue_recv(ost->enc_pkt_queue, &res,
+                                        AV_THREAD_MESSAGE_NONBLOCK) >= 0) {
+        av_packet_unref(&res.pkt);
+        av_freep(&res.stats_out);
+    }
+    pthread_join(ost->enc_thread, NULL);
+    while (av_thread_message_queue_recv(ost->enc_pkt_queue, &res,
+                                        AV_THREAD_MESSAGE_NONBLOCK) >= 0) {
+        av_packet_unref(&res.pkt);
+        av_freep(&res.stats_out);
+    }
+
+    av_thread_message_queue_free(&ost->enc_frame_queue);
+    av_thread_message_queue_free(&ost->enc_pkt_queue);
+    ost->enc_frames_in_flight = 0;
+}
+
+/*
+ * Output the packets produced by the encoding thread for the oldest frame
+ * still in flight. Packets are always output in the order the frames were
+ * submitted, at points which only depend on the number of frames submitted,
+ * so the muxing order does not depend on the thread timings.
+ */
+static int output_encoder_results(OutputFile *of, OutputStream *ost)
+{
+    EncoderResult res;
+    int ret;
+
+    while (1) {
+        ret = av_thread_message_queue_recv(ost->enc_pkt_queue, &res, 0);
+        if (ret < 0)
+            return ret;
+
+        if (ost->logfile && res.stats_out)
+            fprintf(ost->logfile, "%s", res.stats_out);
+        av_freep(&res.stats_out);
+
+        if (res.ret) {
+            ost->enc_frames_in_flight--;
+            return res.ret < 0 ? res.ret : 0;
+        }
+
+        if (ost->finished & MUXER_FINISHED) {
+            av_packet_unref(&res.pkt);
+        } else {
+            int pkt_size = res.pkt.size;
+            output_packet(of, &res.pkt, ost, 0);
+            if (ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO && vstats_filename)
+                do_video_stats(ost, pkt_size);
+        }
+    }
+}
+
+/*
+ * Queue a frame, or NULL to flush the encoder, for the encoding thread,
+ * first outputting the packets of the oldest frame if the queue is full.
+ */
+static void submit_encoder_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
+{
+    AVFrame *clone = NULL;
+    int ret = 0;
+
+    while (ost->enc_frames_in_flight >= ost->enc_thread_queue_size &&
+           (ret = output_encoder_results(of, ost)) >= 0)
+        ;
+    if (ret < 0)
+        goto error;
+
+    if (frame) {
+        clone = av_frame_clone(frame);
+        if (!clone) {
+            ret = AVERROR(ENOMEM);
+            goto error;
+        }
+    }
+    ret = av_thread_message_queue_send(ost->enc_frame_queue, &clone, 0);
+    if (ret < 0) {
+        av_frame_free(&clone);
+        goto error;
+    }
+    ost->enc_frames_in_flight++;
+    return;
+error:
+    av_log(NULL, AV_LOG_FATAL, "%s encoding failed: %s\n",
+           ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO ? "Video" : "Audio",
+           av_err2str(ret));
+    exit_program(1);
+}
+
+/*
+ * Flush the encoder of a stream encoded in its own thread and output all
+ * the remaining packets.
+ */
+static void flush_encoder_thread(OutputFile *of, OutputStream *ost)
+{
+    int ret;
+
+    submit_encoder_frame(of, ost, NULL);
+    while (ost->enc_frames_in_flight) {
+        ret = output_encoder_results(of, ost);
+        if (ret < 0 && ret != AVERROR_EOF) {
+            av_log(NULL, AV_LOG_FATAL, "%s encoding failed: %s\n",
+                   ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO ? "video" : "audio",
+                   av_err2str(ret));
+            exit_program(1);
+        }
+    }
+    stop_encoder_thread(ost);
+}
+#endif
+
 static void do_audio_out(OutputFile *of, OutputStream *ost,
                          AVFrame *frame)
 {
@@ -936,6 +1168,13 @@ static void do_audio_out(OutputFile *of, OutputStream *ost,
                enc->time_base.num, enc->time_base.den);
     }
 
+#if HAVE_THREADS
+    if (ost->enc_frame_queue) {
+        submit_encoder_frame(of, ost, frame);
+        return;
+    }
+#endif
+
     ret = avcodec_send_frame(enc, frame);
     if (ret < 0)
         goto error;
@@ -1283,6 +1522,16 @@ static void do_video_out(OutputFile *of,
 
         ost->frames_encoded++;
 
+#if HAVE_THREADS
+        if (ost->enc_frame_queue) {
+            submit_encoder_frame(of, ost, in_picture);
+            av_frame_remove_side_data(in_picture, AV_FRAME_DATA_A53_CC);
+            ost->sync_opts++;
+            ost->frame_number++;
+            continue;
+        }
+#endif
+
         ret = avcodec_send_frame(enc, in_picture);
         if (ret < 0)
             goto error;
@@ -1595,6 +1844,15 @@ static void print_final_stats(int64_t total_size)
 
         av_log(NULL, AV_LOG_VERBOSE, "  Total: %"PRIu64" packets (%"PRIu64" bytes) demuxed\n",
                total_packets, total_size);
+#if HAVE_THREADS
+        if (f->thread_nb_msgs)
+            av_log(NULL, AV_LOG_VERBOSE, "  Demuxing thread: %"PRIu64" packets "
+                   "in %"PRIu64" messages; %.2f messages queued on average; "
+                   "%.3fs spent sending\n",
+                   f->thread_nb_pkts, f->thread_nb_msgs,
+                   (double)f->thread_queue_fill / f->thread_nb_msgs,
+                   f->thread_send_time / 1000000.0);
+#endif
     }
 
     for (i = 0; i < nb_output_files; i++) {
@@ -1902,6 +2160,17 @@ static void flush_encoders(void)
             }
         }
 
+#if HAVE_THREADS
+        if (ost->enc_frame_queue) {
+            flush_encoder_thread(of, ost);
+            if (enc->codec_type != AVMEDIA_TYPE_AUDIO || enc->frame_size > 1) {
+                AVPacket pkt = { 0 };
+                output_packet(of, &pkt, ost, 1);
+            }
+            continue;
+        }
+#endif
+
         if (enc->codec_type == AVMEDIA_TYPE_AUDIO && enc->frame_size <= 1)
             continue;
 
@@ -3639,6 +3908,19 @@ static int init_output_stream(OutputStream *ost, char *error, int error_len)
     if (ret < 0)
         return ret;
 
+#if HAVE_THREADS
+    if (ost->encoding_needed && ost->enc_thread_queue_size > 0 &&
+        (ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO ||
+         ost->enc_ctx->codec_type == AVMEDIA_TYPE_AUDIO)) {
+        ret = init_encoder_thread(ost);
+        if (ret < 0) {
+            snprintf(error, error_len, "Error starting the encoding thread for "
+                     "output stream #%d:%d", ost->file_index, ost->index);
+            return ret;
+        }
+    }
+#endif
+
     ost->initialized = 1;
 
     ret = check_init_output_file(output_files[ost->file_index], ost->file_index);
@@ -4021,10 +4303,131 @@ static int check_keyboard_interaction(int64_t cur_time)
 }
 
 #if HAVE_THREADS
+typedef struct InputPacketBatch {
+    AVPacket *pkts;
+    int nb_pkts;
+} InputPacketBatch;
+
+static void free_input_packet_batch(AVPacket **pkts, int start, int nb_pkts)
+{
+    int i;
+
+    for (i = start; i < nb_pkts; i++)
+        av_packet_unref(&(*pkts)[i]);
+    av_freep(pkts);
+}
+
+/*
+ * Send a message carrying nb_pkts packets to the main thread: a single
+ * AVPacket when thread_queue_batch is 1, an InputPacketBatch otherwise.
+ */
+static int send_input_message(InputFile *f, void *msg, int nb_pkts,
+                              unsigned *flags)
+{
+    int64_t start = av_gettime_relative();
+    int ret;
+
+    f->thread_nb_msgs++;
+    f->thread_nb_pkts += nb_pkts;
+    f->thread_queue_fill += av_thread_message_queue_nb_elems(f->in_thread_queue);
+
+    ret = av_thread_message_queue_send(f->in_thread_queue, msg, *flags);
+    if (*flags && ret == AVERROR(EAGAIN)) {
+        *flags = 0;
+        ret = av_thread_message_queue_send(f->in_thread_queue, msg, *flags);
+        av_log(f->ctx, AV_LOG_WARNING,
+               "Thread message queue blocking; consider raising the "
+               "thread_queue_size option (current value: %d)\n",
+               f->thread_queue_size);
+    }
+    f->thread_send_time += av_gettime_relative() - start;
+
+    if (ret < 0 && ret != AVERROR_EOF)
+        av_log(f->ctx, AV_LOG_ERROR,
+               "Unable to send packet to main thread: %s\n",
+               av_err2str(ret));
+    return ret;
+}
+
+static int send_input_packet_batch(InputFile *f, InputPacketBatch *batch,
+                                   unsigned *flags)
+{
+    int ret = send_input_message(f, batch, batch->nb_pkts, flags);
+
+    if (ret < 0) {
+        free_input_packet_batch(&batch->pkts, 0, batch->nb_pkts);
+    } else {
+        /* wake up the main thread if it waits for this batch */
+        pthread_mutex_lock(&f->batch_lock);
+        f->nb_batches_sent++;
+        pthread_cond_signal(&f->batch_cond);
+        pthread_mutex_unlock(&f->batch_lock);
+    }
+    batch->pkts    = NULL;
+    batch->nb_pkts = 0;
+    return ret;
+}
+
+/* Take out the batch being filled by the thread, with batch_lock held. */
+static void take_input_packet_batch(InputFile *f, InputPacketBatch *batch)
+{
+    batch->pkts        = f->thread_batch;
+    batch->nb_pkts     = f->thread_batch_nb;
+    f->thread_batch    = NULL;
+    f->thread_batch_nb = 0;
+}
+
+/* Take out the batch being filled by the thread and send it. */
+static int flush_input_packet_batch(InputFile *f, unsigned *flags)
+{
+    InputPacketBatch batch;
+
+    pthread_mutex_lock(&f->batch_lock);
+    take_input_packet_batch(f, &batch);
+    if (batch.nb_pkts)
+        f->nb_batches_taken++;
+    pthread_mutex_unlock(&f->batch_lock);
+
+    if (!batch.nb_pkts) {
+        av_freep(&batch.pkts);
+        return 0;
+    }
+    return send_input_packet_batch(f, &batch, flags);
+}
+
+/* Add a packet to the batch being filled, and send the batch once full. */
+static int add_input_packet(InputFile *f, AVPacket *pkt, unsigned *flags)
+{
+    int full;
+
+    /* The main thread takes the batch over if it is not sent in time,
+     * for example while av_read_frame() blocks on a slow input. */
+    pthread_mutex_lock(&f->batch_lock);
+    if (!f->thread_batch) {
+        f->thread_batch = av_malloc_array(f->thread_queue_batch,
+                                          sizeof(*f->thread_batch));
+        if (!f->thread_batch) {
+            pthread_mutex_unlock(&f->batch_lock);
+            av_packet_unref(pkt);
+            return AVERROR(ENOMEM);
+        }
+        f->thread_batch_start = av_gettime_relative();
+        /* let the main thread know when to take the batch over */
+        pthread_cond_signal(&f->batch_cond);
+    }
+    f->thread_batch[f->thread_batch_nb++] = *pkt;
+    full = f->thread_batch_nb >= f->thread_queue_batch ||
+           av_gettime_relative() - f->thread_batch_start >= f->thread_queue_batch_time;
+    pthread_mutex_unlock(&f->batch_lock);
+
+    return full ? flush_input_packet_batch(f, flags) : 0;
+}
+
 static void *input_thread(void *arg)
 {
     InputFile *f = arg;
     unsigned flags = f->non_blocking ? AV_THREAD_MESSAGE_NONBLOCK : 0;
+    int batched = f->thread_queue_batch > 1;
     int ret = 0;
 
     while (1) {
@@ -4032,50 +4435,67 @@ static void *input_thread(void *arg)
         ret = av_read_frame(f->ctx, &pkt);
 
         if (ret == AVERROR(EAGAIN)) {
+            /* do not hold back packets while the demuxer has none to offer */
+            if (batched && (ret = flush_input_packet_batch(f, &flags)) < 0)
+                break;
             av_usleep(10000);
             continue;
         }
         if (ret < 0) {
-            av_thread_message_queue_set_err_recv(f->in_thread_queue, ret);
+            int err = batched ? flush_input_packet_batch(f, &flags) : 0;
+            if (err < 0)
+                ret = err;
             break;
         }
-        ret = av_thread_message_queue_send(f->in_thread_queue, &pkt, flags);
-        if (flags && ret == AVERROR(EAGAIN)) {
-            flags = 0;
-            ret = av_thread_message_queue_send(f->in_thread_queue, &pkt, flags);
-            av_log(f->ctx, AV_LOG_WARNING,
-                   "Thread message queue blocking; consider raising the "
-                   "thread_queue_size option (current value: %d)\n",
-                   f->thread_queue_size);
+
+        if (batched) {
+            ret = add_input_packet(f, &pkt, &flags);
+        } else {
+            ret = send_input_message(f, &pkt, 1, &flags);
+            if (ret < 0)
+                av_packet_unref(&pkt);
         }
-        if (ret < 0) {
-            if (ret != AVERROR_EOF)
-                av_log(f->ctx, AV_LOG_ERROR,
-                       "Unable to send packet to main thread: %s\n",
-                       av_err2str(ret));
-            av_packet_unref(&pkt);
-            av_thread_message_queue_set_err_recv(f->in_thread_queue, ret);
+        if (ret < 0)
             break;
-        }
     }
 
+    av_thread_message_queue_set_err_recv(f->in_thread_queue, ret);
+
+    pthread_mutex_lock(&f->batch_lock);
+    f->thread_finished = 1;
+    pthread_cond_signal(&f->batch_cond);
+    pthread_mutex_unlock(&f->batch_lock);
+
     return NULL;
 }
 
 static void free_input_thread(int i)
 {
     InputFile *f = input_files[i];
+    InputPacketBatch batch;
     AVPacket pkt;
 
     if (!f || !f->in_thread_queue)
         return;
     av_thread_message_queue_set_err_send(f->in_thread_queue, AVERROR_EOF);
-    while (av_thread_message_queue_recv(f->in_thread_queue, &pkt, 0) >= 0)
-        av_packet_unref(&pkt);
+    if (f->thread_queue_batch > 1) {
+        while (av_thread_message_queue_recv(f->in_thread_queue, &batch, 0) >= 0)
+            free_input_packet_batch(&batch.pkts, 0, batch.nb_pkts);
+    } else {
+        while (av_thread_message_queue_recv(f->in_thread_queue, &pkt, 0) >= 0)
+            av_packet_unref(&pkt);
+    }
 
     pthread_join(f->thread, NULL);
     f->joined = 1;
     av_thread_message_queue_free(&f->in_thread_queue);
+
+    free_input_packet_batch(&f->pkt_batch, f->pkt_batch_pos, f->pkt_batch_nb);
+    f->pkt_batch_nb = f->pkt_batch_pos = 0;
+    free_input_packet_batch(&f->thread_batch, 0, f->thread_batch_nb);
+    f->thread_batch_nb = 0;
+    pthread_cond_destroy(&f->batch_cond);
+    pthread_mutex_destroy(&f->batch_lock);
 }
 
 static void free_input_threads(void)
@@ -4097,13 +4517,28 @@ static int init_input_thread(int i)
     if (f->ctx->pb ? !f->ctx->pb->seekable :
         strcmp(f->ctx->iformat->name, "lavfi"))
         f->non_blocking = 1;
-    ret = av_thread_message_queue_alloc(&f->in_thread_queue,
-                                        f->thread_queue_size, sizeof(AVPacket));
+    ret = av_thread_message_queue_alloc(&f->in_thread_queue, f->thread_queue_size,
+                                        f->thread_queue_batch > 1 ?
+                                        sizeof(InputPacketBatch) : sizeof(AVPacket));
     if (ret < 0)
         return ret;
+    /* batches dropped when a previous thread was freed were never received */
+    f->nb_batches_taken = f->nb_batches_sent = f->nb_batches_recv = 0;
+    f->thread_finished  = 0;
+    if ((ret = pthread_mutex_init(&f->batch_lock, NULL))) {
+        av_thread_message_queue_free(&f->in_thread_queue);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&f->batch_cond, NULL))) {
+        pthread_mutex_destroy(&f->batch_lock);
+        av_thread_message_queue_free(&f->in_thread_queue);
+        return AVERROR(ret);
+    }
 
     if ((ret = pthread_create(&f->thread, NULL, input_thread, f))) {
         av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        pthread_cond_destroy(&f->batch_cond);
+        pthread_mutex_destroy(&f->batch_lock);
         av_thread_message_queue_free(&f->in_thread_queue);
         return AVERROR(ret);
     }
@@ -4123,11 +4558,85 @@ static int init_input_threads(void)
     return 0;
 }
 
+/*
+ * Take over the batch being filled by the thread if it was started more than
+ * thread_queue_batch_time ago. This is only done when all the batches the
+ * thread took out before were received, so that the packets stay in order.
+ */
+static int take_late_input_packet_batch(InputFile *f, InputPacketBatch *batch)
+{
+    int late;
+
+    pthread_mutex_lock(&f->batch_lock);
+    late = f->thread_batch_nb && f->nb_batches_taken == f->nb_batches_recv &&
+           av_gettime_relative() - f->thread_batch_start >= f->thread_queue_batch_time;
+    if (late)
+        take_input_packet_batch(f, batch);
+    pthread_mutex_unlock(&f->batch_lock);
+    return late;
+}
+
+/*
+ * Wait until the thread sent a batch or finished, or until the batch it is
+ * filling is due to be taken over.
+ */
+static void wait_input_packet_batch(InputFile *f)
+{
+    pthread_mutex_lock(&f->batch_lock);
+    while (f->nb_batches_sent <= f->nb_batches_recv && !f->thread_finished) {
+        if (f->thread_batch_nb && f->nb_batches_taken == f->nb_batches_recv) {
+            int64_t left = f->thread_batch_start + f->thread_queue_batch_time -
+                           av_gettime_relative();
+            int64_t t = av_gettime() + left;
+            struct timespec tv = { .tv_sec  =  t / 1000000,
+                                   .tv_nsec = (t % 1000000) * 1000 };
+
+            if (left <= 0 ||
+                pthread_cond_timedwait(&f->batch_cond, &f->batch_lock, &tv) == ETIMEDOUT)
+                break;
+        } else {
+            pthread_cond_wait(&f->batch_cond, &f->batch_lock);
+        }
+    }
+    pthread_mutex_unlock(&f->batch_lock);
+}
+
 static int get_input_packet_mt(InputFile *f, AVPacket *pkt)
 {
-    return av_thread_message_queue_recv(f->in_thread_queue, pkt,
-                                        f->non_blocking ?
-                                        AV_THREAD_MESSAGE_NONBLOCK : 0);
+    InputPacketBatch batch;
+    int ret;
+
+    if (f->thread_queue_batch == 1)
+        return av_thread_message_queue_recv(f->in_thread_queue, pkt,
+                                            f->non_blocking ?
+                                            AV_THREAD_MESSAGE_NONBLOCK : 0);
+
+    if (f->pkt_batch_pos == f->pkt_batch_nb) {
+        av_freep(&f->pkt_batch);
+        f->pkt_batch_nb = f->pkt_batch_pos = 0;
+
+        /* A partial batch held back by a blocked av_read_frame() is taken
+         * over once its time is up. */
+        while ((ret = av_thread_message_queue_recv(f->in_thread_queue, &batch,
+                                                   AV_THREAD_MESSAGE_NONBLOCK)) == AVERROR(EAGAIN)) {
+            if (take_late_input_packet_batch(f, &batch)) {
+                ret = 1;
+                break;
+            }
+            if (f->non_blocking)
+                break;
+            wait_input_packet_batch(f);
+        }
+        if (ret < 0)
+            return ret;
+        if (!ret)
+            f->nb_batches_recv++;
+        f->pkt_batch    = batch.pkts;
+        f->pkt_batch_nb = batch.nb_pkts;
+    }
+
+    *pkt = f->pkt_batch[f->pkt_batch_pos++];
+    return 0;
 }
 #endif
 
@@ -120,6 +120,8 @@ typedef struct OptionsContext {
     int rate_emu;
     int accurate_seek;
     int thread_queue_size;
+    int thread_queue_batch;
+    int64_t thread_queue_batch_time;
 
     SpecifierOpt *ts_scale;
     int        nb_ts_scale;
@@ -216,6 +218,8 @@ typedef struct OptionsContext {
     int        nb_passlogfiles;
     SpecifierOpt *max_muxing_queue_size;
     int        nb_max_muxing_queue_size;
+    SpecifierOpt *enc_thread_queue_size;
+    int        nb_enc_thread_queue_size;
     SpecifierOpt *guess_layout_max;
     int        nb_guess_layout_max;
     SpecifierOpt *apad;
@@ -418,6 +422,31 @@ typedef struct InputFile {
     int non_blocking;           /* reading packets from the thread should not block */
     int joined;                 /* the thread has been joined */
     int thread_queue_size;      /* maximum number of queued packets */
+    int thread_queue_batch;     /* maximum number of packets sent in one message */
+    int64_t thread_queue_batch_time; /* maximum time in microseconds a packet
+                                        waits for its batch to fill up */
+
+    AVPacket *pkt_batch;        /* last batch received from the thread */
+    int pkt_batch_nb;           /* number of packets in pkt_batch */
+    int pkt_batch_pos;          /* index of the next packet to return from pkt_batch */
+
+    /* batch being filled by the thread, which the main thread takes over
+     * when its first packet waited longer than thread_queue_batch_time */
+    pthread_mutex_t batch_lock; /* protects the fields below */
+    pthread_cond_t batch_cond;  /* signaled when one of them changes */
+    AVPacket *thread_batch;
+    int thread_batch_nb;
+    int64_t thread_batch_start;
+    uint64_t nb_batches_taken;  /* batches taken out to be sent by the thread */
+    uint64_t nb_batches_sent;   /* batches sent by the thread */
+    uint64_t nb_batches_recv;   /* batches received by the main thread */
+    int thread_finished;        /* the thread stopped sending */
+
+    /* statistics of the thread, updated by it and read once it is joined */
+    uint64_t thread_nb_msgs;    /* number of messages sent */
+    uint64_t thread_nb_pkts;    /* number of packets sent */
+    uint64_t thread_queue_fill; /* sum of the queue occupancy seen on each send */
+    int64_t thread_send_time;   /* total time spent sending, in microseconds */
 #endif
 } InputFile;
 
@@ -544,6 +573,16 @@ typedef struct OutputStream {
     /* the packets are buffered here until the muxer is ready to be initialized */
     AVFifoBuffer *muxing_queue;
 
+#if HAVE_THREADS
+    /* maximum number of frames in flight in the encoding thread,
+     * 0 to encode in the main thread */
+    int enc_thread_queue_size;
+    pthread_t enc_thread;                   /* thread running the encoder */
+    AVThreadMessageQueue *enc_frame_queue;  /* frames sent to the encoding thread */
+    AVThreadMessageQueue *enc_pkt_queue;    /* packets returned by the encoding thread */
+    int enc_frames_in_flight;               /* frames whose packets were not output yet */
+#endif
+
     /* packet picture type */
     int pict_type;
 
@@ -1191,6 +1191,9 @@ static int open_input_file(OptionsContext *o, const char *filename)
     f->time_base = (AVRational){ 1, 1 };
 #if HAVE_THREADS
     f->thread_queue_size = o->thread_queue_size > 0 ? o->thread_queue_size : 8;
+    f->thread_queue_batch = o->thread_queue_batch > 0 ? o->thread_queue_batch : 1;
+    f->thread_queue_batch_time = o->thread_queue_batch_time > 0 ?
+                                 o->thread_queue_batch_time : 10000;
 #endif
 
     /* check if all codec options have been used */
@@ -1523,6 +1526,10 @@ static OutputStream *new_output_stream(OptionsContext *o, AVFormatContext *oc, e
     MATCH_PER_STREAM_OPT(max_muxing_queue_size, i, ost->max_muxing_queue_size, oc, st);
     ost->max_muxing_queue_size *= sizeof(AVPacket);
 
+#if HAVE_THREADS
+    MATCH_PER_STREAM_OPT(enc_thread_queue_size, i, ost->enc_thread_queue_size, oc, st);
+#endif
+
     if (oc->oformat->flags & AVFMT_GLOBALHEADER)
         ost->enc_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
 
@@ -3501,6 +3508,12 @@ const OptionDef options[] = {
     { "thread_queue_size", HAS_ARG | OPT_INT | OPT_OFFSET | OPT_EXPERT | OPT_INPUT,
                                                                      { .off = OFFSET(thread_queue_size) },
         "set the maximum number of queued packets from the demuxer" },
+    { "thread_queue_batch", HAS_ARG | OPT_INT | OPT_OFFSET | OPT_EXPERT | OPT_INPUT,
+                                                                     { .off = OFFSET(thread_queue_batch) },
+        "set the maximum number of packets sent at once by the demuxer thread" },
+    { "thread_queue_batch_time", HAS_ARG | OPT_TIME | OPT_OFFSET | OPT_EXPERT | OPT_INPUT,
+                                                                     { .off = OFFSET(thread_queue_batch_time) },
+        "set the maximum time a demuxed packet waits for its batch to fill up", "duration" },
     { "find_stream_info", OPT_BOOL | OPT_PERFILE | OPT_INPUT | OPT_EXPERT, { &find_stream_info },
         "read and decode the streams to fill missing information with heuristics" },
 
@@ -3687,6 +3700,8 @@ const OptionDef options[] = {
 
     { "max_muxing_queue_size", HAS_ARG | OPT_INT | OPT_SPEC | OPT_EXPERT | OPT_OUTPUT, { .off = OFFSET(max_muxing_queue_size) },
         "maximum number of packets that can be buffered while waiting for all streams to initialize", "packets" },
+    { "enc_thread_queue_size", HAS_ARG | OPT_INT | OPT_SPEC | OPT_EXPERT | OPT_OUTPUT, { .off = OFFSET(enc_thread_queue_size) },
+        "encode the stream in its own thread with up to this many frames queued", "frames" },
 
     /* data codec support */
     { "dcodec", HAS_ARG | OPT_DATA | OPT_PERFILE | OPT_EXPERT | OPT_INPUT | OPT_OUTPUT, { .func_arg = opt_data_codec },
@@ -553,19 +553,287 @@ static void copy_input_samples(AACEncContext *s, const AVFrame *frame)
     }
 }
 
+/**
+ * State shared by the channel element jobs of one frame.
+ *
+ * The jobs run through avctx->execute2(), each on the context of the thread
+ * running it, see get_thread_context(). Everything which depends on the
+ * order of the channel elements (the psy bit reservoir, the PNS random state
+ * and the bitstream) stays on the main context and is processed in order
+ * between the jobs, so the output does not depend on the number of threads.
+ */
+typedef struct AACEncFrameJobs {
+    const AVFrame *frame;
+    FFPsyWindowInfo windows[AAC_MAX_CHANNELS];
+    int start_ch[AAC_MAX_CHANNELS];     ///< first channel of each element
+    int bitres_alloc[AAC_MAX_CHANNELS]; ///< psy bit allocation of each element
+    int bitres_bits;
+    uint8_t tns_mode[AAC_MAX_CHANNELS];
+    uint8_t is_mode[AAC_MAX_CHANNELS];
+    uint8_t pred_mode[AAC_MAX_CHANNELS];
+} AACEncFrameJobs;
+
+static AACEncContext *get_thread_context(AVCodecContext *avctx, int threadnr)
+{
+    AACEncContext *s = avctx->priv_data;
+    return threadnr ? s->thread_ctx[threadnr - 1] : s;
+}
+
+static void set_element_context(AACEncContext *s, AACEncFrameJobs *jobs, int i)
+{
+    s->cur_type          = s->chan_map[i + 1];
+    s->cur_channel       = jobs->start_ch[i];
+    s->psy.bitres.bits   = jobs->bitres_bits;
+    s->psy.bitres.alloc  = jobs->bitres_alloc[i];
+}
+
+/**
+ * Window decision, MDCT and clipping avoidance of one channel element.
+ */
+static int encode_element_mdct(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    AACEncContext *s = get_thread_context(avctx, threadnr);
+    AACEncFrameJobs *jobs = arg;
+    FFPsyWindowInfo *wi = jobs->windows + jobs->start_ch[jobnr];
+    ChannelElement *cpe = &s->cpe[jobnr];
+    SingleChannelElement *sce;
+    IndividualChannelStream *ics;
+    float *samples2, *la, *overlap;
+    int tag   = s->chan_map[jobnr + 1];
+    int chans = tag == TYPE_CPE ? 2 : 1;
+    int ch, w;
+
+    for (ch = 0; ch < chans; ch++) {
+        int k;
+        float clip_avoidance_factor;
+        sce = &cpe->ch[ch];
+        ics = &sce->ics;
+        s->cur_channel = jobs->start_ch[jobnr] + ch;
+        overlap  = &s->planar_samples[s->cur_channel][0];
+        samples2 = overlap + 1024;
+        la       = samples2 + (448+64);
+        if (!jobs->frame)
+            la = NULL;
+        if (tag == TYPE_LFE) {
+            wi[ch].window_type[0] = wi[ch].window_type[1] = ONLY_LONG_SEQUENCE;
+            wi[ch].window_shape   = 0;
+            wi[ch].num_windows    = 1;
+            wi[ch].grouping[0]    = 1;
+            wi[ch].clipping[0]    = 0;
+
+            /* Only the lowest 12 coefficients are used in a LFE channel.
+             * The expression below results in only the bottom 8 coefficients
+             * being used for 11.025kHz to 16kHz sample rates.
+             */
+            ics->num_swb = s->samplerate_index >= 8 ? 1 : 3;
+        } else {
+            wi[ch] = s->psy.model->window(&s->psy, samples2, la, s->cur_channel,
+                                          ics->window_sequence[0]);
+        }
+        ics->window_sequence[1] = ics->window_sequence[0];
+        ics->window_sequence[0] = wi[ch].window_type[0];
+        ics->use_kb_window[1]   = ics->use_kb_window[0];
+        ics->use_kb_window[0]   = wi[ch].window_shape;
+        ics->num_windows        = wi[ch].num_windows;
+        ics->swb_sizes          = s->psy.bands    [ics->num_windows == 8];
+        ics->num_swb            = tag == TYPE_LFE ? ics->num_swb : s->psy.num_bands[ics->num_windows == 8];
+        ics->max_sfb            = FFMIN(ics->max_sfb, ics->num_swb);
+        ics->swb_offset         = wi[ch].window_type[0] == EIGHT_SHORT_SEQUENCE ?
+                                    ff_swb_offset_128 [s->samplerate_index]:
+                                    ff_swb_offset_1024[s->samplerate_index];
+        ics->tns_max_bands      = wi[ch].window_type[0] == EIGHT_SHORT_SEQUENCE ?
+                                    ff_tns_max_bands_128 [s->samplerate_index]:
+                                    ff_tns_max_bands_1024[s->samplerate_index];
+
+        for (w = 0; w < ics->num_windows; w++)
+            ics->group_len[w] = wi[ch].grouping[w];
+
+        /* Calculate input sample maximums and evaluate clipping risk */
+        clip_avoidance_factor = 0.0f;
+        for (w = 0; w < ics->num_windows; w++) {
+            const float *wbuf = overlap + w * 128;
+            const int wlen = 2048 / ics->num_windows;
+            float max = 0;
+            int j;
+            /* mdct input is 2 * output */
+            for (j = 0; j < wlen; j++)
+                max = FFMAX(max, fabsf(wbuf[j]));
+            wi[ch].clipping[w] = max;
+        }
+        for (w = 0; w < ics->num_windows; w++) {
+            if (wi[ch].clipping[w] > CLIP_AVOIDANCE_FACTOR) {
+                ics->window_clipping[w] = 1;
+                clip_avoidance_factor = FFMAX(clip_avoidance_factor, wi[ch].clipping[w]);
+            } else {
+                ics->window_clipping[w] = 0;
+            }
+        }
+        if (clip_avoidance_factor > CLIP_AVOIDANCE_FACTOR) {
+            ics->clip_avoidance_factor = CLIP_AVOIDANCE_FACTOR / clip_avoidance_factor;
+        } else {
+            ics->clip_avoidance_factor = 1.0f;
+        }
+
+        apply_window_and_mdct(s, sce, overlap);
+
+        if (s->options.ltp && s->coder->update_ltp) {
+            s->coder->update_ltp(s, sce);
+            apply_window[sce->ics.window_sequence[0]](s->fdsp, sce, &sce->ltp_state[0]);
+            s->mdct1024.mdct_calc(&s->mdct1024, sce->lcoeffs, sce->ret_buf);
+        }
+
+        for (k = 0; k < 1024; k++) {
+            if (!(fabs(cpe->ch[ch].coeffs[k]) < 1E16)) { // Ensure headroom for energy calculation
+                av_log(avctx, AV_LOG_ERROR, "Input contains (near) NaN/+-Inf\n");
+                return AVERROR(EINVAL);
+            }
+        }
+        avoid_clipping(s, sce);
+    }
+
+    return 0;
+}
+
+/**
+ * Quantizer search and TNS of one channel element.
+ */
+static int encode_element_search(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    AACEncContext *s = get_thread_context(avctx, threadnr);
+    AACEncFrameJobs *jobs = arg;
+    FFPsyWindowInfo *wi = jobs->windows + jobs->start_ch[jobnr];
+    ChannelElement *cpe = &s->cpe[jobnr];
+    SingleChannelElement *sce;
+    int chans = s->chan_map[jobnr + 1] == TYPE_CPE ? 2 : 1;
+    int ch, w;
+
+    set_element_context(s, jobs, jobnr);
+    for (ch = 0; ch < chans; ch++) {
+        s->cur_channel = jobs->start_ch[jobnr] + ch;
+        if (s->options.pns && s->coder->mark_pns)
+            s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
+        s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
+    }
+    if (chans > 1
+        && wi[0].window_type[0] == wi[1].window_type[0]
+        && wi[0].window_shape   == wi[1].window_shape) {
+
+        cpe->common_window = 1;
+        for (w = 0; w < wi[0].num_windows; w++) {
+            if (wi[0].grouping[w] != wi[1].grouping[w]) {
+                cpe->common_window = 0;
+                break;
+            }
+        }
+    }
+    for (ch = 0; ch < chans; ch++) { /* TNS */
+        sce = &cpe->ch[ch];
+        s->cur_channel = jobs->start_ch[jobnr] + ch;
+        if (s->options.tns && s->coder->search_for_tns)
+            s->coder->search_for_tns(s, sce);
+        if (s->options.tns && s->coder->apply_tns_filt)
+            s->coder->apply_tns_filt(s, sce);
+        if (sce->tns.present)
+            jobs->tns_mode[jobnr] = 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Intensity stereo, prediction, mid/side stereo and LTP of one channel
+ * element.
+ */
+static int encode_element_stereo(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    AACEncContext *s = get_thread_context(avctx, threadnr);
+    AACEncFrameJobs *jobs = arg;
+    ChannelElement *cpe = &s->cpe[jobnr];
+    SingleChannelElement *sce;
+    int start_ch = jobs->start_ch[jobnr];
+    int chans = s->chan_map[jobnr + 1] == TYPE_CPE ? 2 : 1;
+    int ch;
+
+    set_element_context(s, jobs, jobnr);
+    if (s->options.intensity_stereo) { /* Intensity Stereo */
+        if (s->coder->search_for_is)
+            s->coder->search_for_is(s, avctx, cpe);
+        if (cpe->is_mode) jobs->is_mode[jobnr] = 1;
+        apply_intensity_stereo(cpe);
+    }
+    if (s->options.pred) { /* Prediction */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->options.pred && s->coder->search_for_pred)
+                s->coder->search_for_pred(s, sce);
+            if (cpe->ch[ch].ics.predictor_present) jobs->pred_mode[jobnr] = 1;
+        }
+        if (s->coder->adjust_common_pred)
+            s->coder->adjust_common_pred(s, cpe);
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->options.pred && s->coder->apply_main_pred)
+                s->coder->apply_main_pred(s, sce);
+        }
+        s->cur_channel = start_ch;
+    }
+    if (s->options.mid_side) { /* Mid/Side stereo */
+        if (s->options.mid_side == -1 && s->coder->search_for_ms)
+            s->coder->search_for_ms(s, cpe);
+        else if (cpe->common_window)
+            memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
+        apply_mid_side_stereo(cpe);
+    }
+    adjust_frame_information(cpe, chans);
+    if (s->options.ltp) { /* LTP */
+        for (ch = 0; ch < chans; ch++) {
+            sce = &cpe->ch[ch];
+            s->cur_channel = start_ch + ch;
+            if (s->coder->search_for_ltp)
+                s->coder->search_for_ltp(s, sce, cpe->common_window);
+            if (sce->ics.ltp.present) jobs->pred_mode[jobnr] = 1;
+        }
+        s->cur_channel = start_ch;
+        if (s->coder->adjust_common_ltp)
+            s->coder->adjust_common_ltp(s, cpe);
+    }
+
+    return 0;
+}
+
+/**
+ * Perceptual noise substitution of one channel element.
+ */
+static void encode_element_pns(AVCodecContext *avctx, AACEncContext *s,
+                               AACEncFrameJobs *jobs, int i)
+{
+    int ch, chans = s->chan_map[i + 1] == TYPE_CPE ? 2 : 1;
+
+    if (!s->options.pns || !s->coder->search_for_pns)
+        return;
+
+    set_element_context(s, jobs, i);
+    for (ch = 0; ch < chans; ch++) {
+        s->cur_channel = jobs->start_ch[i] + ch;
+        s->coder->search_for_pns(s, avctx, &s->cpe[i].ch[ch]);
+    }
+}
+
 static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                             const AVFrame *frame, int *got_packet_ptr)
 {
     AACEncContext *s = avctx->priv_data;
-    float **samples = s->planar_samples, *samples2, *la, *overlap;
+    AACEncFrameJobs jobs = { 0 };
     ChannelElement *cpe;
     SingleChannelElement *sce;
-    IndividualChannelStream *ics;
     int i, its, ch, w, chans, tag, start_ch, ret, frame_bits;
     int target_bits, rate_bits, too_many_bits, too_few_bits;
     int ms_mode = 0, is_mode = 0, tns_mode = 0, pred_mode = 0;
     int chan_el_counter[4];
-    FFPsyWindowInfo windows[AAC_MAX_CHANNELS];
+    int job_ret[AAC_MAX_CHANNELS];
+    int serial;
 
     /* add current frame to queue */
     if (frame) {
@@ -583,101 +851,23 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     if (!avctx->frame_number)
         return 0;
 
+    jobs.frame = frame;
     start_ch = 0;
     for (i = 0; i < s->chan_map[0]; i++) {
-        FFPsyWindowInfo* wi = windows + start_ch;
-        tag      = s->chan_map[i+1];
-        chans    = tag == TYPE_CPE ? 2 : 1;
-        cpe      = &s->cpe[i];
-        for (ch = 0; ch < chans; ch++) {
-            int k;
-            float clip_avoidance_factor;
-            sce = &cpe->ch[ch];
-            ics = &sce->ics;
-            s->cur_channel = start_ch + ch;
-            overlap  = &samples[s->cur_channel][0];
-            samples2 = overlap + 1024;
-            la       = samples2 + (448+64);
-            if (!frame)
-                la = NULL;
-            if (tag == TYPE_LFE) {
-                wi[ch].window_type[0] = wi[ch].window_type[1] = ONLY_LONG_SEQUENCE;
-                wi[ch].window_shape   = 0;
-                wi[ch].num_windows    = 1;
-                wi[ch].grouping[0]    = 1;
-                wi[ch].clipping[0]    = 0;
-
-                /* Only the lowest 12 coefficients are used in a LFE channel.
-                 * The expression below results in only the bottom 8 coefficients
-                 * being used for 11.025kHz to 16kHz sample rates.
-                 */
-                ics->num_swb = s->samplerate_index >= 8 ? 1 : 3;
-            } else {
-                wi[ch] = s->psy.model->window(&s->psy, samples2, la, s->cur_channel,
-                                              ics->window_sequence[0]);
-            }
-            ics->window_sequence[1] = ics->window_sequence[0];
-            ics->window_sequence[0] = wi[ch].window_type[0];
-            ics->use_kb_window[1]   = ics->use_kb_window[0];
-            ics->use_kb_window[0]   = wi[ch].window_shape;
-            ics->num_windows        = wi[ch].num_windows;
-            ics->swb_sizes          = s->psy.bands    [ics->num_windows == 8];
-            ics->num_swb            = tag == TYPE_LFE ? ics->num_swb : s->psy.num_bands[ics->num_windows == 8];
-            ics->max_sfb            = FFMIN(ics->max_sfb, ics->num_swb);
-            ics->swb_offset         = wi[ch].window_type[0] == EIGHT_SHORT_SEQUENCE ?
-                                        ff_swb_offset_128 [s->samplerate_index]:
-                                        ff_swb_offset_1024[s->samplerate_index];
-            ics->tns_max_bands      = wi[ch].window_type[0] == EIGHT_SHORT_SEQUENCE ?
-                                        ff_tns_max_bands_128 [s->samplerate_index]:
-                                        ff_tns_max_bands_1024[s->samplerate_index];
-
-            for (w = 0; w < ics->num_windows; w++)
-                ics->group_len[w] = wi[ch].grouping[w];
-
-            /* Calculate input sample maximums and evaluate clipping risk */
-            clip_avoidance_factor = 0.0f;
-            for (w = 0; w < ics->num_windows; w++) {
-                const float *wbuf = overlap + w * 128;
-                const int wlen = 2048 / ics->num_windows;
-                float max = 0;
-                int j;
-                /* mdct input is 2 * output */
-                for (j = 0; j < wlen; j++)
-                    max = FFMAX(max, fabsf(wbuf[j]));
-                wi[ch].clipping[w] = max;
-            }
-            for (w = 0; w < ics->num_windows; w++) {
-                if (wi[ch].clipping[w] > CLIP_AVOIDANCE_FACTOR) {
-                    ics->window_clipping[w] = 1;
-                    clip_avoidance_factor = FFMAX(clip_avoidance_factor, wi[ch].clipping[w]);
-                } else {
-                    ics->window_clipping[w] = 0;
-                }
-            }
-            if (clip_avoidance_factor > CLIP_AVOIDANCE_FACTOR) {
-                ics->clip_avoidance_factor = CLIP_AVOIDANCE_FACTOR / clip_avoidance_factor;
-            } else {
-                ics->clip_avoidance_factor = 1.0f;
-            }
+        jobs.start_ch[i] = start_ch;
+        start_ch += s->chan_map[i + 1] == TYPE_CPE ? 2 : 1;
+    }
 
-            apply_window_and_mdct(s, sce, overlap);
+    avctx->execute2(avctx, encode_element_mdct, &jobs, job_ret, s->chan_map[0]);
+    for (i = 0; i < s->chan_map[0]; i++)
+        if (job_ret[i] < 0)
+            return job_ret[i];
 
-            if (s->options.ltp && s->coder->update_ltp) {
-                s->coder->update_ltp(s, sce);
-                apply_window[sce->ics.window_sequence[0]](s->fdsp, sce, &sce->ltp_state[0]);
-                s->mdct1024.mdct_calc(&s->mdct1024, sce->lcoeffs, sce->ret_buf);
-            }
+    /* The first quantizer search may set the cutoff used by the psy analysis
+     * of the following elements and the main prediction looks at the psy
+     * bands of the next element, so code these element by element. */
+    serial = avctx->frame_number == 1 || !s->nb_thread_ctx || s->options.pred;
 
-            for (k = 0; k < 1024; k++) {
-                if (!(fabs(cpe->ch[ch].coeffs[k]) < 1E16)) { // Ensure headroom for energy calculation
-                    av_log(avctx, AV_LOG_ERROR, "Input contains (near) NaN/+-Inf\n");
-                    return AVERROR(EINVAL);
-                }
-            }
-            avoid_clipping(s, sce);
-        }
-        start_ch += chans;
-    }
     if ((ret = ff_alloc_packet2(avctx, avpkt, 8192 * s->channels, 0)) < 0)
         return ret;
     frame_bits = its = 0;
@@ -686,11 +876,10 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
 
         if ((avctx->frame_number & 0xFF)==1 && !(avctx->flags & AV_CODEC_FLAG_BITEXACT))
             put_bitstream_info(s, LIBAVCODEC_IDENT);
-        start_ch = 0;
         target_bits = 0;
-        memset(chan_el_counter, 0, sizeof(chan_el_counter));
+        jobs.bitres_bits = s->last_frame_pb_count / s->channels;
         for (i = 0; i < s->chan_map[0]; i++) {
-            FFPsyWindowInfo* wi = windows + start_ch;
+            FFPsyWindowInfo* wi = jobs.windows + jobs.start_ch[i];
             const float *coeffs[2];
             tag      = s->chan_map[i+1];
             chans    = tag == TYPE_CPE ? 2 : 1;
@@ -698,8 +887,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
             cpe->common_window = 0;
             memset(cpe->is_mask, 0, sizeof(cpe->is_mask));
             memset(cpe->ms_mask, 0, sizeof(cpe->ms_mask));
-            put_bits(&s->pb, 3, tag);
-            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             for (ch = 0; ch < chans; ch++) {
                 sce = &cpe->ch[ch];
                 coeffs[ch] = sce->coeffs;
@@ -713,90 +900,44 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                         sce->band_type[w] = 0;
             }
             s->psy.bitres.alloc = -1;
-            s->psy.bitres.bits = s->last_frame_pb_count / s->channels;
-            s->psy.model->analyze(&s->psy, start_ch, coeffs, wi);
+            s->psy.bitres.bits = jobs.bitres_bits;
+            s->psy.model->analyze(&s->psy, jobs.start_ch[i], coeffs, wi);
             if (s->psy.bitres.alloc > 0) {
                 /* Lambda unused here on purpose, we need to take psy's unscaled allocation */
                 target_bits += s->psy.bitres.alloc
                     * (s->lambda / (avctx->global_quality ? avctx->global_quality : 120));
                 s->psy.bitres.alloc /= chans;
             }
-            s->cur_type = tag;
-            for (ch = 0; ch < chans; ch++) {
-                s->cur_channel = start_ch + ch;
-                if (s->options.pns && s->coder->mark_pns)
-                    s->coder->mark_pns(s, avctx, &cpe->ch[ch]);
-                s->coder->search_for_quantizers(avctx, s, &cpe->ch[ch], s->lambda);
-            }
-            if (chans > 1
-                && wi[0].window_type[0] == wi[1].window_type[0]
-                && wi[0].window_shape   == wi[1].window_shape) {
-
-                cpe->common_window = 1;
-                for (w = 0; w < wi[0].num_windows; w++) {
-                    if (wi[0].grouping[w] != wi[1].grouping[w]) {
-                        cpe->common_window = 0;
-                        break;
-                    }
-                }
-            }
-            for (ch = 0; ch < chans; ch++) { /* TNS and PNS */
-                sce = &cpe->ch[ch];
-                s->cur_channel = start_ch + ch;
-                if (s->options.tns && s->coder->search_for_tns)
-                    s->coder->search_for_tns(s, sce);
-                if (s->options.tns && s->coder->apply_tns_filt)
-                    s->coder->apply_tns_filt(s, sce);
-                if (sce->tns.present)
-                    tns_mode = 1;
-                if (s->options.pns && s->coder->search_for_pns)
-                    s->coder->search_for_pns(s, avctx, sce);
-            }
-            s->cur_channel = start_ch;
-            if (s->options.intensity_stereo) { /* Intensity Stereo */
-                if (s->coder->search_for_is)
-                    s->coder->search_for_is(s, avctx, cpe);
-                if (cpe->is_mode) is_mode = 1;
-                apply_intensity_stereo(cpe);
-            }
-            if (s->options.pred) { /* Prediction */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->search_for_pred)
-                        s->coder->search_for_pred(s, sce);
-                    if (cpe->ch[ch].ics.predictor_present) pred_mode = 1;
-                }
-                if (s->coder->adjust_common_pred)
-                    s->coder->adjust_common_pred(s, cpe);
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->options.pred && s->coder->apply_main_pred)
-                        s->coder->apply_main_pred(s, sce);
-                }
-                s->cur_channel = start_ch;
-            }
-            if (s->options.mid_side) { /* Mid/Side stereo */
-                if (s->options.mid_side == -1 && s->coder->search_for_ms)
-                    s->coder->search_for_ms(s, cpe);
-                else if (cpe->common_window)
-                    memset(cpe->ms_mask, 1, sizeof(cpe->ms_mask));
-                apply_mid_side_stereo(cpe);
-            }
-            adjust_frame_information(cpe, chans);
-            if (s->options.ltp) { /* LTP */
-                for (ch = 0; ch < chans; ch++) {
-                    sce = &cpe->ch[ch];
-                    s->cur_channel = start_ch + ch;
-                    if (s->coder->search_for_ltp)
-                        s->coder->search_for_ltp(s, sce, cpe->common_window);
-                    if (sce->ics.ltp.present) pred_mode = 1;
-                }
-                s->cur_channel = start_ch;
-                if (s->coder->adjust_common_ltp)
-                    s->coder->adjust_common_ltp(s, cpe);
+            jobs.bitres_alloc[i] = s->psy.bitres.alloc;
+            if (serial) {
+                encode_element_search(avctx, &jobs, i, 0);
+                encode_element_pns(avctx, s, &jobs, i);
+                encode_element_stereo(avctx, &jobs, i, 0);
             }
+        }
+
+        for (i = 0; i < s->nb_thread_ctx; i++)
+            s->thread_ctx[i]->lambda = s->lambda;
+
+        if (!serial) {
+            avctx->execute2(avctx, encode_element_search, &jobs, NULL, s->chan_map[0]);
+            /* PNS draws from a single random sequence, so it runs in order */
+            for (i = 0; i < s->chan_map[0]; i++)
+                encode_element_pns(avctx, s, &jobs, i);
+            avctx->execute2(avctx, encode_element_stereo, &jobs, NULL, s->chan_map[0]);
+        }
+
+        memset(chan_el_counter, 0, sizeof(chan_el_counter));
+        for (i = 0; i < s->chan_map[0]; i++) {
+            tag      = s->chan_map[i+1];
+            chans    = tag == TYPE_CPE ? 2 : 1;
+            cpe      = &s->cpe[i];
+            start_ch = jobs.start_ch[i];
+            tns_mode  |= jobs.tns_mode[i];
+            is_mode   |= jobs.is_mode[i];
+            pred_mode |= jobs.pred_mode[i];
+            put_bits(&s->pb, 3, tag);
+            put_bits(&s->pb, 4, chan_el_counter[tag]++);
             if (chans == 2) {
                 put_bits(&s->pb, 1, cpe->common_window);
                 if (cpe->common_window) {
@@ -813,7 +954,6 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                 s->cur_channel = start_ch + ch;
                 encode_individual_channel(avctx, s, &cpe->ch[ch], cpe->common_window);
             }
-            start_ch += chans;
         }
 
         if (avctx->flags & AV_CODEC_FLAG_QSCALE) {
@@ -896,6 +1036,59 @@ static int aac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
     return 0;
 }
 
+static av_cold void free_thread_contexts(AACEncContext *s)
+{
+    int i;
+
+    for (i = 0; i < s->nb_thread_ctx; i++) {
+        ff_mdct_end(&s->thread_ctx[i]->mdct1024);
+        ff_mdct_end(&s->thread_ctx[i]->mdct128);
+        ff_lpc_end(&s->thread_ctx[i]->lpc);
+        av_freep(&s->thread_ctx[i]);
+    }
+    av_freep(&s->thread_ctx);
+    s->nb_thread_ctx = 0;
+}
+
+/**
+ * Create one context for each additional slice thread. The contexts share
+ * the channel elements, sample buffers and psy model of the main context and
+ * only have their own transforms and scratch buffers.
+ */
+static av_cold int alloc_thread_contexts(AVCodecContext *avctx, AACEncContext *s)
+{
+    int i, ret, nb_threads = FFMIN(avctx->thread_count, s->chan_map[0]);
+
+    if (!(avctx->active_thread_type & FF_THREAD_SLICE) || nb_threads <= 1)
+        return 0;
+
+    s->thread_ctx = av_mallocz_array(nb_threads - 1, sizeof(*s->thread_ctx));
+    if (!s->thread_ctx)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < nb_threads - 1; i++) {
+        AACEncContext *t = av_memdup(s, sizeof(*s));
+        if (!t)
+            return AVERROR(ENOMEM);
+        memset(&t->mdct1024, 0, sizeof(t->mdct1024));
+        memset(&t->mdct128,  0, sizeof(t->mdct128));
+        memset(&t->lpc,      0, sizeof(t->lpc));
+        t->thread_ctx    = NULL;
+        t->nb_thread_ctx = 0;
+        s->thread_ctx[s->nb_thread_ctx++] = t;
+
+        if ((ret = ff_mdct_init(&t->mdct1024, 11, 0, 32768.0)) < 0)
+            return ret;
+        if ((ret = ff_mdct_init(&t->mdct128,   8, 0, 32768.0)) < 0)
+            return ret;
+        if ((ret = ff_lpc_init(&t->lpc, 2*avctx->frame_size, TNS_MAX_ORDER,
+                               FF_LPC_TYPE_LEVINSON)) < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
 static av_cold int aac_encode_end(AVCodecContext *avctx)
 {
     AACEncContext *s = avctx->priv_data;
@@ -906,6 +1099,7 @@ static av_cold int aac_encode_end(AVCodecContext *avctx)
     ff_mdct_end(&s->mdct128);
     ff_psy_end(&s->psy);
     ff_lpc_end(&s->lpc);
+    free_thread_contexts(s);
     if (s->psypp)
         ff_psy_preprocess_end(s->psypp);
     av_freep(&s->buffer.samples);
@@ -1112,6 +1306,9 @@ static av_cold int aac_encode_init(AVCodecContext *avctx)
 
     ff_af_queue_init(avctx, &s->afq);
 
+    if ((ret = alloc_thread_contexts(avctx, s)) < 0)
+        goto fail;
+
     return 0;
 fail:
     aac_encode_end(avctx);
@@ -1158,7 +1355,8 @@ AVCodec ff_aac_encoder = {
     .defaults       = aac_encode_defaults,
     .supported_samplerates = mpeg4audio_sample_rates,
     .caps_internal  = FF_CODEC_CAP_INIT_THREADSAFE,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_FLTP,
                                                      AV_SAMPLE_FMT_NONE },
     .priv_class     = &aacenc_class,
@@ -418,6 +418,9 @@ typedef struct AACEncContext {
     struct {
         float *samples;
     } buffer;
+
+    struct AACEncContext **thread_ctx;           ///< contexts of the additional slice threads
+    int nb_thread_ctx;
 } AACEncContext;
 
 void ff_aac_dsp_init_x86(AACEncContext *s);
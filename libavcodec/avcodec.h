@@ -2805,6 +2805,7 @@ typedef struct AVCodecContext {
     int thread_type;
 #define FF_THREAD_FRAME   1 ///< Decode more than one frame at once
 #define FF_THREAD_SLICE   2 ///< Decode more than one part of a single frame at once
+#define FF_THREAD_LATENCY_BUCKETS 24 ///< Number of entries in thread_latency_histogram
 
     /**
      * Which multithreading methods are in use by the codec.
@@ -3330,6 +3331,17 @@ typedef struct AVCodecContext {
      * used as reference pictures).
      */
     int extra_hw_frames;
+
+    /**
+     * Video decoding only. Histogram of the time frames spend in the frame
+     * threading pipeline, from their packet being submitted to the frame
+     * being returned. Entry i counts the frames that took less than 2^i
+     * microseconds, but not less than 2^(i-1); the last entry also counts
+     * all slower frames.
+     * - encoding: unused
+     * - decoding: Set by libavcodec.
+     */
+    uint64_t thread_latency_histogram[FF_THREAD_LATENCY_BUCKETS];
 } AVCodecContext;
 
 #if FF_API_CODEC_GET_SET
@@ -5048,6 +5060,81 @@ int avcodec_get_hw_frames_parameters(AVCodecContext *avctx,
                                      enum AVPixelFormat hw_pix_fmt,
                                      AVBufferRef **out_frames_ref);
 
+/**
+ * A decoder whose output is delivered to several consumers.
+ *
+ * Every packet is decoded once, and each consumer receives its own reference
+ * to every decoded frame. The consumers share the frame data, which returns to
+ * the decoder buffer pool once the last consumer unreferences it.
+ *
+ * Packets must be sent from one thread at a time, but each consumer may
+ * receive its frames from a different thread.
+ *
+ * Since frames are only released once every consumer is done with them, a
+ * decoder with a fixed size pool of hardware surfaces needs
+ * AVCodecContext.extra_hw_frames to cover the frames queued for and held by
+ * the consumers.
+ */
+typedef struct AVSharedDecoder AVSharedDecoder;
+
+/**
+ * Allocate a shared decoder.
+ *
+ * @param psd          set to the new shared decoder on success
+ * @param avctx        an opened decoder context; it must not be used directly
+ *                     until the shared decoder is freed, and it is not freed
+ *                     together with it
+ * @param nb_consumers number of consumers, numbered from 0
+ * @param max_queued   maximum number of frames waiting for a single consumer
+ *                     before av_shared_decoder_send_packet() stops accepting
+ *                     packets, or 0 for no limit. This is checked before a
+ *                     packet is decoded, so a packet producing several
+ *                     frames, or flushing the decoder, can queue more.
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_shared_decoder_alloc(AVSharedDecoder **psd, AVCodecContext *avctx,
+                            int nb_consumers, int max_queued);
+
+/**
+ * Decode a packet and queue the resulting frames for all consumers.
+ *
+ * @param pkt the packet to decode, or NULL to flush the decoder
+ * @return 0 on success, otherwise negative error code:
+ *      AVERROR(EAGAIN):   a consumer has max_queued frames waiting, the packet
+ *                         must be resent once it received some of them
+ *      AVERROR_EOF:       the decoder has been flushed
+ *      other errors:      as returned by avcodec_send_packet() and
+ *                         avcodec_receive_frame()
+ */
+int av_shared_decoder_send_packet(AVSharedDecoder *sd, const AVPacket *pkt);
+
+/**
+ * Return the next frame for the given consumer.
+ *
+ * @param consumer index of the consumer, less than nb_consumers
+ * @param frame    set to a new reference to the decoded frame
+ * @return
+ *      0:                 success, a frame was returned
+ *      AVERROR(EAGAIN):   no frame is queued for this consumer, more packets
+ *                         must be sent
+ *      AVERROR_EOF:       the decoder has been flushed and this consumer
+ *                         received all its frames
+ */
+int av_shared_decoder_receive_frame(AVSharedDecoder *sd, int consumer,
+                                    AVFrame *frame);
+
+/**
+ * Drop all queued frames and reset the decoder, e.g. after seeking.
+ */
+void av_shared_decoder_flush(AVSharedDecoder *sd);
+
+/**
+ * Free a shared decoder and the frames still queued in it, and set *psd to
+ * NULL. The decoder context passed to av_shared_decoder_alloc() must be freed
+ * separately.
+ */
+void av_shared_decoder_free(AVSharedDecoder **psd);
+
 
 
 /**
@@ -174,6 +174,71 @@ static av_always_inline int get_cabac_bypass_sign(CABACContext *c, int val){
 }
 #endif
 
+/* Number of bypass bins which can be decoded before low must be refilled. */
+static av_always_inline int cabac_bins_left(CABACContext *c)
+{
+    return CABAC_BITS - ff_ctz(c->low);
+}
+
+#ifndef get_cabac_bypass_bits
+/**
+ * Decode n bypass bins as an unsigned value, first bin in the most significant
+ * bit. The need for a refill is checked once per group of bins, not per bin.
+ * @param n number of bins, at most 32
+ */
+static av_always_inline unsigned get_cabac_bypass_bits(CABACContext *c, int n)
+{
+    const int range = c->range << (CABAC_BITS + 1);
+    unsigned val = 0;
+
+    while (n > 0) {
+        int k = FFMIN(n, cabac_bins_left(c));
+
+        n -= k;
+        while (k--) {
+            int mask;
+            c->low += c->low;
+            mask    = (range - 1 - c->low) >> 31;
+            c->low -= range & mask;
+            val     = 2 * val - mask;
+        }
+        if (!(c->low & CABAC_MASK))
+            refill(c);
+    }
+    return val;
+}
+#endif
+
+#ifndef get_cabac_bypass_unary
+/**
+ * Decode bypass bins until a 0 bin or at most max bins.
+ * @return the number of 1 bins
+ */
+static av_always_inline int get_cabac_bypass_unary(CABACContext *c, int max)
+{
+    const int range = c->range << (CABAC_BITS + 1);
+    int count = 0;
+
+    while (count < max) {
+        int k = FFMIN(max - count, cabac_bins_left(c));
+
+        while (k--) {
+            c->low += c->low;
+            if (c->low < range) {
+                if (!(c->low & CABAC_MASK))
+                    refill(c);
+                return count;
+            }
+            c->low -= range;
+            count++;
+        }
+        if (!(c->low & CABAC_MASK))
+            refill(c);
+    }
+    return count;
+}
+#endif
+
 /**
  * @return the number of bytes read or 0 if no end
  */
@@ -126,6 +126,16 @@ typedef struct FlacEncodeContext {
 
     int flushed;
     int64_t next_pts;
+
+    /* frame batching for slice threads */
+    struct FlacEncodeContext **thread_ctx;
+    int nb_thread_ctx;
+    AVFrame **frame_queue;  ///< input frames waiting for the next batch
+    AVPacket **pkt_queue;   ///< encoded packets waiting to be returned
+    int *job_ret;
+    int nb_queued_frames;
+    int nb_queued_pkts;
+    int next_pkt;
 } FlacEncodeContext;
 
 
@@ -236,6 +246,73 @@ static av_cold void dprint_compression_options(FlacEncodeContext *s)
 }
 
 
+static av_cold void free_thread_contexts(FlacEncodeContext *s)
+{
+    int i;
+
+    for (i = 0; i < s->nb_thread_ctx; i++) {
+        ff_lpc_end(&s->thread_ctx[i]->lpc_ctx);
+        av_freep(&s->thread_ctx[i]);
+        av_frame_free(&s->frame_queue[i]);
+        av_packet_free(&s->pkt_queue[i]);
+    }
+    av_freep(&s->thread_ctx);
+    av_freep(&s->frame_queue);
+    av_freep(&s->pkt_queue);
+    av_freep(&s->job_ret);
+    s->nb_thread_ctx = 0;
+}
+
+
+/**
+ * Allocate the state needed to encode a batch of frames in parallel.
+ * Every thread gets its own copy of the encoder context, so that frames can
+ * be analyzed and written without touching the shared MD5 and counters.
+ */
+static av_cold int alloc_thread_contexts(AVCodecContext *avctx,
+                                         FlacEncodeContext *s)
+{
+    int i, ret, nb_threads = avctx->thread_count;
+
+    if (!(avctx->active_thread_type & FF_THREAD_SLICE) || nb_threads <= 1)
+        return 0;
+
+    s->thread_ctx  = av_mallocz_array(nb_threads, sizeof(*s->thread_ctx));
+    s->frame_queue = av_mallocz_array(nb_threads, sizeof(*s->frame_queue));
+    s->pkt_queue   = av_mallocz_array(nb_threads, sizeof(*s->pkt_queue));
+    s->job_ret     = av_mallocz_array(nb_threads, sizeof(*s->job_ret));
+    if (!s->thread_ctx || !s->frame_queue || !s->pkt_queue || !s->job_ret)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < nb_threads; i++) {
+        FlacEncodeContext *t = av_memdup(s, sizeof(*s));
+        if (!t)
+            return AVERROR(ENOMEM);
+        memset(&t->lpc_ctx, 0, sizeof(t->lpc_ctx));
+        t->md5ctx        = NULL;
+        t->md5_buffer    = NULL;
+        t->thread_ctx    = NULL;
+        t->nb_thread_ctx = 0;
+        t->frame_queue   = NULL;
+        t->pkt_queue     = NULL;
+        t->job_ret       = NULL;
+        s->thread_ctx[s->nb_thread_ctx++] = t;
+
+        if ((ret = ff_lpc_init(&t->lpc_ctx, avctx->frame_size,
+                               s->options.max_prediction_order,
+                               FF_LPC_TYPE_LEVINSON)) < 0)
+            return ret;
+
+        s->frame_queue[i] = av_frame_alloc();
+        s->pkt_queue[i]   = av_packet_alloc();
+        if (!s->frame_queue[i] || !s->pkt_queue[i])
+            return AVERROR(ENOMEM);
+    }
+
+    return 0;
+}
+
+
 static av_cold int flac_encode_init(AVCodecContext *avctx)
 {
     int freq = avctx->sample_rate;
@@ -463,6 +540,11 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
     dprint_compression_options(s);
 
+    if (ret < 0)
+        return ret;
+
+    if ((ret = alloc_thread_contexts(avctx, s)) < 0)
+        free_thread_contexts(s);
     return ret;
 }
 
@@ -1320,10 +1402,11 @@ static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
 }
 
 
-static int update_md5_sum(FlacEncodeContext *s, const void *samples)
+static int update_md5_sum(FlacEncodeContext *s, const AVFrame *frame)
 {
+    const void *samples = frame->data[0];
     const uint8_t *buf;
-    int buf_size = s->frame.blocksize * s->channels *
+    int buf_size = frame->nb_samples * s->channels *
                    ((s->avctx->bits_per_raw_sample + 7) / 8);
 
     if (s->avctx->bits_per_raw_sample > 16 || HAVE_BIGENDIAN) {
@@ -1344,7 +1427,7 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
         const int32_t *samples0 = samples;
         uint8_t *tmp            = s->md5_buffer;
 
-        for (i = 0; i < s->frame.blocksize * s->channels; i++) {
+        for (i = 0; i < frame->nb_samples * s->channels; i++) {
             int32_t v = samples0[i] >> 8;
             AV_WL24(tmp + 3*i, v);
         }
@@ -1356,6 +1439,129 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 }
 
 
+/**
+ * Analyze one block of input samples.
+ * @return the size of the frame that write_frame() will produce
+ */
+static int encode_block(FlacEncodeContext *s, const AVFrame *frame)
+{
+    int frame_bytes;
+
+    /* change max_framesize for small final frame */
+    if (frame->nb_samples < s->max_blocksize) {
+        s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
+                                                      s->channels,
+                                                      s->avctx->bits_per_raw_sample);
+    }
+
+    init_frame(s, frame->nb_samples);
+
+    copy_samples(s, frame->data[0]);
+
+    channel_decorrelation(s);
+
+    remove_wasted_bits(s);
+
+    frame_bytes = encode_frame(s);
+
+    /* Fall back on verbatim mode if the compressed frame is larger than it
+       would be if encoded uncompressed. */
+    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
+        s->frame.verbatim_only = 1;
+        frame_bytes = encode_frame(s);
+        if (frame_bytes < 0) {
+            av_log(s->avctx, AV_LOG_ERROR, "Bad frame count\n");
+            return frame_bytes;
+        }
+    }
+
+    return frame_bytes;
+}
+
+
+/**
+ * Update the stream state with a frame that has been written to avpkt.
+ * Must be called in coding order.
+ */
+static int finish_frame(FlacEncodeContext *s, const AVFrame *frame,
+                        AVPacket *avpkt, int out_bytes)
+{
+    AVCodecContext *avctx = s->avctx;
+    int ret;
+
+    s->frame_count++;
+    s->sample_count += frame->nb_samples;
+    if ((ret = update_md5_sum(s, frame)) < 0) {
+        av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+        return ret;
+    }
+    if (out_bytes > s->max_encoded_framesize)
+        s->max_encoded_framesize = out_bytes;
+    if (out_bytes < s->min_framesize)
+        s->min_framesize = out_bytes;
+
+    avpkt->pts      = frame->pts;
+    avpkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
+    avpkt->size     = out_bytes;
+
+    return 0;
+}
+
+
+static int encode_frame_job(AVCodecContext *avctx, void *arg,
+                            int jobnr, int threadnr)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacEncodeContext *t = s->thread_ctx[threadnr];
+    AVPacket *pkt        = s->pkt_queue[jobnr];
+    int frame_bytes, ret;
+
+    t->frame_count = s->frame_count + jobnr;
+
+    frame_bytes = encode_block(t, s->frame_queue[jobnr]);
+    if (frame_bytes < 0)
+        return frame_bytes;
+
+    if ((ret = av_new_packet(pkt, frame_bytes)) < 0)
+        return ret;
+    pkt->size = write_frame(t, pkt);
+
+    return 0;
+}
+
+
+/**
+ * Encode all queued frames in parallel, one frame per job, then account
+ * for them in coding order so that the output matches the serial encoder.
+ */
+static int encode_frame_queue(AVCodecContext *avctx)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    int i, err = 0;
+
+    avctx->execute2(avctx, encode_frame_job, NULL, s->job_ret,
+                    s->nb_queued_frames);
+
+    for (i = 0; i < s->nb_queued_frames; i++) {
+        AVFrame *frame = s->frame_queue[i];
+        AVPacket *pkt  = s->pkt_queue[i];
+
+        if (!err && s->job_ret[i] < 0)
+            err = s->job_ret[i];
+        if (!err)
+            err = finish_frame(s, frame, pkt, pkt->size);
+        if (err < 0)
+            av_packet_unref(pkt);
+        av_frame_unref(frame);
+    }
+    s->nb_queued_pkts   = err < 0 ? 0 : s->nb_queued_frames;
+    s->nb_queued_frames = 0;
+    s->next_pkt         = 0;
+
+    return err;
+}
+
+
 static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                              const AVFrame *frame, int *got_packet_ptr)
 {
@@ -1364,6 +1570,33 @@ static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
 
     s = avctx->priv_data;
 
+    if (s->nb_thread_ctx) {
+        /* Frames are collected until there is one per thread; the packets
+           of the previous batch are returned one per call meanwhile. */
+        if (frame) {
+            ret = av_frame_ref(s->frame_queue[s->nb_queued_frames], frame);
+            if (ret < 0)
+                return ret;
+            s->nb_queued_frames++;
+        }
+
+        if (s->next_pkt == s->nb_queued_pkts && s->nb_queued_frames &&
+            (!frame || s->nb_queued_frames == s->nb_thread_ctx)) {
+            if ((ret = encode_frame_queue(avctx)) < 0)
+                return ret;
+        }
+
+        if (s->next_pkt < s->nb_queued_pkts) {
+            av_packet_move_ref(avpkt, s->pkt_queue[s->next_pkt++]);
+            s->next_pts = avpkt->pts + avpkt->duration;
+            *got_packet_ptr = 1;
+            return 0;
+        }
+
+        if (frame)
+            return 0;
+    }
+
     /* when the last block is reached, update the header in extradata */
     if (!frame) {
         s->max_framesize = s->max_encoded_framesize;
@@ -1392,53 +1625,17 @@ FF_ENABLE_DEPRECATION_WARNINGS
         return 0;
     }
 
-    /* change max_framesize for small final frame */
-    if (frame->nb_samples < s->frame.blocksize) {
-        s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
-                                                      s->channels,
-                                                      avctx->bits_per_raw_sample);
-    }
-
-    init_frame(s, frame->nb_samples);
-
-    copy_samples(s, frame->data[0]);
-
-    channel_decorrelation(s);
-
-    remove_wasted_bits(s);
-
-    frame_bytes = encode_frame(s);
-
-    /* Fall back on verbatim mode if the compressed frame is larger than it
-       would be if encoded uncompressed. */
-    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
-        s->frame.verbatim_only = 1;
-        frame_bytes = encode_frame(s);
-        if (frame_bytes < 0) {
-            av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
-            return frame_bytes;
-        }
-    }
+    frame_bytes = encode_block(s, frame);
+    if (frame_bytes < 0)
+        return frame_bytes;
 
     if ((ret = ff_alloc_packet2(avctx, avpkt, frame_bytes, 0)) < 0)
         return ret;
 
     out_bytes = write_frame(s, avpkt);
 
-    s->frame_count++;
-    s->sample_count += frame->nb_samples;
-    if ((ret = update_md5_sum(s, frame->data[0])) < 0) {
-        av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+    if ((ret = finish_frame(s, frame, avpkt, out_bytes)) < 0)
         return ret;
-    }
-    if (out_bytes > s->max_encoded_framesize)
-        s->max_encoded_framesize = out_bytes;
-    if (out_bytes < s->min_framesize)
-        s->min_framesize = out_bytes;
-
-    avpkt->pts      = frame->pts;
-    avpkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
-    avpkt->size     = out_bytes;
 
     s->next_pts = avpkt->pts + avpkt->duration;
 
@@ -1454,6 +1651,7 @@ static av_cold int flac_encode_close(AVCodecContext *avctx)
         av_freep(&s->md5ctx);
         av_freep(&s->md5_buffer);
         ff_lpc_end(&s->lpc_ctx);
+        free_thread_contexts(s);
     }
     av_freep(&avctx->extradata);
     avctx->extradata_size = 0;
@@ -1508,7 +1706,8 @@ AVCodec ff_flac_encoder = {
     .init           = flac_encode_init,
     .encode2        = flac_encode_frame,
     .close          = flac_encode_close,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_LOSSLESS,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_LOSSLESS |
+                      AV_CODEC_CAP_SLICE_THREADS,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_S16,
                                                      AV_SAMPLE_FMT_S32,
                                                      AV_SAMPLE_FMT_NONE },
@@ -1734,16 +1734,10 @@ decode_cabac_residual_internal(const H264Context *h, H264SliceContext *sl,
             } \
 \
             if( coeff_abs >= 15 ) { \
-                int j = 0; \
-                while (get_cabac_bypass(CC) && j < 16+7) { \
-                    j++; \
-                } \
-\
-                coeff_abs=1; \
-                while( j-- ) { \
-                    coeff_abs += coeff_abs + get_cabac_bypass( CC ); \
-                } \
-                coeff_abs+= 14U; \
+                /* a prefix of 24 ones is read entirely but clipped to 23 */ \
+                int j = get_cabac_bypass_unary(CC, 16+8); \
+                j = FFMIN(j, 16+7); \
+                coeff_abs = (1U << j) + get_cabac_bypass_bits(CC, j) + 14U; \
             } \
 \
             if( is_dc ) { \
@@ -711,8 +711,7 @@ static int boundary_strength(HEVCContext *s, MvField *curr, MvField *neigh,
     return 1;
 }
 
-void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
-                                           int log2_trafo_size)
+static void upper_edge_strengths(HEVCContext *s, int x0, int y0, int size)
 {
     HEVCLocalContext *lc = s->HEVClc;
     MvField *tab_mvf     = s->ref->tab_mvf;
@@ -720,10 +719,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
     int log2_min_tu_size = s->ps.sps->log2_min_tb_size;
     int min_pu_width     = s->ps.sps->min_pu_width;
     int min_tu_width     = s->ps.sps->min_tb_width;
-    int is_intra = tab_mvf[(y0 >> log2_min_pu_size) * min_pu_width +
-                           (x0 >> log2_min_pu_size)].pred_flag == PF_INTRA;
-    int boundary_upper, boundary_left;
-    int i, j, bs;
+    int boundary_upper, i, bs;
 
     boundary_upper = y0 > 0 && !(y0 & 7);
     if (boundary_upper &&
@@ -744,7 +740,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         int yp_tu = (y0 - 1) >> log2_min_tu_size;
         int yq_tu =  y0      >> log2_min_tu_size;
 
-            for (i = 0; i < (1 << log2_trafo_size); i += 4) {
+            for (i = 0; i < size; i += 4) {
                 int x_pu = (x0 + i) >> log2_min_pu_size;
                 int x_tu = (x0 + i) >> log2_min_tu_size;
                 MvField *top  = &tab_mvf[yp_pu * min_pu_width + x_pu];
@@ -761,8 +757,18 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                 s->horizontal_bs[((x0 + i) + y0 * s->bs_width) >> 2] = bs;
             }
     }
+}
+
+static void left_edge_strengths(HEVCContext *s, int x0, int y0, int size)
+{
+    HEVCLocalContext *lc = s->HEVClc;
+    MvField *tab_mvf     = s->ref->tab_mvf;
+    int log2_min_pu_size = s->ps.sps->log2_min_pu_size;
+    int log2_min_tu_size = s->ps.sps->log2_min_tb_size;
+    int min_pu_width     = s->ps.sps->min_pu_width;
+    int min_tu_width     = s->ps.sps->min_tb_width;
+    int boundary_left, i, bs;
 
-    // bs for vertical TU boundaries
     boundary_left = x0 > 0 && !(x0 & 7);
     if (boundary_left &&
         ((!s->sh.slice_loop_filter_across_slices_enabled_flag &&
@@ -782,7 +788,7 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
         int xp_tu = (x0 - 1) >> log2_min_tu_size;
         int xq_tu =  x0      >> log2_min_tu_size;
 
-            for (i = 0; i < (1 << log2_trafo_size); i += 4) {
+            for (i = 0; i < size; i += 4) {
                 int y_pu      = (y0 + i) >> log2_min_pu_size;
                 int y_tu      = (y0 + i) >> log2_min_tu_size;
                 MvField *left = &tab_mvf[y_pu * min_pu_width + xp_pu];
@@ -799,6 +805,31 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                 s->vertical_bs[(x0 + (y0 + i) * s->bs_width) >> 2] = bs;
             }
     }
+}
+
+void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
+                                           int log2_trafo_size)
+{
+    HEVCLocalContext *lc = s->HEVClc;
+    MvField *tab_mvf     = s->ref->tab_mvf;
+    int log2_min_pu_size = s->ps.sps->log2_min_pu_size;
+    int min_pu_width     = s->ps.sps->min_pu_width;
+    int ctb_mask         = (1 << s->ps.sps->log2_ctb_size) - 1;
+    int is_intra = tab_mvf[(y0 >> log2_min_pu_size) * min_pu_width +
+                           (x0 >> log2_min_pu_size)].pred_flag == PF_INTRA;
+    int i, j, bs;
+
+    /* Edges on a tile boundary read the neighbouring tile, which may still be
+     * decoding in another thread. They are computed once all tiles are done,
+     * see ff_hevc_deblocking_tile_strengths(). */
+    if (!(s->enable_parallel_tiles && lc->boundary_flags & BOUNDARY_UPPER_TILE &&
+          !(y0 & ctb_mask)))
+        upper_edge_strengths(s, x0, y0, 1 << log2_trafo_size);
+
+    // bs for vertical TU boundaries
+    if (!(s->enable_parallel_tiles && lc->boundary_flags & BOUNDARY_LEFT_TILE &&
+          !(x0 & ctb_mask)))
+        left_edge_strengths(s, x0, y0, 1 << log2_trafo_size);
 
     if (log2_trafo_size > log2_min_pu_size && !is_intra) {
         RefPicList *rpl = s->ref->refPicList;
@@ -839,6 +870,19 @@ void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
 #undef CB
 #undef CR
 
+void ff_hevc_deblocking_tile_strengths(HEVCContext *s, int x_ctb, int y_ctb)
+{
+    HEVCLocalContext *lc = s->HEVClc;
+    int ctb_size = 1 << s->ps.sps->log2_ctb_size;
+
+    if (lc->boundary_flags & BOUNDARY_UPPER_TILE)
+        upper_edge_strengths(s, x_ctb, y_ctb,
+                             FFMIN(ctb_size, s->ps.sps->width - x_ctb));
+    if (lc->boundary_flags & BOUNDARY_LEFT_TILE)
+        left_edge_strengths(s, x_ctb, y_ctb,
+                            FFMIN(ctb_size, s->ps.sps->height - y_ctb));
+}
+
 void ff_hevc_hls_filter(HEVCContext *s, int x, int y, int ctb_size)
 {
     int x_end = x >= s->ps.sps->width  - ctb_size;
@@ -844,8 +844,13 @@ static int hls_slice_header(HEVCContext *s)
                 sh->entry_point_offset[i] = val + 1; // +1; // +1 to get the size
             }
             if (s->threads_number > 1 && (s->ps.pps->num_tile_rows > 1 || s->ps.pps->num_tile_columns > 1)) {
-                s->enable_parallel_tiles = 0; // TODO: you can enable tiles in parallel here
-                s->threads_number = 1;
+                if (!s->ps.pps->entropy_coding_sync_enabled_flag &&
+                    !sh->dependent_slice_segment_flag) {
+                    s->enable_parallel_tiles = 1;
+                } else {
+                    s->enable_parallel_tiles = 0;
+                    s->threads_number = 1;
+                }
             } else
                 s->enable_parallel_tiles = 0;
         } else
@@ -2336,7 +2341,10 @@ static void hls_decode_neighbour(HEVCContext *s, int x_ctb, int y_ctb,
     int ctb_addr_rs       = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
     int ctb_addr_in_slice = ctb_addr_rs - s->sh.slice_addr;
 
-    s->tab_slice_address[ctb_addr_rs] = s->sh.slice_addr;
+    /* filled in for the whole slice segment before parallel tile jobs start,
+     * as they read it across tile edges */
+    if (!s->enable_parallel_tiles)
+        s->tab_slice_address[ctb_addr_rs] = s->sh.slice_addr;
 
     if (s->ps.pps->entropy_coding_sync_enabled_flag) {
         if (x_ctb == 0 && (y_ctb & (ctb_size - 1)) == 0)
@@ -2530,6 +2538,110 @@ error:
     return ret;
 }
 
+static int hls_decode_entry_tile(AVCodecContext *avctxt, void *input_tile,
+                                 int job, int self_id)
+{
+    HEVCContext *s1  = avctxt->priv_data, *s;
+    HEVCLocalContext *lc;
+    int more_data    = 1;
+    int *thread_p    = input_tile;
+    int ctb_addr_ts  = s1->ps.pps->ctb_addr_rs_to_ts[s1->sh.slice_ctb_addr_rs];
+    int ctb_addr_rs  = s1->sh.slice_ctb_addr_rs;
+    int tile_id, ret;
+
+    s  = s1->sList[self_id];
+    lc = s->HEVClc;
+    thread_p[job] = self_id;
+
+    if (job) {
+        tile_id     = s->ps.pps->tile_id[ctb_addr_ts] + job;
+        ctb_addr_rs = s->ps.pps->tile_pos_rs[tile_id];
+        ctb_addr_ts = s->ps.pps->ctb_addr_rs_to_ts[ctb_addr_rs];
+        ret = init_get_bits8(&lc->gb, s->data + s->sh.offset[job - 1], s->sh.size[job - 1]);
+        if (ret < 0)
+            goto error;
+    } else if (lc != s1->HEVClc) {
+        lc->gb             = s1->HEVClc->gb;
+        lc->end_of_tiles_x = s1->HEVClc->end_of_tiles_x;
+    }
+    tile_id = s->ps.pps->tile_id[ctb_addr_ts];
+
+    while (more_data && ctb_addr_ts < s->ps.sps->ctb_size &&
+           s->ps.pps->tile_id[ctb_addr_ts] == tile_id) {
+        int x_ctb, y_ctb;
+
+        if (atomic_load(&s1->wpp_err))
+            return 0;
+
+        ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+        x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
+
+        ret = ff_hevc_cabac_init(s, ctb_addr_ts);
+        if (ret < 0)
+            goto error;
+
+        hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
+
+        s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
+        s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
+        s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+
+        more_data = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
+        if (more_data < 0) {
+            ret = more_data;
+            goto error;
+        }
+
+        ctb_addr_ts++;
+    }
+
+    /* only the last entry point may end the slice segment */
+    if (!more_data && job != s->sh.num_entry_point_offsets) {
+        ret = AVERROR_INVALIDDATA;
+        goto error;
+    }
+
+    return ctb_addr_ts;
+error:
+    atomic_store(&s1->wpp_err, 1);
+    return ret;
+}
+
+/**
+ * Run the in-loop filters over a slice segment whose tiles were decoded in
+ * parallel, issuing the same filter calls in the same order as
+ * hls_decode_entry() does while decoding sequentially.
+ */
+static int hls_filter_tiles(HEVCContext *s, int ctb_addr_end)
+{
+    int ctb_size    = 1 << s->ps.sps->log2_ctb_size;
+    int ctb_addr_ts = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+    int x_ctb       = 0;
+    int y_ctb       = 0;
+
+    s->enable_parallel_tiles = 0;
+
+    for (; ctb_addr_ts < ctb_addr_end; ctb_addr_ts++) {
+        int ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+
+        x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
+
+        if (!s->sh.disable_deblocking_filter_flag)
+            ff_hevc_deblocking_tile_strengths(s, x_ctb, y_ctb);
+        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+    }
+
+    if (x_ctb + ctb_size >= s->ps.sps->width &&
+        y_ctb + ctb_size >= s->ps.sps->height)
+        ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
+
+    return ctb_addr_end;
+}
+
 static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
 {
     const uint8_t *data = nal->data;
@@ -2547,7 +2659,15 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         return AVERROR(ENOMEM);
     }
 
-    if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * s->ps.sps->ctb_width >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
+    if (s->enable_parallel_tiles) {
+        int first_tile = s->ps.pps->tile_id[s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs]];
+        if (first_tile + s->sh.num_entry_point_offsets >= s->ps.pps->num_tile_columns * s->ps.pps->num_tile_rows) {
+            av_log(s->avctx, AV_LOG_ERROR, "Tile entry points are wrong (%d %d)\n",
+                   first_tile, s->sh.num_entry_point_offsets);
+            res = AVERROR_INVALIDDATA;
+            goto error;
+        }
+    } else if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * s->ps.sps->ctb_width >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
         av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
             s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
             s->ps.sps->ctb_width, s->ps.sps->ctb_height
@@ -2617,6 +2737,47 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         ret[i] = 0;
     }
 
+    if (s->enable_parallel_tiles) {
+        const HEVCPPS *pps = s->ps.pps;
+        int first_ts   = pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+        int first_tile = pps->tile_id[first_ts];
+        int last_tile  = first_tile + s->sh.num_entry_point_offsets;
+        int end_ts     = last_tile + 1 < pps->num_tile_columns * pps->num_tile_rows ?
+                         pps->ctb_addr_rs_to_ts[pps->tile_pos_rs[last_tile + 1]] :
+                         s->ps.sps->ctb_size;
+        HEVCLocalContext *last;
+
+        /* A slice segment spanning several tiles contains complete tiles.
+         * Fill in its slice address before the jobs start, so that they only
+         * read it when deriving the slice boundaries at the tile edges. */
+        for (j = first_ts; j < end_ts; j++)
+            s->tab_slice_address[pps->ctb_addr_ts_to_rs[j]] = s->sh.slice_addr;
+
+        s->avctx->execute2(s->avctx, hls_decode_entry_tile, arg, ret, s->sh.num_entry_point_offsets + 1);
+
+        for (i = 0; i <= s->sh.num_entry_point_offsets; i++) {
+            if (ret[i] < 0) {
+                s->tab_slice_address[i ? pps->tile_pos_rs[first_tile + i] :
+                                         s->sh.slice_ctb_addr_rs] = -1;
+                res = ret[i];
+                goto error;
+            }
+        }
+
+        /* the CTBs after the end of the slice segment were not decoded */
+        for (j = ret[s->sh.num_entry_point_offsets]; j < end_ts; j++)
+            s->tab_slice_address[pps->ctb_addr_ts_to_rs[j]] = -1;
+
+        /* continue from the state the last tile ended in, as a following
+         * dependent slice segment would when decoding sequentially */
+        last = s->HEVClcList[arg[s->sh.num_entry_point_offsets]];
+        if (last != s->HEVClc)
+            *s->HEVClc = *last;
+
+        res = hls_filter_tiles(s, ret[s->sh.num_entry_point_offsets]);
+        goto error;
+    }
+
     if (s->ps.pps->entropy_coding_sync_enabled_flag)
         s->avctx->execute2(s->avctx, hls_decode_entry_wpp, arg, ret, s->sh.num_entry_point_offsets + 1);
 
@@ -590,6 +590,12 @@ void ff_hevc_set_qPy(HEVCContext *s, int xBase, int yBase,
                      int log2_cb_size);
 void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                            int log2_trafo_size);
+/**
+ * Compute the boundary strengths of the tile edges of a CTB, which
+ * ff_hevc_deblocking_boundary_strengths() skips while tiles are decoded
+ * in parallel.
+ */
+void ff_hevc_deblocking_tile_strengths(HEVCContext *s, int x_ctb, int y_ctb);
 int ff_hevc_cu_qp_delta_sign_flag(HEVCContext *s);
 int ff_hevc_cu_qp_delta_abs(HEVCContext *s);
 int ff_hevc_cu_chroma_qp_offset_flag(HEVCContext *s);
@@ -88,11 +88,62 @@ static void sub_left_predict_c(uint8_t *dst, uint8_t *src,
     }
 }
 
+static void sub_png_avg_pred_c(uint8_t *dst, const uint8_t *src,
+                               const uint8_t *top, intptr_t w, int bpp)
+{
+    intptr_t i;
+
+    for (i = 0; i < w; i++)
+        dst[i] = src[i] - ((src[i - bpp] + top[i]) >> 1);
+}
+
+static void sub_png_paeth_pred_c(uint8_t *dst, const uint8_t *src,
+                                 const uint8_t *top, intptr_t w, int bpp)
+{
+    intptr_t i;
+
+    for (i = 0; i < w; i++) {
+        int a, b, c, p, pa, pb, pc;
+
+        a = src[i - bpp];
+        b = top[i];
+        c = top[i - bpp];
+
+        p  = b - c;
+        pc = a - c;
+
+        pa = abs(p);
+        pb = abs(pc);
+        pc = abs(p + pc);
+
+        if (pa <= pb && pa <= pc)
+            p = a;
+        else if (pb <= pc)
+            p = b;
+        else
+            p = c;
+        dst[i] = src[i] - p;
+    }
+}
+
+static int sum_abs_int8_c(const uint8_t *src, intptr_t w)
+{
+    intptr_t i;
+    int sum = 0;
+
+    for (i = 0; i < w; i++)
+        sum += abs((int8_t)src[i]);
+    return sum;
+}
+
 av_cold void ff_llvidencdsp_init(LLVidEncDSPContext *c)
 {
     c->diff_bytes      = diff_bytes_c;
     c->sub_median_pred = sub_median_pred_c;
     c->sub_left_predict = sub_left_predict_c;
+    c->sub_png_avg_pred   = sub_png_avg_pred_c;
+    c->sub_png_paeth_pred = sub_png_paeth_pred_c;
+    c->sum_abs_int8       = sum_abs_int8_c;
 
     if (ARCH_X86)
         ff_llvidencdsp_init_x86(c);
@@ -38,6 +38,26 @@ typedef struct LLVidEncDSPContext {
 
     void (*sub_left_predict)(uint8_t *dst, uint8_t *src,
                           ptrdiff_t stride, ptrdiff_t width, int height);
+
+    /**
+     * Subtract PNG's average prediction, (src[i - bpp] + top[i]) >> 1.
+     * Reads src[-bpp]. The SIMD versions require w to be a multiple of 16.
+     */
+    void (*sub_png_avg_pred)(uint8_t *dst, const uint8_t *src,
+                             const uint8_t *top, intptr_t w, int bpp);
+    /**
+     * Subtract PNG's Paeth prediction.
+     * Reads src[-bpp] and top[-bpp]. The SIMD versions require w to be a
+     * multiple of 16.
+     */
+    void (*sub_png_paeth_pred)(uint8_t *dst, const uint8_t *src,
+                               const uint8_t *top, intptr_t w, int bpp);
+    /**
+     * Sum of the absolute values of w signed bytes, used to compare
+     * prediction residuals. The SIMD versions require w to be a multiple
+     * of 16.
+     */
+    int (*sum_abs_int8)(const uint8_t *src, intptr_t w);
 } LLVidEncDSPContext;
 
 void ff_llvidencdsp_init(LLVidEncDSPContext *c);
@@ -63,13 +63,34 @@ static void lpc_apply_welch_window_c(const int32_t *data, int len,
 /**
  * Calculate autocorrelation data from audio samples
  * A Welch window function is applied before calculation.
+ * Four lags are accumulated per pass over the data; every lag still sums
+ * its products in the same order as when computed on its own.
  */
 static void lpc_compute_autocorr_c(const double *data, int len, int lag,
                                    double *autoc)
 {
     int i, j;
 
-    for(j=0; j<lag; j+=2){
+    for(j=0; j+3<=lag; j+=4){
+        double sum0 = 1.0, sum1 = 1.0, sum2 = 1.0, sum3 = 1.0;
+        for(i=j; i<j+2 && i<len; i++){
+            sum0 += data[i] * data[i-j];
+            sum1 += data[i] * data[i-j-1];
+        }
+        for(i=j+2; i<len; i++){
+            double d = data[i];
+            sum0 += d * data[i-j];
+            sum1 += d * data[i-j-1];
+            sum2 += d * data[i-j-2];
+            sum3 += d * data[i-j-3];
+        }
+        autoc[j  ] = sum0;
+        autoc[j+1] = sum1;
+        autoc[j+2] = sum2;
+        autoc[j+3] = sum3;
+    }
+
+    for(; j<lag; j+=2){
         double sum0 = 1.0, sum1 = 1.0;
         for(i=j; i<len; i++){
             sum0 += data[i] * data[i-j];
@@ -62,8 +62,10 @@ static int alloc_huffman(MpegEncContext *s)
     num_blocks = num_mbs * blocks_per_mb;
     num_codes = num_blocks * 64;
 
-    m->huff_buffer = av_malloc_array(num_codes, sizeof(MJpegHuffmanCode));
-    if (!m->huff_buffer)
+    m->huff_row_size = s->mb_width * blocks_per_mb * 64;
+    m->huff_buffer   = av_malloc_array(num_codes, sizeof(MJpegHuffmanCode));
+    m->huff_ncode    = av_mallocz_array(s->mb_height, sizeof(*m->huff_ncode));
+    if (!m->huff_buffer || !m->huff_ncode)
         return AVERROR(ENOMEM);
     return 0;
 }
@@ -113,8 +115,6 @@ av_cold int ff_mjpeg_encode_init(MpegEncContext *s)
     s->intra_chroma_ac_vlc_length      =
     s->intra_chroma_ac_vlc_last_length = m->uni_chroma_ac_vlc_len;
 
-    // Buffers start out empty.
-    m->huff_ncode = 0;
     s->mjpeg_ctx = m;
 
     if(s->huffman == HUFFMAN_TABLE_OPTIMAL)
@@ -126,19 +126,22 @@ av_cold int ff_mjpeg_encode_init(MpegEncContext *s)
 av_cold void ff_mjpeg_encode_close(MpegEncContext *s)
 {
     av_freep(&s->mjpeg_ctx->huff_buffer);
+    av_freep(&s->mjpeg_ctx->huff_ncode);
     av_freep(&s->mjpeg_ctx);
 }
 
 /**
  * Add code and table_id to the JPEG buffer.
  *
- * @param s The MJpegContext which contains the JPEG buffer.
+ * @param buf The JPEG buffer of the current macroblock row.
+ * @param ncode The number of entries in buf, incremented.
  * @param table_id Which Huffman table the code belongs to.
  * @param code The encoded exponent of the coefficients and the run-bits.
  */
-static inline void ff_mjpeg_encode_code(MJpegContext *s, uint8_t table_id, int code)
+static inline void ff_mjpeg_encode_code(MJpegHuffmanCode *buf, size_t *ncode,
+                                        uint8_t table_id, int code)
 {
-    MJpegHuffmanCode *c = &s->huff_buffer[s->huff_ncode++];
+    MJpegHuffmanCode *c = &buf[(*ncode)++];
     c->table_id = table_id;
     c->code = code;
 }
@@ -146,18 +149,20 @@ static inline void ff_mjpeg_encode_code(MJpegContext *s, uint8_t table_id, int c
 /**
  * Add the coefficient's data to the JPEG buffer.
  *
- * @param s The MJpegContext which contains the JPEG buffer.
+ * @param buf The JPEG buffer of the current macroblock row.
+ * @param ncode The number of entries in buf, incremented.
  * @param table_id Which Huffman table the code belongs to.
  * @param val The coefficient.
  * @param run The run-bits.
  */
-static void ff_mjpeg_encode_coef(MJpegContext *s, uint8_t table_id, int val, int run)
+static void ff_mjpeg_encode_coef(MJpegHuffmanCode *buf, size_t *ncode,
+                                 uint8_t table_id, int val, int run)
 {
     int mant, code;
 
     if (val == 0) {
         av_assert0(run == 0);
-        ff_mjpeg_encode_code(s, table_id, 0);
+        ff_mjpeg_encode_code(buf, ncode, table_id, 0);
     } else {
         mant = val;
         if (val < 0) {
@@ -167,8 +172,8 @@ static void ff_mjpeg_encode_coef(MJpegContext *s, uint8_t table_id, int val, int
 
         code = (run << 4) | (av_log2_16bit(val) + 1);
 
-        s->huff_buffer[s->huff_ncode].mant = mant;
-        ff_mjpeg_encode_code(s, table_id, code);
+        buf[*ncode].mant = mant;
+        ff_mjpeg_encode_code(buf, ncode, table_id, code);
     }
 }
 
@@ -184,6 +189,8 @@ static void record_block(MpegEncContext *s, int16_t *block, int n)
     int i, j, table_id;
     int component, dc, last_index, val, run;
     MJpegContext *m = s->mjpeg_ctx;
+    MJpegHuffmanCode *buf = m->huff_buffer + s->mb_y * m->huff_row_size;
+    size_t *ncode = &m->huff_ncode[s->mb_y];
 
     /* DC coef */
     component = (n <= 3 ? 0 : (n&1) + 1);
@@ -191,7 +198,7 @@ static void record_block(MpegEncContext *s, int16_t *block, int n)
     dc = block[0]; /* overflow is impossible */
     val = dc - s->last_dc[component];
 
-    ff_mjpeg_encode_coef(m, table_id, val, 0);
+    ff_mjpeg_encode_coef(buf, ncode, table_id, val, 0);
 
     s->last_dc[component] = dc;
 
@@ -209,17 +216,17 @@ static void record_block(MpegEncContext *s, int16_t *block, int n)
             run++;
         } else {
             while (run >= 16) {
-                ff_mjpeg_encode_code(m, table_id, 0xf0);
+                ff_mjpeg_encode_code(buf, ncode, table_id, 0xf0);
                 run -= 16;
             }
-            ff_mjpeg_encode_coef(m, table_id, val, run);
+            ff_mjpeg_encode_coef(buf, ncode, table_id, val, run);
             run = 0;
         }
     }
 
     /* output EOB only if not already 64 values */
     if (last_index < 63 || run != 0)
-        ff_mjpeg_encode_code(m, table_id, 0);
+        ff_mjpeg_encode_code(buf, ncode, table_id, 0);
 }
 
 static void encode_block(MpegEncContext *s, int16_t *block, int n)
@@ -268,9 +275,9 @@ static void encode_block(MpegEncContext *s, int16_t *block, int n)
             nbits= av_log2_16bit(val) + 1;
             code = (run << 4) | nbits;
 
-            put_bits(&s->pb, huff_size_ac[code], huff_code_ac[code]);
-
-            put_sbits(&s->pb, nbits, mant);
+            /* code and mantissa fit in a single write, at most 16 + 10 bits */
+            put_bits(&s->pb, huff_size_ac[code] + nbits,
+                     (huff_code_ac[code] << nbits) | (mant & ((1 << nbits) - 1)));
             run = 0;
         }
     }
@@ -85,7 +85,13 @@ typedef struct MJpegContext {
     uint8_t bits_ac_chrominance[17]; ///< AC chrominance Huffman bits.
     uint8_t val_ac_chrominance[256]; ///< AC chrominance Huffman values.
 
-    size_t huff_ncode;               ///< Number of current entries in the buffer.
+    /**
+     * Number of current entries in the buffer, for each macroblock row.
+     * Each row has huff_row_size entries reserved, so that slice threads can
+     * record their rows independently.
+     */
+    size_t *huff_ncode;
+    size_t huff_row_size;            ///< Number of buffer entries reserved for each macroblock row.
     MJpegHuffmanCode *huff_buffer;   ///< Buffer for Huffman code values.
 } MJpegContext;
 
@@ -360,13 +360,30 @@ end:
 }
 
 /**
- * Encodes and outputs the entire frame in the JPEG format.
- *
- * @param s The MpegEncContext.
+ * Computes the number of bits needed for the Huffman codes recorded for one
+ * macroblock row.
  */
-void ff_mjpeg_encode_picture_frame(MpegEncContext *s)
+static size_t huffman_row_bits(MJpegContext *m, int mb_y)
+{
+    uint8_t *huff_size[4] = {m->huff_size_dc_luminance,
+                             m->huff_size_dc_chrominance,
+                             m->huff_size_ac_luminance,
+                             m->huff_size_ac_chrominance};
+    MJpegHuffmanCode *buf = m->huff_buffer + mb_y * m->huff_row_size;
+    size_t i, total_bits = 0;
+
+    for (i = 0; i < m->huff_ncode[mb_y]; i++)
+        total_bits += huff_size[buf[i].table_id][buf[i].code] + (buf[i].code & 0xf);
+
+    return total_bits;
+}
+
+/**
+ * Outputs the Huffman codes recorded for one macroblock row and empties the
+ * row's buffer.
+ */
+static void encode_huffman_row(MpegEncContext *s, int mb_y)
 {
-    int i, nbits, code, table_id;
     MJpegContext *m = s->mjpeg_ctx;
     uint8_t *huff_size[4] = {m->huff_size_dc_luminance,
                              m->huff_size_dc_chrominance,
@@ -376,38 +393,82 @@ void ff_mjpeg_encode_picture_frame(MpegEncContext *s)
                               m->huff_code_dc_chrominance,
                               m->huff_code_ac_luminance,
                               m->huff_code_ac_chrominance};
+    MJpegHuffmanCode *buf = m->huff_buffer + mb_y * m->huff_row_size;
+    size_t i;
+
+    for (i = 0; i < m->huff_ncode[mb_y]; i++) {
+        int table_id = buf[i].table_id;
+        int code     = buf[i].code;
+        int nbits    = code & 0xf;
+
+        /* code and mantissa fit in a single write, at most 16 + 11 bits */
+        put_bits(&s->pb, huff_size[table_id][code] + nbits,
+                 (huff_code[table_id][code] << nbits) | (buf[i].mant & ((1 << nbits) - 1)));
+    }
+
+    m->huff_ncode[mb_y] = 0;
+}
+
+/**
+ * Encodes and outputs the entire frame in the JPEG format.
+ *
+ * @param s The MpegEncContext.
+ */
+void ff_mjpeg_encode_picture_frame(MpegEncContext *s)
+{
+    MJpegContext *m = s->mjpeg_ctx;
     size_t total_bits = 0;
     size_t bytes_needed;
+    int mb_y;
 
     s->header_bits = get_bits_diff(s);
     // Estimate the total size first
-    for (i = 0; i < m->huff_ncode; i++) {
-        table_id = m->huff_buffer[i].table_id;
-        code = m->huff_buffer[i].code;
-        nbits = code & 0xf;
-
-        total_bits += huff_size[table_id][code] + nbits;
-    }
+    for (mb_y = 0; mb_y < s->mb_height; mb_y++)
+        total_bits += huffman_row_bits(m, mb_y);
 
     bytes_needed = (total_bits + 7) / 8;
     ff_mpv_reallocate_putbitbuffer(s, bytes_needed, bytes_needed);
 
-    for (i = 0; i < m->huff_ncode; i++) {
-        table_id = m->huff_buffer[i].table_id;
-        code = m->huff_buffer[i].code;
-        nbits = code & 0xf;
+    for (mb_y = 0; mb_y < s->mb_height; mb_y++)
+        encode_huffman_row(s, mb_y);
 
-        put_bits(&s->pb, huff_size[table_id][code], huff_code[table_id][code]);
-        if (nbits != 0) {
-            put_sbits(&s->pb, nbits, m->huff_buffer[i].mant);
-        }
+    s->i_tex_bits = get_bits_diff(s);
+}
+
+static int encode_slice_huffman(AVCodecContext *avctx, void *arg)
+{
+    MpegEncContext *s = *(void **)arg;
+    int mb_y;
+
+    s->last_bits = put_bits_count(&s->pb);
+
+    for (mb_y = s->start_mb_y; mb_y < s->end_mb_y; mb_y++) {
+        size_t row_bits = huffman_row_bits(s->mjpeg_ctx, mb_y);
+
+        /* the row and its padding to a byte boundary; the room for the
+         * escape bytes is checked once they are counted */
+        if (put_bits_left(&s->pb) < row_bits + 7)
+            goto too_large;
+
+        encode_huffman_row(s, mb_y);
+
+        if (ff_mjpeg_escape_FF(&s->pb, s->esc_pos) < 0 ||
+            put_bits_left(&s->pb) < 16)
+            goto too_large;
+        put_marker(&s->pb, RST0 + (mb_y & 7));
+        s->esc_pos = put_bits_count(&s->pb) >> 3;
     }
+    flush_put_bits(&s->pb);
 
-    m->huff_ncode = 0;
     s->i_tex_bits = get_bits_diff(s);
+    return 0;
+
+too_large:
+    av_log(avctx, AV_LOG_ERROR, "encoded frame too large\n");
+    return AVERROR(ENOMEM);
 }
 
-void ff_mjpeg_escape_FF(PutBitContext *pb, int start)
+int ff_mjpeg_escape_FF(PutBitContext *pb, int start)
 {
     int size;
     int i, ff_count;
@@ -449,9 +510,11 @@ void ff_mjpeg_escape_FF(PutBitContext *pb, int start)
         if(buf[i]==0xFF) ff_count++;
     }
 
-    if(ff_count==0) return;
+    if(ff_count==0) return 0;
 
     flush_put_bits(pb);
+    if (ff_count > pb->buf_end - pb->buf_ptr)
+        return AVERROR(ENOMEM);
     skip_put_bytes(pb, ff_count);
 
     for(i=size-1; ff_count; i--){
@@ -464,6 +527,8 @@ void ff_mjpeg_escape_FF(PutBitContext *pb, int start)
 
         buf[i+ff_count]= v;
     }
+
+    return 0;
 }
 
 /**
@@ -474,9 +539,10 @@ void ff_mjpeg_escape_FF(PutBitContext *pb, int start)
  *
  * @param m MJpegContext containing the JPEG buffer.
  */
-static void ff_mjpeg_build_optimal_huffman(MJpegContext *m)
+static void ff_mjpeg_build_optimal_huffman(MJpegContext *m, int mb_height)
 {
-    int i, table_id, code;
+    int mb_y, table_id, code;
+    size_t i;
 
     MJpegEncHuffmanContext dc_luminance_ctx;
     MJpegEncHuffmanContext dc_chrominance_ctx;
@@ -489,11 +555,15 @@ static void ff_mjpeg_build_optimal_huffman(MJpegContext *m)
     for (i = 0; i < 4; i++) {
         ff_mjpeg_encode_huffman_init(ctx[i]);
     }
-    for (i = 0; i < m->huff_ncode; i++) {
-        table_id = m->huff_buffer[i].table_id;
-        code = m->huff_buffer[i].code;
+    for (mb_y = 0; mb_y < mb_height; mb_y++) {
+        MJpegHuffmanCode *buf = m->huff_buffer + mb_y * m->huff_row_size;
+
+        for (i = 0; i < m->huff_ncode[mb_y]; i++) {
+            table_id = buf[i].table_id;
+            code = buf[i].code;
 
-        ff_mjpeg_encode_huffman_increment(ctx[table_id], code);
+            ff_mjpeg_encode_huffman_increment(ctx[table_id], code);
+        }
     }
 
     ff_mjpeg_encode_huffman_close(&dc_luminance_ctx,
@@ -527,6 +597,45 @@ static void ff_mjpeg_build_optimal_huffman(MJpegContext *m)
                                  m->val_ac_chrominance);
 }
 
+/**
+ * Builds the optimal Huffman tables from the codes recorded for the frame
+ * and makes the encoder use them.
+ */
+static void build_optimal_tables(MpegEncContext *s)
+{
+    MJpegContext *m = s->mjpeg_ctx;
+
+    ff_mjpeg_build_optimal_huffman(m, s->mb_height);
+
+    // Replace the VLCs with the optimal ones.
+    // The default ones may be used for trellis during quantization.
+    ff_init_uni_ac_vlc(m->huff_size_ac_luminance,   m->uni_ac_vlc_len);
+    ff_init_uni_ac_vlc(m->huff_size_ac_chrominance, m->uni_chroma_ac_vlc_len);
+    s->intra_ac_vlc_length      =
+    s->intra_ac_vlc_last_length = m->uni_ac_vlc_len;
+    s->intra_chroma_ac_vlc_length      =
+    s->intra_chroma_ac_vlc_last_length = m->uni_chroma_ac_vlc_len;
+}
+
+int ff_mjpeg_encode_picture_slices(MpegEncContext *s)
+{
+    int ret[MAX_THREADS];
+    int i;
+
+    build_optimal_tables(s);
+
+    ff_mjpeg_encode_picture_header(s->avctx, &s->pb, &s->intra_scantable,
+                                   s->pred, s->intra_matrix, s->chroma_intra_matrix);
+    s->header_bits = put_bits_count(&s->pb);
+
+    s->avctx->execute(s->avctx, encode_slice_huffman, &s->thread_context[0],
+                      ret, s->slice_context_count, sizeof(void *));
+    for (i = 0; i < s->slice_context_count; i++)
+        if (ret[i] < 0)
+            return ret[i];
+    return 0;
+}
+
 /**
  * Writes the complete JPEG frame when optimal huffman tables are enabled,
  * otherwise writes the stuffing.
@@ -541,22 +650,15 @@ int ff_mjpeg_encode_stuffing(MpegEncContext *s)
     int i;
     PutBitContext *pbc = &s->pb;
     int mb_y = s->mb_y - !s->mb_x;
-    int ret;
-    MJpegContext *m;
+    int ret = 0;
 
-    m = s->mjpeg_ctx;
+    /* With slice threads, the rows are written once all slices are done,
+     * see ff_mjpeg_encode_picture_slices(). */
+    if (s->huffman == HUFFMAN_TABLE_OPTIMAL && s->slice_context_count > 1)
+        goto fail;
 
     if (s->huffman == HUFFMAN_TABLE_OPTIMAL) {
-        ff_mjpeg_build_optimal_huffman(m);
-
-        // Replace the VLCs with the optimal ones.
-        // The default ones may be used for trellis during quantization.
-        ff_init_uni_ac_vlc(m->huff_size_ac_luminance,   m->uni_ac_vlc_len);
-        ff_init_uni_ac_vlc(m->huff_size_ac_chrominance, m->uni_chroma_ac_vlc_len);
-        s->intra_ac_vlc_length      =
-        s->intra_ac_vlc_last_length = m->uni_ac_vlc_len;
-        s->intra_chroma_ac_vlc_length      =
-        s->intra_chroma_ac_vlc_last_length = m->uni_chroma_ac_vlc_len;
+        build_optimal_tables(s);
 
         ff_mjpeg_encode_picture_header(s->avctx, &s->pb, &s->intra_scantable,
                                        s->pred, s->intra_matrix, s->chroma_intra_matrix);
@@ -607,8 +709,7 @@ void ff_mjpeg_encode_dc(PutBitContext *pb, int val,
 
         nbits= av_log2_16bit(val) + 1;
 
-        put_bits(pb, huff_size[nbits], huff_code[nbits]);
-
-        put_sbits(pb, nbits, mant);
+        put_bits(pb, huff_size[nbits] + nbits,
+                 (huff_code[nbits] << nbits) | (mant & ((1 << nbits) - 1)));
     }
 }
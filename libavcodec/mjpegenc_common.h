@@ -34,8 +34,22 @@ void ff_mjpeg_encode_picture_header(AVCodecContext *avctx, PutBitContext *pb,
                                     uint16_t chroma_intra_matrix[64]);
 void ff_mjpeg_encode_picture_frame(MpegEncContext *s);
 void ff_mjpeg_encode_picture_trailer(PutBitContext *pb, int header_bits);
-void ff_mjpeg_escape_FF(PutBitContext *pb, int start);
+/**
+ * Pad the bitstream to a byte boundary and escape the 0xFF bytes written
+ * from byte start on.
+ *
+ * @return 0 on success, AVERROR(ENOMEM) if the buffer has no room for the
+ *         escape bytes, in which case the data is left unescaped
+ */
+int ff_mjpeg_escape_FF(PutBitContext *pb, int start);
 int ff_mjpeg_encode_stuffing(MpegEncContext *s);
+
+/**
+ * Write the picture header and the Huffman coded rows of every slice, once
+ * the slice threads have recorded the codes of the whole picture. Used when
+ * optimal Huffman tables are combined with slice threading.
+ */
+int ff_mjpeg_encode_picture_slices(MpegEncContext *s);
 void ff_mjpeg_init_hvsample(AVCodecContext *avctx, int hsample[4], int vsample[4]);
 
 void ff_mjpeg_encode_dc(PutBitContext *pb, int val,
@@ -399,7 +399,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
         return AVERROR(EINVAL);
     }
 
-    if (avctx->codec_id == AV_CODEC_ID_AMV || (avctx->active_thread_type & FF_THREAD_SLICE))
+    if (avctx->codec_id == AV_CODEC_ID_AMV)
         s->huffman = 0;
 
     if (s->intra_dc_precision > (avctx->codec_id == AV_CODEC_ID_MPEG2VIDEO ? 3 : 0)) {
@@ -3916,6 +3916,12 @@ static int encode_picture(MpegEncContext *s, int picture_number)
         update_duplicate_context_after_me(s->thread_context[i], s);
     }
     s->avctx->execute(s->avctx, encode_thread, &s->thread_context[0], NULL, context_count, sizeof(void*));
+    if (CONFIG_MJPEG_ENCODER && s->out_format == FMT_MJPEG &&
+        s->huffman == HUFFMAN_TABLE_OPTIMAL && context_count > 1) {
+        ret = ff_mjpeg_encode_picture_slices(s);
+        if (ret < 0)
+            return ret;
+    }
     for(i=1; i<context_count; i++){
         if (s->pb.buf_end == s->thread_context[i]->pb.buf)
             set_put_bits_buffer_size(&s->pb, FFMIN(s->thread_context[i]->pb.buf_end - s->pb.buf, INT_MAX/8-32));
@@ -32,10 +32,12 @@
 #include "libavutil/opt.h"
 #include "libavutil/color_utils.h"
 #include "libavutil/stereo3d.h"
+#include "libavutil/time.h"
 
 #include <zlib.h>
 
 #define IOBUF_SIZE 4096
+#define MAX_CHUNKS 64
 
 typedef struct APNGFctlChunk {
     uint32_t sequence_number;
@@ -45,6 +47,19 @@ typedef struct APNGFctlChunk {
     uint8_t dispose_op, blend_op;
 } APNGFctlChunk;
 
+/**
+ * A part of the image data compressed independently of the others, as a raw
+ * deflate stream primed with the preceding 32 KiB of filtered data.
+ */
+typedef struct PNGEncChunk {
+    z_stream zstream;
+    int zstream_inited;
+    uint8_t *out;
+    unsigned int out_size;
+    int out_len;
+    uLong adler;                 ///< Adler-32 of the filtered data of the chunk
+} PNGEncChunk;
+
 typedef struct PNGEncContext {
     AVClass *class;
     LLVidEncDSPContext llvidencdsp;
@@ -57,6 +72,7 @@ typedef struct PNGEncContext {
 
     z_stream zstream;
     uint8_t buf[IOBUF_SIZE];
+    int compression_level;
     int dpi;                     ///< Physical pixel density, in dots per inch, if set
     int dpm;                     ///< Physical pixel density, in dots per meter, if set
 
@@ -65,6 +81,23 @@ typedef struct PNGEncContext {
     int color_type;
     int bits_per_pixel;
 
+    // parallel compression
+    int nb_chunks;               ///< number of chunks the image data is compressed in
+    PNGEncChunk *chunks;
+    const AVFrame *chunk_frame;  ///< frame being filtered by the chunk jobs
+    uint8_t *filtered;           ///< filtered rows of chunk_frame
+    unsigned int filtered_size;
+    int chunk_ret[MAX_CHUNKS];
+
+    // encoding times in microseconds, only measured with verbose logging;
+    // the stages are only told apart when compressing in chunks
+    int timing;
+    int64_t encode_time;
+    int64_t filter_time;
+    int64_t deflate_time;
+    int64_t write_time;
+    int nb_images;
+
     // APNG
     uint32_t palette_checksum;   // Used to ensure a single unique palette
     uint32_t sequence_number;
@@ -118,8 +151,8 @@ static void png_get_interlaced_row(uint8_t *dst, int row_size,
     }
 }
 
-static void sub_png_paeth_prediction(uint8_t *dst, uint8_t *src, uint8_t *top,
-                                     int w, int bpp)
+static void sub_png_paeth_prediction(uint8_t *dst, const uint8_t *src,
+                                     const uint8_t *top, int w, int bpp)
 {
     int i;
     for (i = 0; i < w; i++) {
@@ -162,10 +195,44 @@ static void sub_left_prediction(PNGEncContext *c, uint8_t *dst, const uint8_t *s
     c->llvidencdsp.diff_bytes(dst, src1, src2, size);
 }
 
+/* the SIMD predictors work on multiples of 16 bytes, the rest is done here */
+static void sub_avg_prediction(PNGEncContext *c, uint8_t *dst, const uint8_t *src,
+                               const uint8_t *top, int bpp, int size)
+{
+    int i, w = (size - bpp) & ~15;
+
+    for (i = 0; i < bpp; i++)
+        dst[i] = src[i] - (top[i] >> 1);
+    c->llvidencdsp.sub_png_avg_pred(dst + i, src + i, top + i, w, bpp);
+    for (i += w; i < size; i++)
+        dst[i] = src[i] - ((src[i - bpp] + top[i]) >> 1);
+}
+
+static void sub_paeth_prediction(PNGEncContext *c, uint8_t *dst, const uint8_t *src,
+                                 const uint8_t *top, int bpp, int size)
+{
+    int i, w = (size - bpp) & ~15;
+
+    for (i = 0; i < bpp; i++)
+        dst[i] = src[i] - top[i];
+    c->llvidencdsp.sub_png_paeth_pred(dst + i, src + i, top + i, w, bpp);
+    i += w;
+    sub_png_paeth_prediction(dst + i, src + i, top + i, size - i, bpp);
+}
+
+static int png_filter_cost(PNGEncContext *c, const uint8_t *buf, int size)
+{
+    int i, w = size & ~15;
+    int cost = c->llvidencdsp.sum_abs_int8(buf, w);
+
+    for (i = w; i < size; i++)
+        cost += abs((int8_t) buf[i]);
+    return cost;
+}
+
 static void png_filter_row(PNGEncContext *c, uint8_t *dst, int filter_type,
                            uint8_t *src, uint8_t *top, int size, int bpp)
 {
-    int i;
 
     switch (filter_type) {
     case PNG_FILTER_VALUE_NONE:
@@ -178,15 +245,10 @@ static void png_filter_row(PNGEncContext *c, uint8_t *dst, int filter_type,
         c->llvidencdsp.diff_bytes(dst, src, top, size);
         break;
     case PNG_FILTER_VALUE_AVG:
-        for (i = 0; i < bpp; i++)
-            dst[i] = src[i] - (top[i] >> 1);
-        for (; i < size; i++)
-            dst[i] = src[i] - ((src[i - bpp] + top[i]) >> 1);
+        sub_avg_prediction(c, dst, src, top, bpp, size);
         break;
     case PNG_FILTER_VALUE_PAETH:
-        for (i = 0; i < bpp; i++)
-            dst[i] = src[i] - top[i];
-        sub_png_paeth_prediction(dst + i, src + i, top + i, size - i, bpp);
+        sub_paeth_prediction(c, dst, src, top, bpp, size);
         break;
     }
 }
@@ -199,15 +261,12 @@ static uint8_t *png_choose_filter(PNGEncContext *s, uint8_t *dst,
     if (!top && pred)
         pred = PNG_FILTER_VALUE_SUB;
     if (pred == PNG_FILTER_VALUE_MIXED) {
-        int i;
         int cost, bcost = INT_MAX;
         uint8_t *buf1 = dst, *buf2 = dst + size + 16;
         for (pred = 0; pred < 5; pred++) {
             png_filter_row(s, buf1 + 1, pred, src, top, size, bpp);
             buf1[0] = pred;
-            cost = 0;
-            for (i = 0; i <= size; i++)
-                cost += abs((int8_t) buf1[i]);
+            cost = png_filter_cost(s, buf1, size + 1);
             if (cost < bcost) {
                 bcost = cost;
                 FFSWAP(uint8_t *, buf1, buf2);
@@ -428,7 +487,178 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
-static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
+static void chunk_rows(const PNGEncContext *s, int jobnr, int *y0, int *y1)
+{
+    int height    = s->chunk_frame->height;
+    int nb_chunks = FFMIN(s->nb_chunks, height);
+
+    *y0 = (int64_t)height *  jobnr      / nb_chunks;
+    *y1 = (int64_t)height * (jobnr + 1) / nb_chunks;
+}
+
+static int filter_chunk(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s       = avctx->priv_data;
+    const AVFrame *const p = s->chunk_frame;
+    int row_size = (p->width * s->bits_per_pixel + 7) >> 3;
+    uint8_t *ptr, *top, *crow_base, *crow;
+    int y, y0, y1;
+
+    chunk_rows(s, jobnr, &y0, &y1);
+
+    crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
+    if (!crow_base)
+        return AVERROR(ENOMEM);
+
+    top = y0 ? p->data[0] + (y0 - 1) * p->linesize[0] : NULL;
+    for (y = y0; y < y1; y++) {
+        ptr  = p->data[0] + y * p->linesize[0];
+        crow = png_choose_filter(s, crow_base + 15, ptr, top,
+                                 row_size, s->bits_per_pixel >> 3);
+        memcpy(s->filtered + (size_t)y * (row_size + 1), crow, row_size + 1);
+        top = ptr;
+    }
+
+    av_free(crow_base);
+    return 0;
+}
+
+static int deflate_chunk(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s = avctx->priv_data;
+    PNGEncChunk *c   = &s->chunks[jobnr];
+    int row_size  = (s->chunk_frame->width * s->bits_per_pixel + 7) >> 3;
+    int last      = jobnr == FFMIN(s->nb_chunks, s->chunk_frame->height) - 1;
+    size_t offset, len, bound;
+    uint8_t *data;
+    int y0, y1, ret;
+
+    chunk_rows(s, jobnr, &y0, &y1);
+    offset = (size_t)y0 * (row_size + 1);
+    len    = (size_t)(y1 - y0) * (row_size + 1);
+    data   = s->filtered + offset;
+
+    if (deflateReset(&c->zstream) != Z_OK)
+        return AVERROR_EXTERNAL;
+    /* use the end of the previous chunk as history, like a single stream */
+    if (offset) {
+        size_t dict_len = FFMIN(offset, 32768);
+        if (deflateSetDictionary(&c->zstream, data - dict_len, dict_len) != Z_OK)
+            return AVERROR_EXTERNAL;
+    }
+
+    /* leave room for the empty stored block of the sync flush */
+    bound = deflateBound(&c->zstream, len) + 16;
+    if (bound > INT_MAX)
+        return AVERROR(ENOMEM);
+    av_fast_malloc(&c->out, &c->out_size, bound);
+    if (!c->out)
+        return AVERROR(ENOMEM);
+
+    c->zstream.next_in   = data;
+    c->zstream.avail_in  = len;
+    c->zstream.next_out  = c->out;
+    c->zstream.avail_out = bound;
+    /* a sync flush ends the chunk on a byte boundary without ending the
+     * stream, so that the next chunk can be appended */
+    ret = deflate(&c->zstream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (ret != (last ? Z_STREAM_END : Z_OK) ||
+        c->zstream.avail_in || !c->zstream.avail_out)
+        return AVERROR_EXTERNAL;
+    c->out_len = bound - c->zstream.avail_out;
+    c->adler   = adler32(adler32(0, NULL, 0), data, len);
+
+    return 0;
+}
+
+static void png_buffer_image_data(AVCodecContext *avctx, int *buf_len,
+                                  const uint8_t *data, int len)
+{
+    PNGEncContext *s = avctx->priv_data;
+
+    while (len > 0) {
+        int size = FFMIN(len, IOBUF_SIZE - *buf_len);
+        memcpy(s->buf + *buf_len, data, size);
+        *buf_len += size;
+        data     += size;
+        len      -= size;
+        if (*buf_len == IOBUF_SIZE) {
+            if (s->bytestream_end - s->bytestream > IOBUF_SIZE + 100)
+                png_write_image_data(avctx, s->buf, IOBUF_SIZE);
+            *buf_len = 0;
+        }
+    }
+}
+
+/**
+ * Filter and compress the image in nb_chunks parts with slice threads.
+ * The parts are joined into a single zlib stream, which depends on the
+ * number of chunks but not on the number of threads.
+ */
+static int encode_frame_chunks(AVCodecContext *avctx, const AVFrame *pict)
+{
+    PNGEncContext *s = avctx->priv_data;
+    int row_size  = (pict->width * s->bits_per_pixel + 7) >> 3;
+    int nb_chunks = FFMIN(s->nb_chunks, pict->height);
+    int level     = s->compression_level == Z_DEFAULT_COMPRESSION ? 6 : s->compression_level;
+    uLong adler   = adler32(0, NULL, 0);
+    uint8_t header[4];
+    int64_t start;
+    int i, y0, y1, buf_len = 0;
+
+    av_fast_malloc(&s->filtered, &s->filtered_size,
+                   (size_t)pict->height * (row_size + 1));
+    if (!s->filtered)
+        return AVERROR(ENOMEM);
+    s->chunk_frame = pict;
+
+    start = s->timing ? av_gettime_relative() : 0;
+    avctx->execute2(avctx, filter_chunk, NULL, s->chunk_ret, nb_chunks);
+    if (s->timing) {
+        s->filter_time += av_gettime_relative() - start;
+        start = av_gettime_relative();
+    }
+    for (i = 0; i < nb_chunks; i++)
+        if (s->chunk_ret[i] < 0)
+            return s->chunk_ret[i];
+
+    avctx->execute2(avctx, deflate_chunk, NULL, s->chunk_ret, nb_chunks);
+    if (s->timing) {
+        s->deflate_time += av_gettime_relative() - start;
+        start = av_gettime_relative();
+    }
+    for (i = 0; i < nb_chunks; i++) {
+        if (s->chunk_ret[i] < 0) {
+            av_log(avctx, AV_LOG_ERROR, "Compressing chunk %d failed\n", i);
+            return s->chunk_ret[i];
+        }
+    }
+
+    /* zlib header, with the compression level hint deflate would use */
+    header[0] = 0x78;
+    header[1] = (level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6;
+    header[1] += 31 - (header[0] << 8 | header[1]) % 31;
+    png_buffer_image_data(avctx, &buf_len, header, 2);
+
+    for (i = 0; i < nb_chunks; i++) {
+        png_buffer_image_data(avctx, &buf_len, s->chunks[i].out, s->chunks[i].out_len);
+        chunk_rows(s, i, &y0, &y1);
+        adler = i ? adler32_combine(adler, s->chunks[i].adler,
+                                    (z_off_t)(y1 - y0) * (row_size + 1))
+                  : s->chunks[i].adler;
+    }
+
+    AV_WB32(header, adler);
+    png_buffer_image_data(avctx, &buf_len, header, 4);
+    if (buf_len > 0 && s->bytestream_end - s->bytestream > buf_len + 100)
+        png_write_image_data(avctx, s->buf, buf_len);
+    if (s->timing)
+        s->write_time += av_gettime_relative() - start;
+
+    return 0;
+}
+
+static int encode_frame_rows(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
     const AVFrame *const p = pict;
@@ -521,6 +751,23 @@ the_end:
     return ret;
 }
 
+static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
+{
+    PNGEncContext *s = avctx->priv_data;
+    int64_t start    = s->timing ? av_gettime_relative() : 0;
+    int ret;
+
+    if (s->nb_chunks > 1 && !s->is_progressive)
+        ret = encode_frame_chunks(avctx, pict);
+    else
+        ret = encode_frame_rows(avctx, pict);
+    if (s->timing) {
+        s->encode_time += av_gettime_relative() - start;
+        s->nb_images++;
+    }
+    return ret;
+}
+
 static int encode_png(AVCodecContext *avctx, AVPacket *pkt,
                       const AVFrame *pict, int *got_packet)
 {
@@ -989,7 +1236,7 @@ static int encode_apng(AVCodecContext *avctx, AVPacket *pkt,
 static av_cold int png_enc_init(AVCodecContext *avctx)
 {
     PNGEncContext *s = avctx->priv_data;
-    int compression_level;
+    int compression_level, i;
 
     switch (avctx->pix_fmt) {
     case AV_PIX_FMT_RGBA:
@@ -1008,6 +1255,8 @@ static av_cold int png_enc_init(AVCodecContext *avctx)
         avctx->bits_per_coded_sample = 8;
     }
 
+    s->timing = av_log_get_level() >= AV_LOG_VERBOSE;
+
 #if FF_API_CODED_FRAME
 FF_DISABLE_DEPRECATION_WARNINGS
     avctx->coded_frame->pict_type = AV_PICTURE_TYPE_I;
@@ -1091,6 +1340,23 @@ FF_ENABLE_DEPRECATION_WARNINGS
                       : av_clip(avctx->compression_level, 0, 9);
     if (deflateInit2(&s->zstream, compression_level, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
         return -1;
+    s->compression_level = compression_level;
+
+    if (s->nb_chunks > 1 && !s->is_progressive) {
+        s->chunks = av_mallocz_array(s->nb_chunks, sizeof(*s->chunks));
+        if (!s->chunks)
+            return AVERROR(ENOMEM);
+        for (i = 0; i < s->nb_chunks; i++) {
+            PNGEncChunk *c = &s->chunks[i];
+            c->zstream.zalloc = ff_png_zalloc;
+            c->zstream.zfree  = ff_png_zfree;
+            c->zstream.opaque = NULL;
+            if (deflateInit2(&c->zstream, compression_level, Z_DEFLATED, -15, 8,
+                             Z_DEFAULT_STRATEGY) != Z_OK)
+                return AVERROR_EXTERNAL;
+            c->zstream_inited = 1;
+        }
+    }
 
     return 0;
 }
@@ -1098,8 +1364,28 @@ FF_ENABLE_DEPRECATION_WARNINGS
 static av_cold int png_enc_close(AVCodecContext *avctx)
 {
     PNGEncContext *s = avctx->priv_data;
+    int i;
+
+    if (s->nb_images && s->nb_chunks > 1 && !s->is_progressive)
+        av_log(avctx, AV_LOG_VERBOSE,
+               "%d images, average time per image %"PRId64" us: filtering %"PRId64" us, "
+               "compression %"PRId64" us, chunk writing %"PRId64" us\n",
+               s->nb_images, s->encode_time / s->nb_images, s->filter_time / s->nb_images,
+               s->deflate_time / s->nb_images, s->write_time / s->nb_images);
+    else if (s->nb_images)
+        av_log(avctx, AV_LOG_VERBOSE, "%d images, average time per image %"PRId64" us\n",
+               s->nb_images, s->encode_time / s->nb_images);
 
     deflateEnd(&s->zstream);
+    if (s->chunks) {
+        for (i = 0; i < s->nb_chunks; i++) {
+            if (s->chunks[i].zstream_inited)
+                deflateEnd(&s->chunks[i].zstream);
+            av_freep(&s->chunks[i].out);
+        }
+        av_freep(&s->chunks);
+    }
+    av_freep(&s->filtered);
     av_frame_free(&s->last_frame);
     av_frame_free(&s->prev_frame);
     av_freep(&s->last_frame_packet);
@@ -1120,6 +1406,7 @@ static const AVOption options[] = {
         { "avg",   NULL, 0, AV_OPT_TYPE_CONST, { .i64 = PNG_FILTER_VALUE_AVG },   INT_MIN, INT_MAX, VE, "pred" },
         { "paeth", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = PNG_FILTER_VALUE_PAETH }, INT_MIN, INT_MAX, VE, "pred" },
         { "mixed", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = PNG_FILTER_VALUE_MIXED }, INT_MIN, INT_MAX, VE, "pred" },
+    { "chunks", "Compress the image data in independent chunks, in parallel with slice threads", OFFSET(nb_chunks), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, MAX_CHUNKS, VE },
     { NULL},
 };
 
@@ -1146,7 +1433,8 @@ AVCodec ff_png_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_png,
-    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_INTRA_ONLY,
+    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS |
+                      AV_CODEC_CAP_INTRA_ONLY,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
@@ -1167,7 +1455,7 @@ AVCodec ff_apng_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_apng,
-    .capabilities   = AV_CODEC_CAP_DELAY,
+    .capabilities   = AV_CODEC_CAP_DELAY | AV_CODEC_CAP_SLICE_THREADS,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
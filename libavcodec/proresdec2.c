@@ -46,15 +46,34 @@ static void permute(uint8_t *dst, const uint8_t *src, const uint8_t permutation[
         dst[i] = permutation[src[i]];
 }
 
+#define SLICE_JOB_BYTES (128 << 10)
+
 #define ALPHA_SHIFT_16_TO_10(alpha_val) (alpha_val >> 6)
 #define ALPHA_SHIFT_8_TO_10(alpha_val)  ((alpha_val << 2) | (alpha_val >> 6))
 #define ALPHA_SHIFT_16_TO_12(alpha_val) (alpha_val >> 4)
 #define ALPHA_SHIFT_8_TO_12(alpha_val)  ((alpha_val << 4) | (alpha_val >> 4))
 
+static av_always_inline int scale_alpha(int alpha_val, const int num_bits,
+                                        const int decode_precision)
+{
+    if (num_bits == 16) {
+        if (decode_precision == 10)
+            return ALPHA_SHIFT_16_TO_10(alpha_val);
+        else /* 12b */
+            return ALPHA_SHIFT_16_TO_12(alpha_val);
+    } else {
+        if (decode_precision == 10)
+            return ALPHA_SHIFT_8_TO_10(alpha_val);
+        else /* 12b */
+            return ALPHA_SHIFT_8_TO_12(alpha_val);
+    }
+}
+
 static void inline unpack_alpha(GetBitContext *gb, uint16_t *dst, int num_coeffs,
                                 const int num_bits, const int decode_precision) {
     const int mask = (1 << num_bits) - 1;
     int i, idx, val, alpha_val;
+    uint64_t run_val;
 
     idx       = 0;
     alpha_val = mask;
@@ -71,19 +90,7 @@ static void inline unpack_alpha(GetBitContext *gb, uint16_t *dst, int num_coeffs
                     val = -val;
             }
             alpha_val = (alpha_val + val) & mask;
-            if (num_bits == 16) {
-                if (decode_precision == 10) {
-                    dst[idx++] = ALPHA_SHIFT_16_TO_10(alpha_val);
-                } else { /* 12b */
-                    dst[idx++] = ALPHA_SHIFT_16_TO_12(alpha_val);
-                }
-            } else {
-                if (decode_precision == 10) {
-                    dst[idx++] = ALPHA_SHIFT_8_TO_10(alpha_val);
-                } else { /* 12b */
-                    dst[idx++] = ALPHA_SHIFT_8_TO_12(alpha_val);
-                }
-            }
+            dst[idx++] = scale_alpha(alpha_val, num_bits, decode_precision);
             if (idx >= num_coeffs)
                 break;
         } while (get_bits_left(gb)>0 && get_bits1(gb));
@@ -92,23 +99,14 @@ static void inline unpack_alpha(GetBitContext *gb, uint16_t *dst, int num_coeffs
             val = get_bits(gb, 11);
         if (idx + val > num_coeffs)
             val = num_coeffs - idx;
-        if (num_bits == 16) {
-            for (i = 0; i < val; i++) {
-                if (decode_precision == 10) {
-                    dst[idx++] = ALPHA_SHIFT_16_TO_10(alpha_val);
-                } else { /* 12b */
-                    dst[idx++] = ALPHA_SHIFT_16_TO_12(alpha_val);
-                }
-            }
-        } else {
-            for (i = 0; i < val; i++) {
-                if (decode_precision == 10) {
-                    dst[idx++] = ALPHA_SHIFT_8_TO_10(alpha_val);
-                } else { /* 12b */
-                    dst[idx++] = ALPHA_SHIFT_8_TO_12(alpha_val);
-                }
-            }
-        }
+
+        /* runs are often long (fully opaque areas), fill 4 samples at once */
+        run_val  = scale_alpha(alpha_val, num_bits, decode_precision) * 0x0001000100010001ULL;
+        for (i = 0; i + 3 < val; i += 4)
+            AV_WN64(dst + idx + i, run_val);
+        for (; i < val; i++)
+            dst[idx + i] = run_val;
+        idx += val;
     } while (idx < num_coeffs);
 }
 
@@ -593,9 +591,7 @@ static void decode_slice_alpha(ProresContext *ctx,
     LOCAL_ALIGNED_32(int16_t, blocks, [8*4*64]);
     int16_t *block;
 
-    for (i = 0; i < blocks_per_slice<<2; i++)
-        ctx->bdsp.clear_block(blocks+(i<<6));
-
+    /* unpack_alpha() writes all the samples, no need to clear them */
     init_get_bits(&gb, buf, buf_size << 3);
 
     if (ctx->alpha_info == 2) {
@@ -729,13 +725,48 @@ static int decode_slice_thread(AVCodecContext *avctx, void *arg, int jobnr, int
     return 0;
 }
 
+static int decode_slice_batch(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    ProresContext *ctx = avctx->priv_data;
+    int slices_per_job = *(int *)arg;
+    int i, start = jobnr * slices_per_job;
+    int end = FFMIN(start + slices_per_job, ctx->slice_count);
+
+    for (i = start; i < end; i++)
+        decode_slice_thread(avctx, NULL, i, threadnr);
+
+    return 0;
+}
+
+/**
+ * Number of adjacent slices decoded by one job: enough for their output to
+ * fill SLICE_JOB_BYTES, but leaving several jobs per thread to balance the
+ * load. Small slices of large pictures then do not pay the per job cost.
+ */
+static int get_slices_per_job(AVCodecContext *avctx, ProresContext *ctx)
+{
+    int is_444 = avctx->pix_fmt == AV_PIX_FMT_YUV444P10 || avctx->pix_fmt == AV_PIX_FMT_YUVA444P10 ||
+                 avctx->pix_fmt == AV_PIX_FMT_YUV444P12 || avctx->pix_fmt == AV_PIX_FMT_YUVA444P12;
+    /* luma, both chroma planes and alpha of one 16x16 macroblock, 16 bits */
+    int mb_bytes = 512 * (2 + is_444 + !!ctx->alpha_info);
+    int64_t slice_bytes = (int64_t)ctx->mb_width * ctx->mb_height * mb_bytes / ctx->slice_count;
+    int slices_per_job = FFMAX(SLICE_JOB_BYTES / FFMAX(slice_bytes, 1), 1);
+
+    return FFMIN(slices_per_job, FFMAX(ctx->slice_count / (4 * avctx->thread_count), 1));
+}
+
 static int decode_picture(AVCodecContext *avctx)
 {
     ProresContext *ctx = avctx->priv_data;
     int i;
     int error = 0;
+    int slices_per_job = get_slices_per_job(avctx, ctx);
 
-    avctx->execute2(avctx, decode_slice_thread, NULL, NULL, ctx->slice_count);
+    if (slices_per_job > 1)
+        avctx->execute2(avctx, decode_slice_batch, &slices_per_job, NULL,
+                        (ctx->slice_count + slices_per_job - 1) / slices_per_job);
+    else
+        avctx->execute2(avctx, decode_slice_thread, NULL, NULL, ctx->slice_count);
 
     for (i = 0; i < ctx->slice_count; i++)
         error += ctx->slices[i].ret < 0;
@@ -44,6 +44,7 @@
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/thread.h"
+#include "libavutil/time.h"
 
 enum {
     ///< Set when the thread is awaiting a packet.
@@ -109,6 +110,8 @@ typedef struct PerThreadContext {
     int async_serializing;
 
     atomic_int debug_threads;       ///< Set if the FF_DEBUG_THREADS option is set.
+
+    int64_t submit_time;            ///< Time the current packet was submitted, for thread_latency_histogram.
 } PerThreadContext;
 
 /**
@@ -425,6 +428,7 @@ static int submit_packet(PerThreadContext *p, AVCodecContext *user_avctx,
         return ret;
     }
 
+    p->submit_time = av_gettime_relative();
     atomic_store(&p->state, STATE_SETTING_UP);
     pthread_cond_signal(&p->input_cond);
     pthread_mutex_unlock(&p->mutex);
@@ -528,6 +532,12 @@ int ff_thread_decode_frame(AVCodecContext *avctx,
         picture->pkt_dts = p->avpkt.dts;
         err = p->result;
 
+        if (p->got_frame) {
+            int64_t latency = av_gettime_relative() - p->submit_time;
+            int bucket      = latency > 0 ? av_log2(FFMIN(latency, UINT32_MAX)) + 1 : 0;
+            avctx->thread_latency_histogram[FFMIN(bucket, FF_THREAD_LATENCY_BUCKETS - 1)]++;
+        }
+
         /*
          * A later call with avkpt->size == 0 may loop over all threads,
          * including this one, searching for a frame/error to return before being
@@ -0,0 +1,235 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * One decoder feeding several consumers with references to the same frames.
+ */
+
+#include "libavutil/fifo.h"
+#include "libavutil/frame.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h"
+
+#include "avcodec.h"
+
+typedef struct SharedDecoderConsumer {
+    AVFifoBuffer *frames;
+} SharedDecoderConsumer;
+
+struct AVSharedDecoder {
+    AVCodecContext *avctx;
+
+    SharedDecoderConsumer *consumers;
+    int nb_consumers;
+    int max_queued;
+
+    AVFrame *frame;
+    AVFrame **refs; ///< references to frame being queued, one per consumer
+    int eof;
+
+    /* protects the frame queues and eof */
+    AVMutex lock;
+};
+
+static void clear_queue(AVFifoBuffer *fifo)
+{
+    while (av_fifo_size(fifo)) {
+        AVFrame *frame;
+        av_fifo_generic_read(fifo, &frame, sizeof(frame), NULL);
+        av_frame_free(&frame);
+    }
+}
+
+int av_shared_decoder_alloc(AVSharedDecoder **psd, AVCodecContext *avctx,
+                            int nb_consumers, int max_queued)
+{
+    AVSharedDecoder *sd;
+    int i;
+
+    *psd = NULL;
+    if (!avcodec_is_open(avctx) || !av_codec_is_decoder(avctx->codec) ||
+        nb_consumers <= 0 || max_queued < 0)
+        return AVERROR(EINVAL);
+
+    sd = av_mallocz(sizeof(*sd));
+    if (!sd)
+        return AVERROR(ENOMEM);
+
+    sd->avctx        = avctx;
+    sd->nb_consumers = nb_consumers;
+    sd->max_queued   = max_queued;
+    ff_mutex_init(&sd->lock, NULL);
+
+    sd->frame     = av_frame_alloc();
+    sd->refs      = av_mallocz_array(nb_consumers, sizeof(*sd->refs));
+    sd->consumers = av_mallocz_array(nb_consumers, sizeof(*sd->consumers));
+    if (!sd->frame || !sd->refs || !sd->consumers)
+        goto fail;
+    for (i = 0; i < nb_consumers; i++) {
+        sd->consumers[i].frames = av_fifo_alloc(FFMAX(max_queued, 4) * sizeof(AVFrame*));
+        if (!sd->consumers[i].frames)
+            goto fail;
+    }
+
+    *psd = sd;
+    return 0;
+fail:
+    av_shared_decoder_free(&sd);
+    return AVERROR(ENOMEM);
+}
+
+static int queue_frame(AVSharedDecoder *sd, AVFrame *frame)
+{
+    int i, ret = 0;
+
+    ff_mutex_lock(&sd->lock);
+    /* make room and take all the references first, so that on failure the
+     * frame is queued for none of the consumers */
+    for (i = 0; i < sd->nb_consumers; i++) {
+        AVFifoBuffer *fifo = sd->consumers[i].frames;
+
+        if (av_fifo_space(fifo) < sizeof(*sd->refs) &&
+            (ret = av_fifo_grow(fifo, av_fifo_size(fifo))) < 0)
+            break;
+
+        sd->refs[i] = av_frame_clone(frame);
+        if (!sd->refs[i]) {
+            ret = AVERROR(ENOMEM);
+            break;
+        }
+    }
+    if (ret < 0) {
+        while (i--)
+            av_frame_free(&sd->refs[i]);
+    } else {
+        for (i = 0; i < sd->nb_consumers; i++) {
+            av_fifo_generic_write(sd->consumers[i].frames, &sd->refs[i],
+                                  sizeof(*sd->refs), NULL);
+            sd->refs[i] = NULL;
+        }
+    }
+    ff_mutex_unlock(&sd->lock);
+
+    av_frame_unref(frame);
+    return ret;
+}
+
+/* Move all the frames the decoder can output right now to the queues. */
+static int drain_decoder(AVSharedDecoder *sd)
+{
+    int ret;
+
+    while ((ret = avcodec_receive_frame(sd->avctx, sd->frame)) >= 0) {
+        if ((ret = queue_frame(sd, sd->frame)) < 0)
+            return ret;
+    }
+
+    if (ret == AVERROR_EOF) {
+        ff_mutex_lock(&sd->lock);
+        sd->eof = 1;
+        ff_mutex_unlock(&sd->lock);
+    }
+    return ret == AVERROR(EAGAIN) ? 0 : ret;
+}
+
+int av_shared_decoder_send_packet(AVSharedDecoder *sd, const AVPacket *pkt)
+{
+    int i, full = 0, ret;
+
+    if (sd->max_queued) {
+        ff_mutex_lock(&sd->lock);
+        for (i = 0; i < sd->nb_consumers && !full; i++)
+            full = av_fifo_size(sd->consumers[i].frames) >=
+                   sd->max_queued * sizeof(AVFrame*);
+        ff_mutex_unlock(&sd->lock);
+        if (full)
+            return AVERROR(EAGAIN);
+    }
+
+    while ((ret = avcodec_send_packet(sd->avctx, pkt)) == AVERROR(EAGAIN)) {
+        if ((ret = drain_decoder(sd)) < 0)
+            return ret;
+    }
+    if (ret < 0)
+        return ret;
+
+    ret = drain_decoder(sd);
+    return ret == AVERROR_EOF ? 0 : ret;
+}
+
+int av_shared_decoder_receive_frame(AVSharedDecoder *sd, int consumer,
+                                    AVFrame *frame)
+{
+    AVFifoBuffer *fifo;
+    AVFrame *ref;
+    int ret = 0;
+
+    av_frame_unref(frame);
+    if (consumer < 0 || consumer >= sd->nb_consumers)
+        return AVERROR(EINVAL);
+    fifo = sd->consumers[consumer].frames;
+
+    ff_mutex_lock(&sd->lock);
+    if (av_fifo_size(fifo))
+        av_fifo_generic_read(fifo, &ref, sizeof(ref), NULL);
+    else
+        ret = sd->eof ? AVERROR_EOF : AVERROR(EAGAIN);
+    ff_mutex_unlock(&sd->lock);
+    if (ret < 0)
+        return ret;
+
+    av_frame_move_ref(frame, ref);
+    av_frame_free(&ref);
+    return 0;
+}
+
+void av_shared_decoder_flush(AVSharedDecoder *sd)
+{
+    int i;
+
+    avcodec_flush_buffers(sd->avctx);
+
+    ff_mutex_lock(&sd->lock);
+    for (i = 0; i < sd->nb_consumers; i++)
+        clear_queue(sd->consumers[i].frames);
+    sd->eof = 0;
+    ff_mutex_unlock(&sd->lock);
+}
+
+void av_shared_decoder_free(AVSharedDecoder **psd)
+{
+    AVSharedDecoder *sd = *psd;
+    int i;
+
+    if (!sd)
+        return;
+
+    if (sd->consumers) {
+        for (i = 0; i < sd->nb_consumers; i++) {
+            if (sd->consumers[i].frames)
+                clear_queue(sd->consumers[i].frames);
+            av_fifo_freep(&sd->consumers[i].frames);
+        }
+    }
+    av_freep(&sd->consumers);
+    av_freep(&sd->refs);
+    av_frame_free(&sd->frame);
+    ff_mutex_destroy(&sd->lock);
+    av_freep(psd);
+}
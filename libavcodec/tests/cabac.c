@@ -115,7 +115,9 @@ int main(void){
     CABACContext c;
     uint8_t b[9*SIZE];
     uint8_t r[9*SIZE];
-    int i, ret = 0;
+    unsigned bits[SIZE/32];
+    uint8_t unary[SIZE/32];
+    int i, j, ret = 0;
     uint8_t state[10]= {0};
     AVLFG prng;
 
@@ -135,6 +137,18 @@ int main(void){
         put_cabac(&c, state, r[i]&1);
     }
 
+    for(i=0; i<SIZE/32; i++){
+        int n = i % 25;
+        bits[i]  = av_lfg_get(&prng) & ((1U << n) - 1);
+        unary[i] = av_lfg_get(&prng) % 30;
+        for(j=n-1; j>=0; j--)
+            put_cabac_bypass(&c, (bits[i] >> j) & 1);
+        for(j=0; j<FFMIN(unary[i], 24); j++)
+            put_cabac_bypass(&c, 1);
+        if(unary[i] < 24)
+            put_cabac_bypass(&c, 0);
+    }
+
     i= put_cabac_terminate(&c, 1);
     b[i++] = av_lfg_get(&prng);
     b[i  ] = av_lfg_get(&prng);
@@ -156,6 +170,17 @@ int main(void){
             ret = 1;
         }
     }
+
+    for(i=0; i<SIZE/32; i++){
+        if(bits[i] != get_cabac_bypass_bits(&c, i % 25)) {
+            av_log(NULL, AV_LOG_ERROR, "CABAC bypass bits failure at %d\n", i);
+            ret = 1;
+        }
+        if(FFMIN(unary[i], 24) != get_cabac_bypass_unary(&c, 24)) {
+            av_log(NULL, AV_LOG_ERROR, "CABAC bypass unary failure at %d\n", i);
+            ret = 1;
+        }
+    }
     if(!get_cabac_terminate(&c)) {
         av_log(NULL, AV_LOG_ERROR, "where's the Terminator?\n");
         ret = 1;
@@ -0,0 +1,154 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "libavcodec/avcodec.h"
+#include "libavutil/error.h"
+
+#define WIDTH        16
+#define HEIGHT       16
+#define NB_FRAMES    10
+#define NB_CONSUMERS 3
+#define MAX_QUEUED   2
+
+static int make_packet(AVPacket *pkt, int n)
+{
+    int i, ret;
+
+    if ((ret = av_new_packet(pkt, WIDTH * HEIGHT)) < 0)
+        return ret;
+    for (i = 0; i < pkt->size; i++)
+        pkt->data[i] = i + n;
+    pkt->pts = n;
+    return 0;
+}
+
+/* Give every consumer all its pending frames and check they are shared. */
+static int receive_all(AVSharedDecoder *sd, AVFrame **frames, int *received)
+{
+    int i, ret;
+
+    for (;;) {
+        for (i = 0; i < NB_CONSUMERS; i++) {
+            ret = av_shared_decoder_receive_frame(sd, i, frames[i]);
+            if (ret < 0)
+                break;
+            if (frames[i]->pts != received[i] ||
+                frames[i]->data[0][0] != (uint8_t)received[i]) {
+                fprintf(stderr, "consumer %d: got frame %"PRId64", expected %d\n",
+                        i, frames[i]->pts, received[i]);
+                return AVERROR_BUG;
+            }
+            if (frames[i]->data[0] != frames[0]->data[0]) {
+                fprintf(stderr, "consumer %d: frame %d data is not shared\n",
+                        i, received[i]);
+                return AVERROR_BUG;
+            }
+            received[i]++;
+        }
+        if (i < NB_CONSUMERS) {
+            if (i) {
+                fprintf(stderr, "consumer %d is out of sync\n", i);
+                return AVERROR_BUG;
+            }
+            return ret == AVERROR(EAGAIN) ? 0 : ret;
+        }
+    }
+}
+
+int main(void)
+{
+    AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_RAWVIDEO);
+    AVCodecContext *avctx = NULL;
+    AVSharedDecoder *sd = NULL;
+    AVFrame *frames[NB_CONSUMERS] = { NULL };
+    int received[NB_CONSUMERS] = { 0 };
+    AVPacket pkt;
+    int i, n, ret;
+
+    av_init_packet(&pkt);
+    pkt.data = NULL;
+    pkt.size = 0;
+
+    if (!codec)
+        return 1;
+    avctx = avcodec_alloc_context3(codec);
+    if (!avctx)
+        return 1;
+    avctx->width   = WIDTH;
+    avctx->height  = HEIGHT;
+    avctx->pix_fmt = AV_PIX_FMT_GRAY8;
+    if ((ret = avcodec_open2(avctx, codec, NULL)) < 0)
+        goto end;
+
+    for (i = 0; i < NB_CONSUMERS; i++) {
+        frames[i] = av_frame_alloc();
+        if (!frames[i]) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+    }
+
+    if ((ret = av_shared_decoder_alloc(&sd, avctx, NB_CONSUMERS, MAX_QUEUED)) < 0)
+        goto end;
+
+    for (n = 0; n < NB_FRAMES; n++) {
+        if ((ret = make_packet(&pkt, n)) < 0)
+            goto end;
+        while ((ret = av_shared_decoder_send_packet(sd, &pkt)) == AVERROR(EAGAIN)) {
+            if ((ret = receive_all(sd, frames, received)) < 0)
+                goto end;
+        }
+        av_packet_unref(&pkt);
+        if (ret < 0)
+            goto end;
+        /* consumers fall behind, the queue limit must stop the producer */
+        if (n % 4 == 3 && (ret = receive_all(sd, frames, received)) < 0)
+            goto end;
+    }
+
+    if ((ret = av_shared_decoder_send_packet(sd, NULL)) < 0)
+        goto end;
+    ret = receive_all(sd, frames, received);
+    if (ret != AVERROR_EOF) {
+        fprintf(stderr, "missing EOF after flushing\n");
+        ret = AVERROR_BUG;
+        goto end;
+    }
+    ret = 0;
+
+    for (i = 0; i < NB_CONSUMERS; i++) {
+        if (received[i] != NB_FRAMES) {
+            fprintf(stderr, "consumer %d: received %d frames, expected %d\n",
+                    i, received[i], NB_FRAMES);
+            ret = AVERROR_BUG;
+        }
+    }
+
+end:
+    if (ret < 0)
+        fprintf(stderr, "shared decoder test failed: %s\n", av_err2str(ret));
+    av_packet_unref(&pkt);
+    av_shared_decoder_free(&sd);
+    for (i = 0; i < NB_CONSUMERS; i++)
+        av_frame_free(&frames[i]);
+    avcodec_free_context(&avctx);
+    return ret < 0;
+}
@@ -25,6 +25,7 @@
 
 %include "libavutil/x86/x86util.asm"
 
+cextern pb_1
 cextern pb_80
 
 SECTION .text
@@ -192,3 +193,122 @@ cglobal sub_left_predict, 5,6,5, dst, src, stride, width, height, x
     dec  heightd
     jg .loop
     RET
+
+
+;--------------------------------------------------------------------------------------------------
+;void sub_png_avg_pred(uint8_t *dst, const uint8_t *src, const uint8_t *top, intptr_t w, int bpp)
+;--------------------------------------------------------------------------------------------------
+
+INIT_XMM sse2
+cglobal sub_png_avg_pred, 5,5,5, dst, src, top, w, bpp
+    movsxdifnidn   bppq, bppd
+    neg            bppq
+    mova             m4, [pb_1]
+    test             wq, wq
+    jle .end
+
+.loop:
+    movu             m0, [srcq + bppq]  ; left
+    movu             m1, [topq]
+    movu             m3, [srcq]
+    pxor             m2, m0, m1
+    pavgb            m0, m1
+    pand             m2, m4
+    psubb            m0, m2             ; (left + top) >> 1
+    psubb            m3, m0
+    movu         [dstq], m3
+    add            dstq, mmsize
+    add            srcq, mmsize
+    add            topq, mmsize
+    sub              wq, mmsize
+    jg .loop
+.end:
+    RET
+
+;--------------------------------------------------------------------------------------------------
+;void sub_png_paeth_pred(uint8_t *dst, const uint8_t *src, const uint8_t *top, intptr_t w, int bpp)
+;--------------------------------------------------------------------------------------------------
+
+; compute the masks selecting a and b for 8 pixels
+; %1 offset, %2 mask a, %3 mask b, %4-%5 tmp
+%macro PAETH_MASKS 5
+    movq             %3, [srcq + bppq + %1]   ; a
+    movq             %2, [topq + %1]          ; b
+    movq             m2, [topq + bppq + %1]   ; c
+    punpcklbw        %3, m7
+    punpcklbw        %2, m7
+    punpcklbw        m2, m7
+    psubw            %2, m2                   ; b - c
+    psubw            %3, m2                   ; a - c
+    paddw            m2, %2, %3               ; a + b - 2c
+    ABS2             %2, %3, %4, %5           ; pa, pb
+    ABS1             m2, %4                   ; pc
+    pminsw           m2, %3
+    pminsw           m2, %2
+    pcmpeqw          %2, m2                   ; pa <= pb && pa <= pc
+    pcmpeqw          %3, m2                   ; pb <= pc
+%endmacro
+
+%macro SUB_PNG_PAETH_PRED 0
+cglobal sub_png_paeth_pred, 5,5,8, dst, src, top, w, bpp
+    movsxdifnidn   bppq, bppd
+    neg            bppq
+    pxor             m7, m7
+    test             wq, wq
+    jle .end
+
+.loop:
+    PAETH_MASKS       0, m4, m5, m3, m6
+    PAETH_MASKS       8, m1, m0, m3, m6
+    packsswb         m4, m1                   ; select a
+    packsswb         m5, m0                   ; select b
+    movu             m0, [topq + bppq]
+    movu             m1, [topq]
+    pand             m1, m5
+    pandn            m5, m0
+    por              m1, m5
+    movu             m0, [srcq + bppq]
+    pand             m0, m4
+    pandn            m4, m1
+    por              m0, m4
+    movu             m1, [srcq]
+    psubb            m1, m0
+    movu         [dstq], m1
+    add            dstq, mmsize
+    add            srcq, mmsize
+    add            topq, mmsize
+    sub              wq, mmsize
+    jg .loop
+.end:
+    RET
+%endmacro
+
+INIT_XMM sse2
+SUB_PNG_PAETH_PRED
+INIT_XMM ssse3
+SUB_PNG_PAETH_PRED
+
+;--------------------------------------------------------------------------------------------------
+;int sum_abs_int8(const uint8_t *src, intptr_t w)
+;--------------------------------------------------------------------------------------------------
+
+INIT_XMM sse2
+cglobal sum_abs_int8, 2,2,4, src, w
+    mova             m2, [pb_80]
+    pxor             m3, m3
+    add            srcq, wq
+    neg              wq
+    jge .end
+
+.loop:
+    movu             m0, [srcq + wq]
+    pxor             m0, m2             ; x + 128
+    psadbw           m0, m2             ; |x + 128 - 128|
+    paddd            m3, m0
+    add              wq, mmsize
+    jl .loop
+.end:
+    movhlps          m0, m3
+    paddd            m3, m0
+    movd            eax, m3
+    RET
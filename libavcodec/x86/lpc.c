@@ -87,7 +87,51 @@ static void lpc_compute_autocorr_sse2(const double *data, int len, int lag,
     if((x86_reg)data & 15)
         data++;
 
-    for(j=0; j<lag; j+=2){
+    /* four lags per pass while at least two lags are left for the tail */
+    for(j=0; lag-j >= 5 || lag-j == 3; j+=4){
+        x86_reg i = -len*sizeof(double);
+        __asm__ volatile(
+            "movsd    "MANGLE(pd_1)", %%xmm0    \n\t"
+            "movsd    "MANGLE(pd_1)", %%xmm1    \n\t"
+            "movsd    "MANGLE(pd_1)", %%xmm2    \n\t"
+            "movsd    "MANGLE(pd_1)", %%xmm3    \n\t"
+            "1:                                 \n\t"
+            "movapd    (%2,%0), %%xmm4          \n\t"
+            "movapd    (%3,%0), %%xmm5          \n\t"
+            "movupd  -8(%3,%0), %%xmm6          \n\t"
+            "movupd -24(%3,%0), %%xmm7          \n\t"
+            "mulpd      %%xmm4, %%xmm5          \n\t"
+            "mulpd      %%xmm4, %%xmm6          \n\t"
+            "mulpd      %%xmm4, %%xmm7          \n\t"
+            "mulpd  -16(%3,%0), %%xmm4          \n\t"
+            "addpd      %%xmm5, %%xmm0          \n\t"
+            "addpd      %%xmm6, %%xmm1          \n\t"
+            "addpd      %%xmm4, %%xmm2          \n\t"
+            "addpd      %%xmm7, %%xmm3          \n\t"
+            "add        $16,    %0              \n\t"
+            "jl 1b                              \n\t"
+            "movhlps    %%xmm0, %%xmm4          \n\t"
+            "movhlps    %%xmm1, %%xmm5          \n\t"
+            "movhlps    %%xmm2, %%xmm6          \n\t"
+            "movhlps    %%xmm3, %%xmm7          \n\t"
+            "addsd      %%xmm4, %%xmm0          \n\t"
+            "addsd      %%xmm5, %%xmm1          \n\t"
+            "addsd      %%xmm6, %%xmm2          \n\t"
+            "addsd      %%xmm7, %%xmm3          \n\t"
+            "movsd      %%xmm0,   (%1)          \n\t"
+            "movsd      %%xmm1,  8(%1)          \n\t"
+            "movsd      %%xmm2, 16(%1)          \n\t"
+            "movsd      %%xmm3, 24(%1)          \n\t"
+            :"+&r"(i)
+            :"r"(autoc+j), "r"(data+len), "r"(data+len-j)
+             NAMED_CONSTRAINTS_ARRAY_ADD(pd_1)
+            :XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                          "%xmm4", "%xmm5", "%xmm6", "%xmm7",)
+             "memory"
+        );
+    }
+
+    for(; j<lag; j+=2){
         x86_reg i = -len*sizeof(double);
         if(j == lag-2) {
             __asm__ volatile(
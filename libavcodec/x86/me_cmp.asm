@@ -279,6 +279,60 @@ INIT_XMM ssse3
 %define ABS_SUM_8x8 ABS_SUM_8x8_64
 HADAMARD8_DIFF 9
 
+%if HAVE_AVX2_EXTERNAL && ARCH_X86_64
+; %1 = dst, %2 = tmp, %3 = offset
+%macro DIFF_PIXELS_16 3
+    pmovzxbw        %1, [r1+%3]
+    pmovzxbw        %2, [r2+%3]
+    psubw           %1, %2
+%endmacro
+
+INIT_YMM avx2
+; transforms two horizontally adjacent 8x8 blocks at once, one in each lane,
+; and advances r1 and r2 by 8 lines
+hadamard16x8_diff %+ SUFFIX:
+    lea                          r0, [r3*3]
+    DIFF_PIXELS_16               m0, m8, 0
+    DIFF_PIXELS_16               m1, m8, r3
+    DIFF_PIXELS_16               m2, m8, r3*2
+    DIFF_PIXELS_16               m3, m8, r0
+    lea                          r1, [r1+r3*4]
+    lea                          r2, [r2+r3*4]
+    DIFF_PIXELS_16               m4, m8, 0
+    DIFF_PIXELS_16               m5, m8, r3
+    DIFF_PIXELS_16               m6, m8, r3*2
+    DIFF_PIXELS_16               m7, m8, r0
+    lea                          r1, [r1+r3*4]
+    lea                          r2, [r2+r3*4]
+    HADAMARD8
+    TRANSPOSE8x8W                 0,  1,  2,  3,  4,  5,  6,  7,  8
+    HADAMARD8
+    ABS_SUM_8x8_64                0
+    ; sum each block separately, so that the result saturates exactly like
+    ; two calls to the 8x8 version
+    vextracti128                xm1, m0, 1
+    HSUM                        xm0, xm2, eax
+    and                         eax, 0xFFFF
+    HSUM                        xm1, xm2, r0d
+    and                         r0d, 0xFFFF
+    add                         eax, r0d
+    ret
+
+cglobal hadamard8_diff16, 5, 6, 10
+    call hadamard16x8_diff %+ SUFFIX
+    mov            r5d, eax
+
+    cmp            r4d, 16
+    jne .done
+
+    call hadamard16x8_diff %+ SUFFIX
+    add            r5d, eax
+
+.done:
+    mov            eax, r5d
+    RET
+%endif
+
 ; int ff_sse*_*(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
 ;               ptrdiff_t line_size, int h)
 
@@ -525,6 +579,38 @@ SAD 16
 INIT_XMM sse2
 SAD 16
 
+%if HAVE_AVX2_EXTERNAL
+; load a 16 pixel line into each lane of m%1
+; %1 = dst, %2 = pointer, %3 = stride, %4 = offset
+%macro LOAD16x2 3-4 0
+    movu          xm%1, [%2+%4]
+    vinserti128    m%1, m%1, [%2+%3+%4], 1
+%endmacro
+
+%macro SAD_END_AVX2 1
+    vextracti128  xm0, m%1, 1
+    paddw         xm%1, xm0
+    movhlps       xm0, xm%1
+    paddw         xm%1, xm0
+    movd          eax, xm%1
+%endmacro
+
+INIT_YMM avx2
+cglobal sad16, 5, 5, 3, v, pix1, pix2, stride, h
+    pxor      m2, m2
+.loop:
+    LOAD16x2   0, pix2q, strideq
+    LOAD16x2   1, pix1q, strideq
+    psadbw    m0, m1
+    paddw     m2, m0
+    lea    pix1q, [pix1q+strideq*2]
+    lea    pix2q, [pix2q+strideq*2]
+    sub       hd, 2
+    jg .loop
+    SAD_END_AVX2 2
+    RET
+%endif
+
 ;------------------------------------------------------------------------------------------
 ;int ff_sad_x2_<opt>(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2, ptrdiff_t stride, int h);
 ;------------------------------------------------------------------------------------------
@@ -602,6 +688,25 @@ SAD_X2 16
 INIT_XMM sse2
 SAD_X2 16
 
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+cglobal sad16_x2, 5, 5, 3, v, pix1, pix2, stride, h
+    pxor      m2, m2
+.loop:
+    LOAD16x2   0, pix2q, strideq
+    LOAD16x2   1, pix2q, strideq, 1
+    pavgb     m0, m1
+    LOAD16x2   1, pix1q, strideq
+    psadbw    m0, m1
+    paddw     m2, m0
+    lea    pix1q, [pix1q+strideq*2]
+    lea    pix2q, [pix2q+strideq*2]
+    sub       hd, 2
+    jg .loop
+    SAD_END_AVX2 2
+    RET
+%endif
+
 ;------------------------------------------------------------------------------------------
 ;int ff_sad_y2_<opt>(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2, ptrdiff_t stride, int h);
 ;------------------------------------------------------------------------------------------
@@ -672,6 +777,26 @@ SAD_Y2 16
 INIT_XMM sse2
 SAD_Y2 16
 
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+cglobal sad16_y2, 5, 5, 3, v, pix1, pix2, stride, h
+    pxor      m2, m2
+.loop:
+    LOAD16x2   0, pix2q, strideq
+    add    pix2q, strideq
+    LOAD16x2   1, pix2q, strideq
+    pavgb     m0, m1
+    LOAD16x2   1, pix1q, strideq
+    psadbw    m0, m1
+    paddw     m2, m0
+    lea    pix1q, [pix1q+strideq*2]
+    add    pix2q, strideq
+    sub       hd, 2
+    jg .loop
+    SAD_END_AVX2 2
+    RET
+%endif
+
 ;-------------------------------------------------------------------------------------------
 ;int ff_sad_approx_xy2_<opt>(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2, ptrdiff_t stride, int h);
 ;-------------------------------------------------------------------------------------------
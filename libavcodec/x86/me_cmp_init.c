@@ -47,18 +47,24 @@ int ff_sad16_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                     ptrdiff_t stride, int h);
 int ff_sad16_sse2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                   ptrdiff_t stride, int h);
+int ff_sad16_avx2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
+                  ptrdiff_t stride, int h);
 int ff_sad8_x2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                       ptrdiff_t stride, int h);
 int ff_sad16_x2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                        ptrdiff_t stride, int h);
 int ff_sad16_x2_sse2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                      ptrdiff_t stride, int h);
+int ff_sad16_x2_avx2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
+                     ptrdiff_t stride, int h);
 int ff_sad8_y2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                       ptrdiff_t stride, int h);
 int ff_sad16_y2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                        ptrdiff_t stride, int h);
 int ff_sad16_y2_sse2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                      ptrdiff_t stride, int h);
+int ff_sad16_y2_avx2(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
+                     ptrdiff_t stride, int h);
 int ff_sad8_approx_xy2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
                               ptrdiff_t stride, int h);
 int ff_sad16_approx_xy2_mmxext(MpegEncContext *v, uint8_t *pix1, uint8_t *pix2,
@@ -88,6 +94,8 @@ hadamard_func(mmx)
 hadamard_func(mmxext)
 hadamard_func(sse2)
 hadamard_func(ssse3)
+int ff_hadamard8_diff16_avx2(MpegEncContext *s, uint8_t *src1,
+                             uint8_t *src2, ptrdiff_t stride, int h);
 
 #if HAVE_X86ASM
 static int nsse16_mmx(MpegEncContext *c, uint8_t *pix1, uint8_t *pix2,
@@ -648,4 +656,14 @@ av_cold void ff_me_cmp_init_x86(MECmpContext *c, AVCodecContext *avctx)
         c->hadamard8_diff[1] = ff_hadamard8_diff_ssse3;
 #endif
     }
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+#if ARCH_X86_64
+        c->hadamard8_diff[0] = ff_hadamard8_diff16_avx2;
+#endif
+        c->sad[0]        = ff_sad16_avx2;
+        c->pix_abs[0][0] = ff_sad16_avx2;
+        c->pix_abs[0][1] = ff_sad16_x2_avx2;
+        c->pix_abs[0][2] = ff_sad16_y2_avx2;
+    }
 }
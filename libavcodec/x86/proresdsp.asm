@@ -29,6 +29,8 @@
 SECTION_RODATA
 
 pw_88:      times 8 dw 0x2008
+pw_82:      times 8 dw 0x2002
+pw_4091:    times 8 dw 4091
 cextern pw_1
 cextern pw_4
 cextern pw_1019
@@ -56,6 +58,13 @@ define_constants _hi
 cglobal prores_idct_put_10, 4, 4, 15, pixels, lsize, block, qmat
     IDCT_FN    pw_1, 15, pw_88, 18, "put", pw_4, pw_1019, r3
     RET
+
+; The 12-bit C IDCT uses 17-bit coefficients, which pmaddwd cannot take, so
+; this uses the 10-bit ones with two bits less of shift. The output may differ
+; by 1, and rarely by 2 (see tests/checkasm/proresdsp.c).
+cglobal prores_idct_put_12, 4, 4, 15, pixels, lsize, block, qmat
+    IDCT_FN    pw_1, 15, pw_82, 16, "put", pw_4, pw_4091, r3
+    RET
 %endmacro
 
 INIT_XMM sse2
@@ -29,6 +29,10 @@ void ff_prores_idct_put_10_sse2(uint16_t *dst, ptrdiff_t linesize,
                                 int16_t *block, const int16_t *qmat);
 void ff_prores_idct_put_10_avx (uint16_t *dst, ptrdiff_t linesize,
                                 int16_t *block, const int16_t *qmat);
+void ff_prores_idct_put_12_sse2(uint16_t *dst, ptrdiff_t linesize,
+                                int16_t *block, const int16_t *qmat);
+void ff_prores_idct_put_12_avx (uint16_t *dst, ptrdiff_t linesize,
+                                int16_t *block, const int16_t *qmat);
 
 av_cold void ff_proresdsp_init_x86(ProresDSPContext *dsp, AVCodecContext *avctx)
 {
@@ -45,6 +49,19 @@ av_cold void ff_proresdsp_init_x86(ProresDSPContext *dsp, AVCodecContext *avctx)
             dsp->idct_permutation_type = FF_IDCT_PERM_TRANSPOSE;
             dsp->idct_put = ff_prores_idct_put_10_avx;
         }
+    } else if (avctx->bits_per_raw_sample == 12 &&
+               avctx->idct_algo == FF_IDCT_SIMPLEMMX &&
+               !(avctx->flags & AV_CODEC_FLAG_BITEXACT)) {
+        /* not bitexact, see ff_prores_idct_put_12, so only used on request */
+        if (EXTERNAL_SSE2(cpu_flags)) {
+            dsp->idct_permutation_type = FF_IDCT_PERM_TRANSPOSE;
+            dsp->idct_put = ff_prores_idct_put_12_sse2;
+        }
+
+        if (EXTERNAL_AVX(cpu_flags)) {
+            dsp->idct_permutation_type = FF_IDCT_PERM_TRANSPOSE;
+            dsp->idct_put = ff_prores_idct_put_12_avx;
+        }
     }
 #endif /* ARCH_X86_64 */
 }
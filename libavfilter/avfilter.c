@@ -192,7 +192,11 @@ int avfilter_link_get_channels(AVFilterLink *link)
 
 void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
 {
-    filter->ready = FFMAX(filter->ready, priority);
+    if (priority <= filter->ready)
+        return;
+    filter->ready = priority;
+    if (filter->graph)
+        ff_filter_graph_update_ready(filter->graph, filter);
 }
 
 /**
@@ -696,6 +700,7 @@ AVFilterContext *ff_filter_alloc(const AVFilter *filter, const char *inst_name)
     if (!ret->internal)
         goto err;
     ret->internal->execute = default_execute;
+    ret->internal->ready_index = -1;
 
     ret->nb_inputs = avfilter_pad_count(filter->inputs);
     if (ret->nb_inputs ) {
@@ -1353,7 +1358,9 @@ static int ff_filter_activate_default(AVFilterContext *filter)
      ff_avfilter_link_set_out_status().
 
    Filters are activated according to the ready field, set using the
-   ff_filter_set_ready(). Eventually, a priority queue will be used.
+   ff_filter_set_ready(). The graph keeps the ready filters in a priority
+   queue, so that finding the next filter to activate does not require
+   scanning all the filters.
    ff_filter_set_ready() is called whenever anything could cause progress to
    be possible. Marking a filter ready when it is not is not a problem,
    except for the small overhead it causes.
@@ -1426,6 +1433,8 @@ int ff_filter_activate(AVFilterContext *filter)
     av_assert1(!(filter->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC &&
                  filter->filter->activate));
     filter->ready = 0;
+    if (filter->graph)
+        ff_filter_graph_update_ready(filter->graph, filter);
     ret = filter->filter->activate ? filter->filter->activate(filter) :
           ff_filter_activate_default(filter);
     if (ret == FFERROR_NOT_READY)
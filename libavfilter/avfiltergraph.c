@@ -104,9 +104,19 @@ void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter
     int i, j;
     for (i = 0; i < graph->nb_filters; i++) {
         if (graph->filters[i] == filter) {
+            AVFilterContext *moved = graph->filters[graph->nb_filters - 1];
+
+            /* Drop the filter from the ready queue, then fix the position
+               of the filter taking its slot, since ties are broken by
+               index in the filters array. */
+            filter->ready = 0;
+            ff_filter_graph_update_ready(graph, filter);
             FFSWAP(AVFilterContext*, graph->filters[i],
                    graph->filters[graph->nb_filters - 1]);
             graph->nb_filters--;
+            moved->internal->graph_index = i;
+            if (moved->internal->ready_index >= 0)
+                ff_filter_graph_update_ready(graph, moved);
             filter->graph = NULL;
             for (j = 0; j<filter->nb_outputs; j++)
                 if (filter->outputs[j])
@@ -135,6 +145,7 @@ void avfilter_graph_free(AVFilterGraph **graph)
     av_freep(&(*graph)->resample_lavr_opts);
 #endif
     av_freep(&(*graph)->filters);
+    av_freep(&(*graph)->internal->ready_heap);
     av_freep(&(*graph)->internal);
     av_freep(graph);
 }
@@ -194,8 +205,17 @@ AVFilterContext *avfilter_graph_alloc_filter(AVFilterGraph *graph,
         avfilter_free(s);
         return NULL;
     }
-
     graph->filters = filters;
+
+    filters = av_realloc(graph->internal->ready_heap,
+                         sizeof(*filters) * (graph->nb_filters + 1));
+    if (!filters) {
+        avfilter_free(s);
+        return NULL;
+    }
+    graph->internal->ready_heap = filters;
+
+    s->internal->graph_index = graph->nb_filters;
     graph->filters[graph->nb_filters++] = s;
 
     s->graph = graph;
@@ -1394,6 +1414,89 @@ void ff_avfilter_graph_update_heap(AVFilterGraph *graph, AVFilterLink *link)
     heap_bubble_down(graph, link, link->age_index);
 }
 
+static int ready_heap_before(AVFilterContext *a, AVFilterContext *b)
+{
+    if (a->ready != b->ready)
+        return a->ready > b->ready;
+    return a->internal->graph_index < b->internal->graph_index;
+}
+
+static void ready_heap_bubble_up(AVFilterGraph *graph,
+                                 AVFilterContext *filter, int index)
+{
+    AVFilterContext **heap = graph->internal->ready_heap;
+
+    av_assert0(index >= 0);
+
+    while (index) {
+        int parent = (index - 1) >> 1;
+        if (!ready_heap_before(filter, heap[parent]))
+            break;
+        heap[index] = heap[parent];
+        heap[index]->internal->ready_index = index;
+        index = parent;
+    }
+    heap[index] = filter;
+    filter->internal->ready_index = index;
+}
+
+static void ready_heap_bubble_down(AVFilterGraph *graph,
+                                   AVFilterContext *filter, int index)
+{
+    AVFilterContext **heap = graph->internal->ready_heap;
+    int nb_ready = graph->internal->nb_ready;
+
+    av_assert0(index >= 0);
+
+    while (1) {
+        int child = 2 * index + 1;
+        if (child >= nb_ready)
+            break;
+        if (child + 1 < nb_ready &&
+            ready_heap_before(heap[child + 1], heap[child]))
+            child++;
+        if (!ready_heap_before(heap[child], filter))
+            break;
+        heap[index] = heap[child];
+        heap[index]->internal->ready_index = index;
+        index = child;
+    }
+    heap[index] = filter;
+    filter->internal->ready_index = index;
+}
+
+void ff_filter_graph_update_ready(AVFilterGraph *graph, AVFilterContext *filter)
+{
+    AVFilterGraphInternal *gi = graph->internal;
+    int index = filter->internal->ready_index;
+
+    if (!filter->ready) {
+        AVFilterContext *last;
+
+        if (index < 0)
+            return;
+        /* not ready any longer: remove the filter from the heap */
+        filter->internal->ready_index = -1;
+        last = gi->ready_heap[--gi->nb_ready];
+        if (index < gi->nb_ready) {
+            ready_heap_bubble_up  (graph, last, index);
+            ready_heap_bubble_down(graph, last, last->internal->ready_index);
+        }
+        return;
+    }
+    if (index < 0)
+        index = gi->nb_ready++;
+    ready_heap_bubble_up  (graph, filter, index);
+    ready_heap_bubble_down(graph, filter, filter->internal->ready_index);
+}
+
+unsigned ff_filter_graph_max_ready(AVFilterGraph *graph)
+{
+    AVFilterGraphInternal *gi = graph->internal;
+
+    return gi->nb_ready ? gi->ready_heap[0]->ready : 0;
+}
+
 int avfilter_graph_request_oldest(AVFilterGraph *graph)
 {
     AVFilterLink *oldest = graph->sink_links[0];
@@ -1442,14 +1545,11 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
 int ff_filter_graph_run_once(AVFilterGraph *graph)
 {
     AVFilterContext *filter;
-    unsigned i;
 
     av_assert0(graph->nb_filters);
-    filter = graph->filters[0];
-    for (i = 1; i < graph->nb_filters; i++)
-        if (graph->filters[i]->ready > filter->ready)
-            filter = graph->filters[i];
-    if (!filter->ready)
+    if (!graph->internal->nb_ready)
         return AVERROR(EAGAIN);
+    filter = graph->internal->ready_heap[0];
+    av_assert1(filter->ready);
     return ff_filter_activate(filter);
 }
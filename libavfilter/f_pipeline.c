@@ -0,0 +1,487 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Run a filter chain as a pipeline stage in its own thread.
+ *
+ * The filter chain given as option is instantiated in a private graph,
+ * between a buffer source and a buffer sink, and driven by a worker thread.
+ * Frames are carried to and from the worker through bounded message queues,
+ * so the stage runs concurrently with the rest of the graph, and with the
+ * other pipeline stages, for example the branches after a split.
+ */
+
+#include "libavutil/avassert.h"
+#include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "libavutil/threadmessage.h"
+#include "audio.h"
+#include "avfilter.h"
+#include "buffersink.h"
+#include "buffersrc.h"
+#include "filters.h"
+#include "formats.h"
+#include "internal.h"
+#include "video.h"
+
+typedef struct PipelineMessage {
+    AVFrame *frame;     ///< output frame, or NULL for a status report
+    int status;         ///< status after processing one input: 0, AVERROR_EOF or error
+} PipelineMessage;
+
+typedef struct PipelineContext {
+    const AVClass *class;
+    char *graph_str;
+    int queue_size;
+
+    AVFilterGraph *graph;
+    AVFilterContext *src;
+    AVFilterContext *sink;
+
+    AVThreadMessageQueue *in_queue;     ///< frames to the worker, NULL for EOF
+    AVThreadMessageQueue *out_queue;    ///< PipelineMessage from the worker
+    pthread_t thread;
+    int thread_started;
+
+    int pending;        ///< inputs sent to the worker and not reported yet
+    int in_status;
+    int64_t in_status_pts;
+    int eof_sent;
+} PipelineContext;
+
+#define OFFSET(x) offsetof(PipelineContext, x)
+#define DEFINE_OPTIONS(filt_name, FLAGS)                                                                                  \
+static const AVOption filt_name##_options[] = {                                                                           \
+    { "graph",      "set the filter chain run by the pipeline stage", OFFSET(graph_str),  AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS }, \
+    { "queue_size", "set the number of frames queued to the stage",   OFFSET(queue_size), AV_OPT_TYPE_INT,    {.i64=8}, 1, 1024, FLAGS },  \
+    { NULL }                                                                                                              \
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    PipelineContext *s = ctx->priv;
+
+    if (!s->graph_str) {
+        av_log(ctx, AV_LOG_ERROR, "No filter chain specified.\n");
+        return AVERROR(EINVAL);
+    }
+    return 0;
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    AVFilterLink *inlink  = ctx->inputs[0];
+    AVFilterLink *outlink = ctx->outputs[0];
+    enum AVMediaType type = inlink->type;
+    int ret;
+
+    /* The private graph converts to whatever is negotiated on the output. */
+    if ((ret = ff_formats_ref(ff_all_formats(type), &inlink->out_formats)) < 0 ||
+        (ret = ff_formats_ref(ff_all_formats(type), &outlink->in_formats)) < 0)
+        return ret;
+    if (type != AVMEDIA_TYPE_AUDIO)
+        return 0;
+    if ((ret = ff_channel_layouts_ref(ff_all_channel_layouts(), &inlink->out_channel_layouts)) < 0 ||
+        (ret = ff_channel_layouts_ref(ff_all_channel_layouts(), &outlink->in_channel_layouts)) < 0 ||
+        (ret = ff_formats_ref(ff_all_samplerates(), &inlink->out_samplerates)) < 0 ||
+        (ret = ff_formats_ref(ff_all_samplerates(), &outlink->in_samplerates)) < 0)
+        return ret;
+    return 0;
+}
+
+static void free_in_message(void *msg)
+{
+    av_frame_free(msg);
+}
+
+static void free_out_message(void *msg)
+{
+    PipelineMessage *m = msg;
+    av_frame_free(&m->frame);
+}
+
+static void *worker(void *arg)
+{
+    AVFilterContext *ctx = arg;
+    PipelineContext *s = ctx->priv;
+    PipelineMessage msg;
+    AVFrame *in;
+    int ret;
+
+    while (1) {
+        ret = av_thread_message_queue_recv(s->in_queue, &in, 0);
+        if (ret < 0)
+            break;
+
+        ret = av_buffersrc_add_frame_flags(s->src, in, AV_BUFFERSRC_FLAG_PUSH);
+        av_frame_free(&in);
+
+        while (ret >= 0) {
+            msg.frame  = av_frame_alloc();
+            msg.status = 0;
+            if (!msg.frame) {
+                ret = AVERROR(ENOMEM);
+                break;
+            }
+            ret = av_buffersink_get_frame(s->sink, msg.frame);
+            if (ret < 0) {
+                av_frame_free(&msg.frame);
+                break;
+            }
+            ret = av_thread_message_queue_send(s->out_queue, &msg, 0);
+            if (ret < 0) {
+                av_frame_free(&msg.frame);
+                return NULL;
+            }
+        }
+
+        msg.frame  = NULL;
+        msg.status = ret == AVERROR(EAGAIN) ? 0 : ret;
+        if (av_thread_message_queue_send(s->out_queue, &msg, 0) < 0 ||
+            msg.status < 0)
+            break;
+    }
+    return NULL;
+}
+
+static int config_graph(AVFilterContext *ctx)
+{
+    PipelineContext *s = ctx->priv;
+    AVFilterLink *inlink  = ctx->inputs[0];
+    AVFilterLink *outlink = ctx->outputs[0];
+    int video = inlink->type == AVMEDIA_TYPE_VIDEO;
+    AVBufferSrcParameters *par;
+    AVFilterInOut *outputs = NULL, *inputs = NULL;
+    int ret;
+
+    s->graph = avfilter_graph_alloc();
+    if (!s->graph)
+        return AVERROR(ENOMEM);
+
+    s->src  = avfilter_graph_alloc_filter(s->graph,
+                                          avfilter_get_by_name(video ? "buffer" : "abuffer"),
+                                          "in");
+    s->sink = avfilter_graph_alloc_filter(s->graph,
+                                          avfilter_get_by_name(video ? "buffersink" : "abuffersink"),
+                                          "out");
+    par = av_buffersrc_parameters_alloc();
+    if (!s->src || !s->sink || !par) {
+        av_free(par);
+        return AVERROR(ENOMEM);
+    }
+
+    par->format    = inlink->format;
+    par->time_base = inlink->time_base;
+    if (video) {
+        par->width               = inlink->w;
+        par->height              = inlink->h;
+        par->sample_aspect_ratio = inlink->sample_aspect_ratio;
+        par->frame_rate          = inlink->frame_rate;
+        par->hw_frames_ctx       = inlink->hw_frames_ctx;
+    } else {
+        par->sample_rate    = inlink->sample_rate;
+        par->channel_layout = inlink->channel_layout;
+    }
+    ret = av_buffersrc_parameters_set(s->src, par);
+    av_free(par);
+    if (ret < 0)
+        return ret;
+    if ((ret = avfilter_init_str(s->src, NULL)) < 0)
+        return ret;
+
+    if (video) {
+        enum AVPixelFormat pix_fmts[] = { outlink->format, AV_PIX_FMT_NONE };
+        ret = av_opt_set_int_list(s->sink, "pix_fmts", pix_fmts,
+                                  AV_PIX_FMT_NONE, AV_OPT_SEARCH_CHILDREN);
+    } else {
+        enum AVSampleFormat sample_fmts[] = { outlink->format, AV_SAMPLE_FMT_NONE };
+        int64_t channel_layouts[] = { outlink->channel_layout, -1 };
+        int sample_rates[] = { outlink->sample_rate, -1 };
+        if ((ret = av_opt_set_int_list(s->sink, "sample_fmts", sample_fmts,
+                                       AV_SAMPLE_FMT_NONE, AV_OPT_SEARCH_CHILDREN)) < 0 ||
+            (ret = av_opt_set_int_list(s->sink, "channel_layouts", channel_layouts,
+                                       -1, AV_OPT_SEARCH_CHILDREN)) < 0)
+            return ret;
+        ret = av_opt_set_int_list(s->sink, "sample_rates", sample_rates,
+                                  -1, AV_OPT_SEARCH_CHILDREN);
+    }
+    if (ret < 0)
+        return ret;
+    if ((ret = avfilter_init_str(s->sink, NULL)) < 0)
+        return ret;
+
+    outputs = avfilter_inout_alloc();
+    inputs  = avfilter_inout_alloc();
+    if (!outputs || !inputs) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    outputs->name       = av_strdup("in");
+    outputs->filter_ctx = s->src;
+    outputs->pad_idx    = 0;
+    outputs->next       = NULL;
+    inputs->name        = av_strdup("out");
+    inputs->filter_ctx  = s->sink;
+    inputs->pad_idx     = 0;
+    inputs->next        = NULL;
+
+    if ((ret = avfilter_graph_parse_ptr(s->graph, s->graph_str,
+                                        &inputs, &outputs, ctx)) < 0 ||
+        (ret = avfilter_graph_config(s->graph, ctx)) < 0)
+        goto end;
+
+    outlink->time_base = av_buffersink_get_time_base(s->sink);
+    if (video) {
+        AVBufferRef *hw_frames_ctx = av_buffersink_get_hw_frames_ctx(s->sink);
+
+        outlink->w                   = av_buffersink_get_w(s->sink);
+        outlink->h                   = av_buffersink_get_h(s->sink);
+        outlink->sample_aspect_ratio = av_buffersink_get_sample_aspect_ratio(s->sink);
+        outlink->frame_rate          = av_buffersink_get_frame_rate(s->sink);
+        if (hw_frames_ctx) {
+            outlink->hw_frames_ctx = av_buffer_ref(hw_frames_ctx);
+            if (!outlink->hw_frames_ctx)
+                ret = AVERROR(ENOMEM);
+        }
+    }
+
+end:
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    return ret;
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    PipelineContext *s = ctx->priv;
+    int ret;
+
+    if (s->graph) {
+        av_log(ctx, AV_LOG_ERROR, "Reconfiguring the pipeline is not supported.\n");
+        return AVERROR_PATCHWELCOME;
+    }
+
+    if ((ret = config_graph(ctx)) < 0)
+        return ret;
+
+    if ((ret = av_thread_message_queue_alloc(&s->in_queue, s->queue_size,
+                                             sizeof(AVFrame *))) < 0 ||
+        (ret = av_thread_message_queue_alloc(&s->out_queue, s->queue_size,
+                                             sizeof(PipelineMessage))) < 0)
+        return ret;
+    av_thread_message_queue_set_free_func(s->in_queue,  free_in_message);
+    av_thread_message_queue_set_free_func(s->out_queue, free_out_message);
+
+    ret = pthread_create(&s->thread, NULL, worker, ctx);
+    if (ret) {
+        av_log(ctx, AV_LOG_ERROR, "Unable to start the pipeline thread.\n");
+        return AVERROR(ret);
+    }
+    s->thread_started = 1;
+    return 0;
+}
+
+/**
+ * Ready value used to poll the worker: below any activation requested by the
+ * framework, so that every other runnable filter goes first.
+ */
+#define POLL_PRIORITY 1
+
+/* Tell if a filter of the graph other than a polling stage can make progress. */
+static int graph_has_work(AVFilterContext *ctx)
+{
+    return ctx->graph && ff_filter_graph_max_ready(ctx->graph) > POLL_PRIORITY;
+}
+
+static int handle_message(AVFilterContext *ctx, PipelineMessage *msg)
+{
+    PipelineContext *s = ctx->priv;
+    AVFilterLink *inlink  = ctx->inputs[0];
+    AVFilterLink *outlink = ctx->outputs[0];
+
+    if (msg->frame)
+        return ff_filter_frame(outlink, msg->frame);
+
+    s->pending--;
+    if (msg->status == AVERROR_EOF) {
+        ff_outlink_set_status(outlink, s->in_status,
+                              av_rescale_q(s->in_status_pts, inlink->time_base,
+                                           outlink->time_base));
+        return 0;
+    }
+    return msg->status;
+}
+
+static int activate(AVFilterContext *ctx)
+{
+    PipelineContext *s = ctx->priv;
+    AVFilterLink *inlink  = ctx->inputs[0];
+    AVFilterLink *outlink = ctx->outputs[0];
+    PipelineMessage msg;
+    AVFrame *frame;
+    int ret;
+
+    FF_FILTER_FORWARD_STATUS_BACK(outlink, inlink);
+
+    /* Feed the worker as long as its queue has room, without blocking. */
+    while (!s->eof_sent &&
+           av_thread_message_queue_nb_elems(s->in_queue) < s->queue_size) {
+        if (ff_inlink_check_available_frame(inlink)) {
+            ret = ff_inlink_consume_frame(inlink, &frame);
+            if (ret < 0)
+                return ret;
+        } else {
+            if (!s->in_status &&
+                !ff_inlink_acknowledge_status(inlink, &s->in_status, &s->in_status_pts))
+                break;
+            frame = NULL;
+            s->eof_sent = 1;
+        }
+        ret = av_thread_message_queue_send(s->in_queue, &frame,
+                                           AV_THREAD_MESSAGE_NONBLOCK);
+        if (ret < 0) {
+            av_frame_free(&frame);
+            return ret;
+        }
+        s->pending++;
+    }
+
+    /* Forward whatever the worker already produced. */
+    while ((ret = av_thread_message_queue_recv(s->out_queue, &msg,
+                                               AV_THREAD_MESSAGE_NONBLOCK)) >= 0) {
+        ret = handle_message(ctx, &msg);
+        if (ret < 0 || ff_outlink_get_status(outlink))
+            return ret;
+    }
+    if (ret != AVERROR(EAGAIN))
+        return ret;
+
+    if (ff_outlink_frame_wanted(outlink)) {
+        if (s->pending) {
+            /* The worker still owes output. Let the rest of the graph,
+             * including the other pipeline stages, run in the meantime,
+             * and only wait when nothing else can make progress. */
+            if (graph_has_work(ctx)) {
+                ff_filter_set_ready(ctx, POLL_PRIORITY);
+                return 0;
+            }
+            ret = av_thread_message_queue_recv(s->out_queue, &msg, 0);
+            if (ret < 0)
+                return ret;
+            ret = handle_message(ctx, &msg);
+            if (ret < 0)
+                return ret;
+            ff_filter_set_ready(ctx, 100);
+            return 0;
+        }
+        if (!s->in_status) {
+            ff_inlink_request_frame(inlink);
+            return 0;
+        }
+    }
+
+    return FFERROR_NOT_READY;
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    PipelineContext *s = ctx->priv;
+
+    if (s->thread_started) {
+        av_thread_message_queue_set_err_recv(s->in_queue,  AVERROR_EOF);
+        av_thread_message_queue_set_err_send(s->out_queue, AVERROR_EOF);
+        pthread_join(s->thread, NULL);
+        s->thread_started = 0;
+    }
+    av_thread_message_queue_free(&s->in_queue);
+    av_thread_message_queue_free(&s->out_queue);
+    avfilter_graph_free(&s->graph);
+}
+
+#if CONFIG_PIPELINE_FILTER
+DEFINE_OPTIONS(pipeline, AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM);
+AVFILTER_DEFINE_CLASS(pipeline);
+
+static const AVFilterPad pipeline_inputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_VIDEO,
+    },
+    { NULL }
+};
+
+static const AVFilterPad pipeline_outputs[] = {
+    {
+        .name         = "default",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_output,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_pipeline = {
+    .name          = "pipeline",
+    .description   = NULL_IF_CONFIG_SMALL("Run a filter chain in its own thread."),
+    .priv_size     = sizeof(PipelineContext),
+    .priv_class    = &pipeline_class,
+    .init          = init,
+    .uninit        = uninit,
+    .query_formats = query_formats,
+    .activate      = activate,
+    .inputs        = pipeline_inputs,
+    .outputs       = pipeline_outputs,
+    .flags_internal = FF_FILTER_FLAG_HWFRAME_AWARE,
+};
+#endif /* CONFIG_PIPELINE_FILTER */
+
+#if CONFIG_APIPELINE_FILTER
+DEFINE_OPTIONS(apipeline, AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_AUDIO_PARAM);
+AVFILTER_DEFINE_CLASS(apipeline);
+
+static const AVFilterPad apipeline_inputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_AUDIO,
+    },
+    { NULL }
+};
+
+static const AVFilterPad apipeline_outputs[] = {
+    {
+        .name         = "default",
+        .type         = AVMEDIA_TYPE_AUDIO,
+        .config_props = config_output,
+    },
+    { NULL }
+};
+
+AVFilter ff_af_apipeline = {
+    .name          = "apipeline",
+    .description   = NULL_IF_CONFIG_SMALL("Run a filter chain in its own thread."),
+    .priv_size     = sizeof(PipelineContext),
+    .priv_class    = &apipeline_class,
+    .init          = init,
+    .uninit        = uninit,
+    .query_formats = query_formats,
+    .activate      = activate,
+    .inputs        = apipeline_inputs,
+    .outputs       = apipeline_outputs,
+};
+#endif /* CONFIG_APIPELINE_FILTER */
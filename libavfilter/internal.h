@@ -48,6 +48,18 @@ typedef struct AVFilterCommand {
  */
 void ff_avfilter_graph_update_heap(AVFilterGraph *graph, AVFilterLink *link);
 
+/**
+ * Update the position of a filter in the ready queue of the graph after
+ * its ready field changed; a filter with ready == 0 is removed from it.
+ */
+void ff_filter_graph_update_ready(AVFilterGraph *graph, AVFilterContext *filter);
+
+/**
+ * Get the highest ready value of the filters of the graph, 0 if no filter
+ * can make progress.
+ */
+unsigned ff_filter_graph_max_ready(AVFilterGraph *graph);
+
 /**
  * A filter pad used for either input or output.
  */
@@ -149,10 +161,29 @@ struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+
+    /**
+     * Filters with a non-zero ready value, organized as a binary heap
+     * ordered by decreasing ready value, then by increasing index in
+     * AVFilterGraph.filters. Allocated with the same size as filters.
+     */
+    AVFilterContext **ready_heap;
+    unsigned nb_ready;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+
+    /**
+     * Index of the filter in AVFilterGraph.filters.
+     */
+    unsigned graph_index;
+
+    /**
+     * Index of the filter in AVFilterGraphInternal.ready_heap,
+     * -1 if it is not ready.
+     */
+    int ready_index;
 };
 
 /**
@@ -140,6 +140,18 @@ int ffio_fdopen(AVIOContext **s, URLContext *h);
  */
 URLContext *ffio_geturlcontext(AVIOContext *s);
 
+/**
+ * Read size bytes as a reference to the data of the underlying protocol,
+ * without copying them, if the protocol supports it (see ffurl_get_buffer()).
+ * The returned data is read-only and followed by AV_INPUT_BUFFER_PADDING_SIZE
+ * zero bytes.
+ *
+ * @return size on success, in which case the position of s is advanced by
+ *         size bytes; a negative error code, in particular AVERROR(ENOSYS)
+ *         when not supported, in which case nothing is read.
+ */
+int ffio_read_buffer_ref(AVIOContext *s, AVBufferRef **buf, int size);
+
 /**
  * Open a write-only fake memory stream. The written data is not stored
  * anywhere - this is only used for measuring the amount of data
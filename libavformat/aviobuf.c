@@ -1036,6 +1036,39 @@ fail:
     return AVERROR(ENOMEM);
 }
 
+int ffio_read_buffer_ref(AVIOContext *s, AVBufferRef **buf, int size)
+{
+    URLContext *h = ffio_geturlcontext(s);
+    int64_t pos, offset1;
+    int ret;
+
+    if (!h || s->write_flag || s->update_checksum || size <= 0)
+        return AVERROR(ENOSYS);
+
+    pos = avio_tell(s);
+    ret = ffurl_get_buffer(h, pos, size, buf);
+    if (ret < 0)
+        return ret;
+
+    /* skip the data in the buffer, or reposition the protocol past it
+     * without reading it */
+    offset1 = pos + size - (s->pos - (s->buf_end - s->buffer));
+    if (offset1 <= s->buf_end - s->buffer) {
+        s->buf_ptr = s->buffer + offset1;
+    } else {
+        int64_t res = s->seek(s->opaque, pos + size, SEEK_SET);
+        if (res < 0) {
+            av_buffer_unref(buf);
+            return res;
+        }
+        s->buf_end = s->buf_ptr = s->buf_ptr_max = s->buffer;
+        s->pos = pos + size;
+    }
+    s->eof_reached = 0;
+    s->bytes_read += size;
+    return size;
+}
+
 URLContext* ffio_geturlcontext(AVIOContext *s)
 {
     AVIOInternal *internal;
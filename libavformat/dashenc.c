@@ -55,6 +55,14 @@ typedef enum {
     SEGMENT_TYPE_NB
 } SegmentType;
 
+typedef enum {
+    FRAG_TYPE_NONE = 0,
+    FRAG_TYPE_EVERY_FRAME,
+    FRAG_TYPE_GOP,
+    FRAG_TYPE_FRAMES,
+    FRAG_TYPE_NB
+} FragmentType;
+
 typedef struct Segment {
     char file[1024];
     int64_t start_pos;
@@ -99,6 +107,9 @@ typedef struct OutputStream {
     double availability_time_offset;
     int total_pkt_size;
     int muxer_overhead;
+    int64_t frag_start_pts;     /* start of the current fragment */
+    int nb_frag_packets;        /* packets in the current fragment */
+    int64_t max_frag_duration;  /* longest fragment so far, in AV_TIME_BASE */
 } OutputStream;
 
 typedef struct DASHContext {
@@ -139,6 +150,12 @@ typedef struct DASHContext {
     char *format_options_str;
     SegmentType segment_type_option;  /* segment type as specified in options */
     int ignore_io_errors;
+    int frag_type;
+    int frag_frames;
+    int ldash;
+    int64_t frag_start_time;  /* start of the last fragment of a video stream */
+    uint8_t *mpd_buf;         /* last manifest written, without publishTime */
+    int mpd_buf_size;
 } DASHContext;
 
 static struct codec_string {
@@ -454,6 +471,7 @@ static void dash_free(AVFormatContext *s)
         av_freep(&os->media_seg_name);
     }
     av_freep(&c->streams);
+    av_freep(&c->mpd_buf);
 
     ff_format_io_close(s, &c->mpd_out);
     ff_format_io_close(s, &c->m3u8_out);
@@ -477,6 +495,8 @@ static void output_segment_list(OutputStream *os, AVIOContext *out, AVFormatCont
             if (c->streaming && os->availability_time_offset)
                 avio_printf(out, "availabilityTimeOffset=\"%.3f\" ",
                             os->availability_time_offset);
+            if (c->ldash && os->availability_time_offset)
+                avio_printf(out, "availabilityTimeComplete=\"false\" ");
         }
         avio_printf(out, "initialization=\"%s\" media=\"%s\" startNumber=\"%d\">\n", os->init_seg_name, os->media_seg_name, c->use_timeline ? start_number : 1);
         if (c->use_timeline) {
@@ -840,17 +860,27 @@ end:
     return 0;
 }
 
-static int write_manifest(AVFormatContext *s, int final)
+/*
+ * Upload the manifest in buf, unless only its publishTime (publish_len bytes
+ * at publish_pos) differs from the one uploaded before.
+ */
+static int publish_manifest(AVFormatContext *s, uint8_t *buf, int size,
+                            int publish_pos, int publish_len, int final)
 {
     DASHContext *c = s->priv_data;
-    AVIOContext *out;
     char temp_filename[1024];
-    int ret, i;
+    int ret, stripped_size = size - publish_len;
     const char *proto = avio_find_protocol_name(s->url);
     int use_rename = proto && !strcmp(proto, "file");
     static unsigned int warned_non_file = 0;
-    AVDictionaryEntry *title = av_dict_get(s->metadata, "title", NULL, 0);
     AVDictionary *opts = NULL;
+    uint8_t *stripped;
+
+    if (!final && c->mpd_buf && c->mpd_buf_size == stripped_size &&
+        !memcmp(c->mpd_buf, buf, publish_pos) &&
+        !memcmp(c->mpd_buf + publish_pos, buf + publish_pos + publish_len,
+                size - publish_pos - publish_len))
+        return 0;
 
     if (!use_rename && !warned_non_file++)
         av_log(s, AV_LOG_ERROR, "Cannot use rename on non file protocol, this may lead to races and temporary partial files\n");
@@ -859,10 +889,50 @@ static int write_manifest(AVFormatContext *s, int final)
     set_http_options(&opts, c);
     ret = dashenc_io_open(s, &c->mpd_out, temp_filename, &opts);
     av_dict_free(&opts);
-    if (ret < 0) {
+    if (ret < 0)
         return handle_io_open_error(s, ret, temp_filename);
+    avio_write(c->mpd_out, buf, size);
+    avio_flush(c->mpd_out);
+    ret = c->mpd_out->error;
+    dashenc_io_close(s, &c->mpd_out, temp_filename);
+    if (ret < 0)
+        return ret;
+
+    if (use_rename) {
+        if ((ret = avpriv_io_move(temp_filename, s->url)) < 0)
+            return ret;
     }
-    out = c->mpd_out;
+
+    /* only remember the manifest once it was published, so that a failed
+     * upload is retried with the next update */
+    stripped = av_malloc(stripped_size);
+    if (!stripped)
+        return AVERROR(ENOMEM);
+    memcpy(stripped, buf, publish_pos);
+    memcpy(stripped + publish_pos, buf + publish_pos + publish_len,
+           size - publish_pos - publish_len);
+    av_free(c->mpd_buf);
+    c->mpd_buf      = stripped;
+    c->mpd_buf_size = stripped_size;
+    return 0;
+}
+
+static int write_manifest(AVFormatContext *s, int final)
+{
+    DASHContext *c = s->priv_data;
+    AVIOContext *out;
+    char temp_filename[1024];
+    int ret, i, size, publish_pos = 0, publish_len = 0;
+    uint8_t *buf;
+    const char *proto = avio_find_protocol_name(s->url);
+    int use_rename = proto && !strcmp(proto, "file");
+    AVDictionaryEntry *title = av_dict_get(s->metadata, "title", NULL, 0);
+    AVDictionary *opts = NULL;
+    int64_t last_duration = c->last_duration ? c->last_duration : c->seg_duration;
+
+    // The manifest is rendered in memory and only uploaded when it changed.
+    if ((ret = avio_open_dyn_buf(&out)) < 0)
+        return ret;
     avio_printf(out, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n");
     avio_printf(out, "<MPD xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\"\n"
                 "\txmlns=\"urn:mpeg:dash:schema:mpd:2011\"\n"
@@ -875,25 +945,28 @@ static int write_manifest(AVFormatContext *s, int final)
         write_time(out, c->total_duration);
         avio_printf(out, "\"\n");
     } else {
-        int64_t update_period = c->last_duration / AV_TIME_BASE;
+        int64_t update_period = last_duration / AV_TIME_BASE;
         char now_str[100];
         if (c->use_template && !c->use_timeline)
             update_period = 500;
         avio_printf(out, "\tminimumUpdatePeriod=\"PT%"PRId64"S\"\n", update_period);
-        avio_printf(out, "\tsuggestedPresentationDelay=\"PT%"PRId64"S\"\n", c->last_duration / AV_TIME_BASE);
+        avio_printf(out, "\tsuggestedPresentationDelay=\"PT%"PRId64"S\"\n", last_duration / AV_TIME_BASE);
         if (c->availability_start_time[0])
             avio_printf(out, "\tavailabilityStartTime=\"%s\"\n", c->availability_start_time);
         format_date_now(now_str, sizeof(now_str));
-        if (now_str[0])
+        if (now_str[0]) {
+            publish_pos = avio_tell(out);
             avio_printf(out, "\tpublishTime=\"%s\"\n", now_str);
+            publish_len = avio_tell(out) - publish_pos;
+        }
         if (c->window_size && c->use_template) {
             avio_printf(out, "\ttimeShiftBufferDepth=\"");
-            write_time(out, c->last_duration * c->window_size);
+            write_time(out, last_duration * c->window_size);
             avio_printf(out, "\"\n");
         }
     }
     avio_printf(out, "\tminBufferTime=\"");
-    write_time(out, c->last_duration * 2);
+    write_time(out, last_duration * 2);
     avio_printf(out, "\">\n");
     avio_printf(out, "\t<ProgramInformation>\n");
     if (title) {
@@ -915,8 +988,10 @@ static int write_manifest(AVFormatContext *s, int final)
     }
 
     for (i = 0; i < c->nb_as; i++) {
-        if ((ret = write_adaptation_set(s, out, i, final)) < 0)
+        if ((ret = write_adaptation_set(s, out, i, final)) < 0) {
+            ffio_free_dyn_buf(&out);
             return ret;
+        }
     }
     avio_printf(out, "\t</Period>\n");
 
@@ -924,13 +999,11 @@ static int write_manifest(AVFormatContext *s, int final)
         avio_printf(out, "\t<UTCTiming schemeIdUri=\"urn:mpeg:dash:utc:http-xsdate:2014\" value=\"%s\"/>\n", c->utc_timing_url);
 
     avio_printf(out, "</MPD>\n");
-    avio_flush(out);
-    dashenc_io_close(s, &c->mpd_out, temp_filename);
-
-    if (use_rename) {
-        if ((ret = avpriv_io_move(temp_filename, s->url)) < 0)
-            return ret;
-    }
+    size = avio_close_dyn_buf(out, &buf);
+    ret = publish_manifest(s, buf, size, publish_pos, publish_len, final);
+    av_free(buf);
+    if (ret < 0)
+        return ret;
 
     if (c->hls_playlist && !c->master_playlist_created) {
         char filename_hls[1024];
@@ -1033,6 +1106,31 @@ static int dash_init(AVFormatContext *s)
     if (c->single_file)
         c->use_template = 0;
 
+    if (c->ldash) {
+        if (!c->use_template) {
+            av_log(s, AV_LOG_WARNING, "Low latency mode needs use_template, ldash ignored\n");
+            c->ldash = 0;
+        } else {
+            // Early availability is only signaled with SegmentTemplate@duration,
+            // which also keeps the manifest unchanged from one segment to the next.
+            if (c->use_timeline) {
+                av_log(s, AV_LOG_WARNING, "use_timeline is disabled in low latency mode\n");
+                c->use_timeline = 0;
+            }
+            c->streaming = 1;
+            if (!c->utc_timing_url)
+                av_log(s, AV_LOG_WARNING, "utc_timing_url is not set, clients may "
+                       "not find the live edge in low latency mode\n");
+        }
+    }
+    if (c->frag_type < 0)
+        c->frag_type = c->streaming ? FRAG_TYPE_EVERY_FRAME : FRAG_TYPE_NONE;
+    if (c->frag_type == FRAG_TYPE_FRAMES && c->frag_frames <= 0) {
+        av_log(s, AV_LOG_ERROR, "frag_frames must be set with frag_type frames\n");
+        return AVERROR(EINVAL);
+    }
+    c->frag_start_time = AV_NOPTS_VALUE;
+
 #if FF_API_DASH_MIN_SEG_DURATION
     if (c->min_seg_duration != 5000000) {
         av_log(s, AV_LOG_WARNING, "The min_seg_duration option is deprecated and will be removed. Please use the -seg_duration\n");
@@ -1161,8 +1259,11 @@ static int dash_init(AVFormatContext *s)
         }
 
         if (os->segment_type == SEGMENT_TYPE_MP4) {
-            if (c->streaming)
+            // A sidx would only index the first fragment of a segment
+            if (c->frag_type == FRAG_TYPE_EVERY_FRAME)
                 av_dict_set(&opts, "movflags", "frag_every_frame+dash+delay_moov+skip_sidx", 0);
+            else if (c->streaming || c->frag_type != FRAG_TYPE_NONE)
+                av_dict_set(&opts, "movflags", "frag_custom+dash+delay_moov+skip_sidx", 0);
             else
                 av_dict_set(&opts, "movflags", "frag_custom+dash+delay_moov", 0);
         } else {
@@ -1501,6 +1602,56 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
     return ret;
 }
 
+/* Check if pkt starts a new moof fragment within the current segment. */
+static int is_fragment_start(AVFormatContext *s, OutputStream *os,
+                             AVStream *st, const AVPacket *pkt)
+{
+    DASHContext *c = s->priv_data;
+
+    if (os->segment_type != SEGMENT_TYPE_MP4 || !os->packets_written ||
+        pkt->pts == AV_NOPTS_VALUE)
+        return 0;
+
+    switch (c->frag_type) {
+    case FRAG_TYPE_GOP:
+        if (!c->has_video || st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+            return !!(pkt->flags & AV_PKT_FLAG_KEY);
+        // Other streams follow the fragments of the video streams.
+        return c->frag_start_time != AV_NOPTS_VALUE &&
+               av_compare_ts(os->frag_start_pts, st->time_base,
+                             c->frag_start_time, AV_TIME_BASE_Q) < 0 &&
+               av_compare_ts(pkt->pts, st->time_base,
+                             c->frag_start_time, AV_TIME_BASE_Q) >= 0;
+    case FRAG_TYPE_FRAMES:
+        return os->nb_frag_packets >= c->frag_frames;
+    }
+    return 0;
+}
+
+static int flush_fragment(AVFormatContext *s, OutputStream *os,
+                          AVStream *st, const AVPacket *pkt)
+{
+    DASHContext *c = s->priv_data;
+    int64_t frag_duration = av_rescale_q(pkt->pts - os->frag_start_pts,
+                                         st->time_base, AV_TIME_BASE_Q);
+    int ret;
+
+    if ((ret = av_write_frame(os->ctx, NULL)) < 0)
+        return ret;
+
+    // A segment can be requested as soon as its first fragment is complete.
+    if (frag_duration > os->max_frag_duration) {
+        os->max_frag_duration = frag_duration;
+        os->availability_time_offset = FFMAX(c->seg_duration - frag_duration, 0) /
+                                       (double) AV_TIME_BASE;
+    }
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+        c->frag_start_time = av_rescale_q(pkt->pts, st->time_base, AV_TIME_BASE_Q);
+    os->frag_start_pts  = pkt->pts;
+    os->nb_frag_packets = 0;
+    return 0;
+}
+
 static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
 {
     DASHContext *c = s->priv_data;
@@ -1539,7 +1690,8 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
         format_date_now(c->availability_start_time,
                         sizeof(c->availability_start_time));
 
-    if (!os->availability_time_offset && pkt->duration) {
+    if (c->frag_type == FRAG_TYPE_EVERY_FRAME &&
+        !os->availability_time_offset && pkt->duration) {
         int64_t frame_duration = av_rescale_q(pkt->duration, st->time_base,
                                               AV_TIME_BASE_Q);
          os->availability_time_offset = ((double) c->seg_duration -
@@ -1588,19 +1740,37 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
             os->start_pts = os->max_pts;
         else
             os->start_pts = pkt->pts;
+        os->frag_start_pts  = os->start_pts;
+        os->nb_frag_packets = 0;
+    } else if (is_fragment_start(s, os, st, pkt)) {
+        if ((ret = flush_fragment(s, os, st, pkt)) < 0)
+            return ret;
     }
     if (os->max_pts == AV_NOPTS_VALUE)
         os->max_pts = pkt->pts + pkt->duration;
     else
         os->max_pts = FFMAX(os->max_pts, pkt->pts + pkt->duration);
     os->packets_written++;
+    os->nb_frag_packets++;
     os->total_pkt_size += pkt->size;
     if ((ret = ff_write_chained(os->ctx, 0, pkt, s, 0)) < 0)
         return ret;
 
-    if (!os->init_range_length)
+    if (!os->init_range_length) {
         flush_init_segment(s, os);
 
+        // In low latency mode, publish the manifest as soon as all the
+        // initialization segments are written, not after the first segment.
+        if (c->ldash) {
+            int i;
+            for (i = 0; i < s->nb_streams; i++)
+                if (!c->streams[i].init_range_length)
+                    break;
+            if (i == s->nb_streams && (ret = write_manifest(s, 0)) < 0)
+                return ret;
+        }
+    }
+
     //open the output context when the first frame of a segment is ready
     if (!c->single_file && os->packets_written == 1) {
         AVDictionary *opts = NULL;
@@ -1745,6 +1915,14 @@ static const AVOption options[] = {
     { "mp4", "make segment file in ISOBMFF format", 0, AV_OPT_TYPE_CONST, {.i64 = SEGMENT_TYPE_MP4 }, 0, UINT_MAX,   E, "segment_type"},
     { "webm", "make segment file in WebM format", 0, AV_OPT_TYPE_CONST, {.i64 = SEGMENT_TYPE_WEBM }, 0, UINT_MAX,   E, "segment_type"},
     { "ignore_io_errors", "Ignore IO errors during open and write. Useful for long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "frag_type", "set the interval of the moof fragments in mp4 segments", OFFSET(frag_type), AV_OPT_TYPE_INT, {.i64 = -1 }, -1, FRAG_TYPE_NB - 1, E, "frag_type"},
+    { "auto", "every_frame in streaming mode, none otherwise", 0, AV_OPT_TYPE_CONST, {.i64 = -1 }, 0, UINT_MAX, E, "frag_type"},
+    { "none", "one fragment per segment", 0, AV_OPT_TYPE_CONST, {.i64 = FRAG_TYPE_NONE }, 0, UINT_MAX, E, "frag_type"},
+    { "every_frame", "one fragment per frame", 0, AV_OPT_TYPE_CONST, {.i64 = FRAG_TYPE_EVERY_FRAME }, 0, UINT_MAX, E, "frag_type"},
+    { "gop", "one fragment per group of pictures", 0, AV_OPT_TYPE_CONST, {.i64 = FRAG_TYPE_GOP }, 0, UINT_MAX, E, "frag_type"},
+    { "frames", "one fragment every frag_frames frames", 0, AV_OPT_TYPE_CONST, {.i64 = FRAG_TYPE_FRAMES }, 0, UINT_MAX, E, "frag_type"},
+    { "frag_frames", "number of frames of each fragment with frag_type frames", OFFSET(frag_frames), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, E },
+    { "ldash", "Enable low latency DASH with chunked CMAF segments", OFFSET(ldash), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
     { NULL },
 };
 
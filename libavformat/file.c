@@ -34,6 +34,9 @@
 #include <unistd.h>
 #endif
 #include <sys/stat.h>
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
 #include <stdlib.h>
 #include "os_support.h"
 #include "url.h"
@@ -73,6 +76,10 @@ typedef struct FileContext {
     int trunc;
     int blocksize;
     int follow;
+    int use_mmap;
+    AVBufferRef *map;       ///< mapping of the whole file when reading in mmap mode
+    int64_t map_size;
+    int64_t map_pos;        ///< read position in the mapping
 #if HAVE_DIRENT_H
     DIR *dir;
 #endif
@@ -82,6 +89,7 @@ static const AVOption file_options[] = {
     { "truncate", "truncate existing files on write", offsetof(FileContext, trunc), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, AV_OPT_FLAG_ENCODING_PARAM },
     { "blocksize", "set I/O operation maximum block size", offsetof(FileContext, blocksize), AV_OPT_TYPE_INT, { .i64 = INT_MAX }, 1, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
     { "follow", "Follow a file as it is being written", offsetof(FileContext, follow), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
+    { "mmap", "Map the file in memory when reading", offsetof(FileContext, use_mmap), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, AV_OPT_FLAG_DECODING_PARAM },
     { NULL }
 };
 
@@ -109,6 +117,14 @@ static int file_read(URLContext *h, unsigned char *buf, int size)
     FileContext *c = h->priv_data;
     int ret;
     size = FFMIN(size, c->blocksize);
+    if (c->map) {
+        if (c->map_pos >= c->map_size)
+            return AVERROR_EOF;
+        size = FFMIN(size, c->map_size - c->map_pos);
+        memcpy(buf, c->map->data + c->map_pos, size);
+        c->map_pos += size;
+        return size;
+    }
     ret = read(c->fd, buf, size);
     if (ret == 0 && c->follow)
         return AVERROR(EAGAIN);
@@ -199,6 +215,87 @@ static int file_move(URLContext *h_src, URLContext *h_dst)
 
 #if CONFIG_FILE_PROTOCOL
 
+#if HAVE_MMAP
+static void file_unmap(void *opaque, uint8_t *data)
+{
+    munmap(data, (size_t)(uintptr_t)opaque);
+}
+
+static int file_map(URLContext *h, int64_t size)
+{
+    FileContext *c = h->priv_data;
+    void *data;
+
+    if ((uint64_t)size > SIZE_MAX)
+        return AVERROR(ENOMEM);
+
+    /* private writable mapping, so that a stray in-place modification of the
+     * data by a demuxer never reaches the file */
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, c->fd, 0);
+    if (data == MAP_FAILED)
+        return AVERROR(errno);
+
+    /* the size of an AVBuffer is an int, the actual size of the mapping is
+     * stored in the opaque pointer */
+    c->map = av_buffer_create(data, FFMIN(size, INT_MAX), file_unmap,
+                              (void *)(uintptr_t)size, AV_BUFFER_FLAG_READONLY);
+    if (!c->map) {
+        munmap(data, size);
+        return AVERROR(ENOMEM);
+    }
+    c->map_size = size;
+    c->map_pos  = 0;
+    return 0;
+}
+
+/* Below this size, copying the data is cheaper than mapping it. */
+#define FILE_REF_MIN_SIZE (64 * 1024)
+
+static void file_unmap_ref(void *opaque, uint8_t *data)
+{
+    size_t page_size = sysconf(_SC_PAGESIZE);
+
+    munmap((uint8_t *)((uintptr_t)data & ~(page_size - 1)),
+           (size_t)(uintptr_t)opaque);
+}
+
+static int file_get_buffer(URLContext *h, int64_t pos, int size, AVBufferRef **buf)
+{
+    FileContext *c = h->priv_data;
+    int64_t page_size = sysconf(_SC_PAGESIZE);
+    int64_t start, end;
+    uint8_t *data;
+
+    if (!c->map || pos < 0 || size < FILE_REF_MIN_SIZE ||
+        pos > c->map_size - size || page_size <= 0)
+        return AVERROR(ENOSYS);
+
+    /* Map the pages of the data and its padding privately, so that the
+     * padding can be zeroed without changing the other mappings of the file;
+     * only the last page is copied on write. The pages past the end of the
+     * file cannot be accessed, the padding must fit in the last one. */
+    start = pos & ~(page_size - 1);
+    end   = pos + size + AV_INPUT_BUFFER_PADDING_SIZE;
+    if (end > FFALIGN(c->map_size, page_size) || (uint64_t)(end - start) > SIZE_MAX)
+        return AVERROR(ENOSYS);
+
+    data = mmap(NULL, end - start, PROT_READ | PROT_WRITE, MAP_PRIVATE, c->fd, start);
+    if (data == MAP_FAILED)
+        return AVERROR(errno);
+    data += pos - start;
+    memset(data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    *buf = av_buffer_create(data, size, file_unmap_ref,
+                            (void *)(uintptr_t)(end - start),
+                            AV_BUFFER_FLAG_READONLY);
+    if (!*buf) {
+        munmap(data - (pos - start), end - start);
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+#endif
+
 static int file_open(URLContext *h, const char *filename, int flags)
 {
     FileContext *c = h->priv_data;
@@ -229,6 +326,17 @@ static int file_open(URLContext *h, const char *filename, int flags)
 
     h->is_streamed = !fstat(fd, &st) && S_ISFIFO(st.st_mode);
 
+    if (c->use_mmap && !(flags & AVIO_FLAG_WRITE) && !c->follow &&
+        !h->is_streamed && S_ISREG(st.st_mode) && st.st_size > 0) {
+        int ret = AVERROR(ENOSYS);
+#if HAVE_MMAP
+        ret = file_map(h, st.st_size);
+#endif
+        if (ret < 0)
+            av_log(h, AV_LOG_WARNING, "Cannot map the file in memory, "
+                   "falling back to regular reads: %s\n", av_err2str(ret));
+    }
+
     /* Buffer writes more than the default 32k to improve throughput especially
      * with networked file systems */
     if (!h->is_streamed && flags & AVIO_FLAG_WRITE)
@@ -245,10 +353,25 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
 
     if (whence == AVSEEK_SIZE) {
         struct stat st;
+        if (c->map)
+            return c->map_size;
         ret = fstat(c->fd, &st);
         return ret < 0 ? AVERROR(errno) : (S_ISFIFO(st.st_mode) ? 0 : st.st_size);
     }
 
+    if (c->map) {
+        if (whence == SEEK_CUR)
+            pos += c->map_pos;
+        else if (whence == SEEK_END)
+            pos += c->map_size;
+        else if (whence != SEEK_SET)
+            return AVERROR(EINVAL);
+        if (pos < 0)
+            return AVERROR(EINVAL);
+        c->map_pos = pos;
+        return pos;
+    }
+
     ret = lseek(c->fd, pos, whence);
 
     return ret < 0 ? AVERROR(errno) : ret;
@@ -257,6 +380,7 @@ static int64_t file_seek(URLContext *h, int64_t pos, int whence)
 static int file_close(URLContext *h)
 {
     FileContext *c = h->priv_data;
+    av_buffer_unref(&c->map);
     return close(c->fd);
 }
 
@@ -352,6 +476,9 @@ const URLProtocol ff_file_protocol = {
     .url_seek            = file_seek,
     .url_close           = file_close,
     .url_get_file_handle = file_get_handle,
+#if HAVE_MMAP
+    .url_get_buffer      = file_get_buffer,
+#endif
     .url_check           = file_check,
     .url_delete          = file_delete,
     .url_move            = file_move,
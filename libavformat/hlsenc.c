@@ -41,6 +41,8 @@
 #include "libavutil/random_seed.h"
 #include "libavutil/opt.h"
 #include "libavutil/log.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
 #include "libavutil/time_internal.h"
 
 #include "avformat.h"
@@ -164,6 +166,25 @@ typedef struct ClosedCaptionsStream {
     char *language; /* closed captions langauge */
 } ClosedCaptionsStream;
 
+/* An output written to memory, to be uploaded by the I/O thread when closed. */
+typedef struct HLSAsyncOutput {
+    AVIOContext *pb;
+    char *url;
+    AVDictionary *options;
+    struct HLSAsyncOutput *next;
+} HLSAsyncOutput;
+
+typedef struct HLSIOJob {
+    char *url;
+    AVDictionary *options;
+    uint8_t *data;
+    int size;
+    int keep_connection; ///< close with hlsenc_io_close_direct()
+    int delete;          ///< an HTTP DELETE request, without data
+    int64_t queue_time;
+    struct HLSIOJob *next;
+} HLSIOJob;
+
 typedef struct HLSContext {
     const AVClass *class;  // Class for private options.
     int64_t start_sequence;
@@ -228,10 +249,28 @@ typedef struct HLSContext {
     AVIOContext *sub_m3u8_out;
     int64_t timeout;
     int ignore_io_errors;
+
+    int async_io;
+    int async_queue_size;
+    int io_thread_started;
+#if HAVE_THREADS
+    pthread_t io_thread;
+    pthread_mutex_t io_lock;
+    pthread_cond_t io_cond;
+#endif
+    HLSAsyncOutput *async_outputs;
+    HLSIOJob *io_jobs;      ///< queued jobs, the first one is being run
+    int nb_io_jobs;
+    int io_exit;
+    int io_error;
+    AVIOContext *io_pb;     ///< output of the I/O thread, kept with http_persistent
+    int nb_io_done;
+    int64_t io_total_latency;
+    int64_t io_max_latency;
 } HLSContext;
 
-static int hlsenc_io_open(AVFormatContext *s, AVIOContext **pb, char *filename,
-                          AVDictionary **options) {
+static int hlsenc_io_open_direct(AVFormatContext *s, AVIOContext **pb, char *filename,
+                                 AVDictionary **options) {
     HLSContext *hls = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
     int err = AVERROR_MUXER_NOT_FOUND;
@@ -250,7 +289,7 @@ static int hlsenc_io_open(AVFormatContext *s, AVIOContext **pb, char *filename,
     return err;
 }
 
-static void hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename) {
+static void hlsenc_io_close_direct(AVFormatContext *s, AVIOContext **pb, char *filename) {
     HLSContext *hls = s->priv_data;
     int http_base_proto = filename ? ff_is_http_proto(filename) : 0;
     if (!*pb)
@@ -267,6 +306,300 @@ static void hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename
     }
 }
 
+#if HAVE_THREADS
+static void free_io_job(HLSIOJob *job)
+{
+    av_freep(&job->url);
+    av_dict_free(&job->options);
+    av_freep(&job->data);
+    av_free(job);
+}
+
+/* Runs in the I/O thread, custom io_open/io_close callbacks must be
+ * thread-safe (as documented for async_io). */
+static int run_io_job(AVFormatContext *s, HLSIOJob *job)
+{
+    HLSContext *hls = s->priv_data;
+    AVIOContext *out = NULL;
+    int ret;
+
+    if (job->delete) {
+        if ((ret = s->io_open(s, &out, job->url, AVIO_FLAG_WRITE, &job->options)) < 0)
+            return ret;
+        ff_format_io_close(s, &out);
+        return 0;
+    }
+
+    /* only HTTP connections can be reused for another file */
+    if (hls->io_pb && (!hls->http_persistent || !ff_is_http_proto(job->url)))
+        ff_format_io_close(s, &hls->io_pb);
+    if ((ret = hlsenc_io_open_direct(s, &hls->io_pb, job->url, &job->options)) < 0)
+        return ret;
+
+    avio_write(hls->io_pb, job->data, job->size);
+    avio_flush(hls->io_pb);
+    ret = hls->io_pb->error;
+    if (job->keep_connection && ret >= 0)
+        hlsenc_io_close_direct(s, &hls->io_pb, job->url);
+    else
+        ff_format_io_close(s, &hls->io_pb);
+    return ret;
+}
+
+static void *io_thread(void *arg)
+{
+    AVFormatContext *s = arg;
+    HLSContext *hls = s->priv_data;
+
+    pthread_mutex_lock(&hls->io_lock);
+    for (;;) {
+        HLSIOJob *job;
+        int64_t start, end;
+        int ret;
+
+        while (!hls->io_jobs && !hls->io_exit)
+            pthread_cond_wait(&hls->io_cond, &hls->io_lock);
+        /* all the queued jobs are run before exiting */
+        if (!hls->io_jobs)
+            break;
+        job = hls->io_jobs;
+        pthread_mutex_unlock(&hls->io_lock);
+
+        start = av_gettime_relative();
+        ret   = run_io_job(s, job);
+        end   = av_gettime_relative();
+        if (ret < 0)
+            av_log(s, hls->ignore_io_errors ? AV_LOG_WARNING : AV_LOG_ERROR,
+                   "Failed to %s '%s': %s\n", job->delete ? "delete" : "write",
+                   job->url, av_err2str(ret));
+        else
+            av_log(s, AV_LOG_VERBOSE, "%s '%s' (%d bytes) in %.3f s, "
+                   "%.3f s after it was queued\n",
+                   job->delete ? "Deleted" : "Wrote", job->url, job->size,
+                   (end - start) / 1000000.0, (end - job->queue_time) / 1000000.0);
+
+        pthread_mutex_lock(&hls->io_lock);
+        if (ret < 0 && !hls->io_error)
+            hls->io_error = ret;
+        hls->nb_io_done++;
+        hls->io_total_latency += end - job->queue_time;
+        hls->io_max_latency    = FFMAX(hls->io_max_latency, end - job->queue_time);
+        hls->io_jobs = job->next;
+        hls->nb_io_jobs--;
+        pthread_cond_broadcast(&hls->io_cond);
+        free_io_job(job);
+    }
+    pthread_mutex_unlock(&hls->io_lock);
+
+    return NULL;
+}
+
+/* Add a job to the I/O queue, waiting while it is full. Takes ownership of job. */
+static void queue_io_job(AVFormatContext *s, HLSIOJob *job)
+{
+    HLSContext *hls = s->priv_data;
+    HLSIOJob **last;
+
+    pthread_mutex_lock(&hls->io_lock);
+    while (hls->nb_io_jobs >= hls->async_queue_size)
+        pthread_cond_wait(&hls->io_cond, &hls->io_lock);
+    job->queue_time = av_gettime_relative();
+    for (last = &hls->io_jobs; *last; last = &(*last)->next)
+        ;
+    *last = job;
+    hls->nb_io_jobs++;
+    pthread_cond_broadcast(&hls->io_cond);
+    pthread_mutex_unlock(&hls->io_lock);
+}
+
+static int start_io_thread(AVFormatContext *s)
+{
+    HLSContext *hls = s->priv_data;
+    int ret;
+
+    if ((ret = pthread_mutex_init(&hls->io_lock, NULL))) {
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&hls->io_cond, NULL))) {
+        pthread_mutex_destroy(&hls->io_lock);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_create(&hls->io_thread, NULL, io_thread, s))) {
+        pthread_cond_destroy(&hls->io_cond);
+        pthread_mutex_destroy(&hls->io_lock);
+        return AVERROR(ret);
+    }
+    hls->io_thread_started = 1;
+    return 0;
+}
+
+/* Wait for all the queued jobs to be done and stop the I/O thread. */
+static void stop_io_thread(AVFormatContext *s)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (!hls->io_thread_started)
+        return;
+
+    pthread_mutex_lock(&hls->io_lock);
+    hls->io_exit = 1;
+    pthread_cond_broadcast(&hls->io_cond);
+    pthread_mutex_unlock(&hls->io_lock);
+    pthread_join(hls->io_thread, NULL);
+
+    ff_format_io_close(s, &hls->io_pb);
+    pthread_cond_destroy(&hls->io_cond);
+    pthread_mutex_destroy(&hls->io_lock);
+    hls->io_thread_started = 0;
+
+    if (hls->nb_io_done)
+        av_log(s, AV_LOG_INFO, "%d asynchronous writes, latency average %.3f s, "
+               "max %.3f s\n", hls->nb_io_done,
+               hls->io_total_latency / 1000000.0 / hls->nb_io_done,
+               hls->io_max_latency / 1000000.0);
+}
+
+static int get_io_error(AVFormatContext *s)
+{
+    HLSContext *hls = s->priv_data;
+    int ret;
+
+    if (!hls->io_thread_started || hls->ignore_io_errors)
+        return 0;
+    pthread_mutex_lock(&hls->io_lock);
+    ret = hls->io_error;
+    pthread_mutex_unlock(&hls->io_lock);
+    return ret;
+}
+#else
+static void queue_io_job(AVFormatContext *s, HLSIOJob *job)
+{
+    av_assert0(0);
+}
+
+static void stop_io_thread(AVFormatContext *s)
+{
+}
+
+static int get_io_error(AVFormatContext *s)
+{
+    return 0;
+}
+#endif
+
+/* With async_io, outputs are written to memory and uploaded when closed. */
+static int hlsenc_io_open(AVFormatContext *s, AVIOContext **pb, char *filename,
+                          AVDictionary **options)
+{
+    HLSContext *hls = s->priv_data;
+    HLSAsyncOutput *out;
+
+    if (!hls->io_thread_started)
+        return hlsenc_io_open_direct(s, pb, filename, options);
+
+    out = av_mallocz(sizeof(*out));
+    if (!out)
+        return AVERROR(ENOMEM);
+    out->url = av_strdup(filename);
+    if (!out->url || (options && av_dict_copy(&out->options, *options, 0) < 0) ||
+        avio_open_dyn_buf(pb) < 0) {
+        av_freep(&out->url);
+        av_dict_free(&out->options);
+        av_free(out);
+        return AVERROR(ENOMEM);
+    }
+    out->pb            = *pb;
+    out->next          = hls->async_outputs;
+    hls->async_outputs = out;
+    return 0;
+}
+
+static void close_async_output(AVFormatContext *s, AVIOContext **pb,
+                               int keep_connection)
+{
+    HLSContext *hls = s->priv_data;
+    HLSAsyncOutput **pout, *out;
+    HLSIOJob *job;
+
+    for (pout = &hls->async_outputs; *pout && (*pout)->pb != *pb; pout = &(*pout)->next)
+        ;
+    if (!(out = *pout)) {
+        ff_format_io_close(s, pb);
+        return;
+    }
+    *pout = out->next;
+
+    job = av_mallocz(sizeof(*job));
+    if (!job) {
+        ffio_free_dyn_buf(pb);
+    } else {
+        job->size            = avio_close_dyn_buf(*pb, &job->data);
+        job->url             = out->url;
+        job->options         = out->options;
+        job->keep_connection = keep_connection;
+        *pb = NULL;
+        out->url     = NULL;
+        out->options = NULL;
+        queue_io_job(s, job);
+    }
+    av_freep(&out->url);
+    av_dict_free(&out->options);
+    av_free(out);
+}
+
+static void hlsenc_io_close(AVFormatContext *s, AVIOContext **pb, char *filename)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (!*pb)
+        return;
+    if (hls->io_thread_started)
+        close_async_output(s, pb, 1);
+    else
+        hlsenc_io_close_direct(s, pb, filename);
+}
+
+/* Close an output opened with hlsenc_io_open(), never keeping the connection. */
+static void hlsenc_io_finish(AVFormatContext *s, AVIOContext **pb)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (*pb && hls->io_thread_started)
+        close_async_output(s, pb, 0);
+    else
+        ff_format_io_close(s, pb);
+}
+
+static int hlsenc_delete_url(AVFormatContext *s, AVFormatContext *oc,
+                             const char *url, AVDictionary **options)
+{
+    HLSContext *hls = s->priv_data;
+    AVIOContext *out = NULL;
+    HLSIOJob *job;
+    int ret;
+
+    if (!hls->io_thread_started) {
+        if ((ret = oc->io_open(oc, &out, url, AVIO_FLAG_WRITE, options)) < 0)
+            return ret;
+        ff_format_io_close(oc, &out);
+        return 0;
+    }
+
+    job = av_mallocz(sizeof(*job));
+    if (!job)
+        return AVERROR(ENOMEM);
+    job->url    = av_strdup(url);
+    job->delete = 1;
+    if (!job->url || av_dict_copy(&job->options, *options, 0) < 0) {
+        av_freep(&job->url);
+        av_dict_free(&job->options);
+        av_free(job);
+        return AVERROR(ENOMEM);
+    }
+    queue_io_job(s, job);
+    return 0;
+}
+
 static void set_http_options(AVFormatContext *s, AVDictionary **options, HLSContext *c)
 {
     int http_base_proto = ff_is_http_proto(s->url);
@@ -423,7 +756,6 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
     char *path = NULL;
     char *vtt_dirname = NULL;
     AVDictionary *options = NULL;
-    AVIOContext *out = NULL;
     const char *proto = NULL;
 
     segment = vs->segments;
@@ -497,12 +829,11 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
         proto = avio_find_protocol_name(s->url);
         if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
             av_dict_set(&options, "method", "DELETE", 0);
-            if ((ret = vs->avf->io_open(vs->avf, &out, path, AVIO_FLAG_WRITE, &options)) < 0) {
+            if ((ret = hlsenc_delete_url(s, vs->avf, path, &options)) < 0) {
                 if (hls->ignore_io_errors)
                     ret = 0;
                 goto fail;
             }
-            ff_format_io_close(vs->avf, &out);
         } else if (unlink(path) < 0) {
             av_log(hls, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
                                      path, strerror(errno));
@@ -528,13 +859,12 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls,
 
             if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
                 av_dict_set(&options, "method", "DELETE", 0);
-                if ((ret = vs->vtt_avf->io_open(vs->vtt_avf, &out, sub_path, AVIO_FLAG_WRITE, &options)) < 0) {
+                if ((ret = hlsenc_delete_url(s, vs->vtt_avf, sub_path, &options)) < 0) {
                     if (hls->ignore_io_errors)
                         ret = 0;
                     av_free(sub_path);
                     goto fail;
                 }
-                ff_format_io_close(vs->vtt_avf, &out);
             } else if (unlink(sub_path) < 0) {
                 av_log(hls, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
                                          sub_path, strerror(errno));
@@ -2149,6 +2479,10 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
     AVDictionary *options = NULL;
     char *old_filename = NULL;
 
+    /* a failed asynchronous upload is reported on the next packet */
+    if ((ret = get_io_error(s)) < 0)
+        return ret;
+
     for (i = 0; i < hls->nb_varstreams; i++) {
         vs = &hls->var_streams[i];
         for (j = 0; j < vs->nb_streams; j++) {
@@ -2239,7 +2573,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
                 vs->packets_written = 0;
                 vs->start_pos = range_length;
                 if (!byterange_mode) {
-                    ff_format_io_close(s, &vs->out);
+                    hlsenc_io_finish(s, &vs->out);
                     hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
                 }
             }
@@ -2283,7 +2617,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
                 if (ret < 0) {
                     return ret;
                 }
-                ff_format_io_close(s, &vs->out);
+                hlsenc_io_finish(s, &vs->out);
 
                 // rename that segment from .tmp to the real one
                 if (use_temp_file && oc->url[0]) {
@@ -2399,7 +2733,7 @@ static int hls_write_trailer(struct AVFormatContext *s)
                 vs->start_pos = range_length;
                 byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
                 if (!byterange_mode) {
-                    ff_format_io_close(s, &vs->out);
+                    hlsenc_io_finish(s, &vs->out);
                     hlsenc_io_close(s, &vs->out, vs->base_output_dirname);
                 }
             }
@@ -2416,7 +2750,7 @@ static int hls_write_trailer(struct AVFormatContext *s)
                 goto failed;
             }
             vs->size = range_length;
-            ff_format_io_close(s, &vs->out);
+            hlsenc_io_finish(s, &vs->out);
         }
 
 failed:
@@ -2426,7 +2760,7 @@ failed:
                 vs->size = avio_tell(vs->avf->pb) - vs->start_pos;
             }
             if (hls->segment_type != SEGMENT_TYPE_FMP4)
-                ff_format_io_close(s, &oc->pb);
+                hlsenc_io_finish(s, &oc->pb);
 
             // rename that segment from .tmp to the real one
             if (use_temp_file && oc->url[0] && !(hls->flags & HLS_SINGLE_FILE)) {
@@ -2449,7 +2783,7 @@ failed:
             if (vtt_oc->pb)
                 av_write_trailer(vtt_oc);
             vs->size = avio_tell(vs->vtt_avf->pb) - vs->start_pos;
-            ff_format_io_close(s, &vtt_oc->pb);
+            hlsenc_io_finish(s, &vtt_oc->pb);
         }
         av_freep(&vs->basename);
         av_freep(&vs->base_output_dirname);
@@ -2482,15 +2816,38 @@ failed:
         av_freep(&ccs->language);
     }
 
-    ff_format_io_close(s, &hls->m3u8_out);
-    ff_format_io_close(s, &hls->sub_m3u8_out);
+    hlsenc_io_finish(s, &hls->m3u8_out);
+    hlsenc_io_finish(s, &hls->sub_m3u8_out);
     av_freep(&hls->key_basename);
     av_freep(&hls->var_streams);
     av_freep(&hls->cc_streams);
     av_freep(&hls->master_m3u8_url);
+
+    if (hls->io_thread_started) {
+        int ret;
+        stop_io_thread(s);
+        ret = hls->ignore_io_errors ? 0 : hls->io_error;
+        if (ret < 0)
+            return ret;
+    }
     return 0;
 }
 
+static void hls_deinit(AVFormatContext *s)
+{
+    HLSContext *hls = s->priv_data;
+
+    stop_io_thread(s);
+    while (hls->async_outputs) {
+        HLSAsyncOutput *out = hls->async_outputs;
+        hls->async_outputs = out->next;
+        ffio_free_dyn_buf(&out->pb);
+        av_freep(&out->url);
+        av_dict_free(&out->options);
+        av_free(out);
+    }
+}
+
 
 static int hls_init(AVFormatContext *s)
 {
@@ -2571,6 +2928,27 @@ static int hls_init(AVFormatContext *s)
         av_log(hls, AV_LOG_DEBUG, "start_number evaluated to %"PRId64"\n", hls->start_sequence);
     }
 
+    if (hls->async_io) {
+        const char *proto = avio_find_protocol_name(s->url);
+        int byterange_mode = (hls->flags & HLS_SINGLE_FILE) || (hls->max_seg_size > 0);
+
+        /* local files and byte ranges of a single file are written in place */
+        if ((proto && !strcmp(proto, "file")) || byterange_mode) {
+            av_log(s, AV_LOG_VERBOSE, "async_io has no effect with this output\n");
+        } else {
+#if HAVE_THREADS
+            if ((ret = start_io_thread(s)) < 0) {
+                av_log(s, AV_LOG_ERROR, "Failed to start the I/O thread\n");
+                goto fail;
+            }
+#else
+            av_log(s, AV_LOG_ERROR, "async_io needs threading support\n");
+            ret = AVERROR(ENOSYS);
+            goto fail;
+#endif
+        }
+    }
+
     hls->recording_time = (hls->init_time ? hls->init_time : hls->time) * AV_TIME_BASE;
     for (i = 0; i < hls->nb_varstreams; i++) {
         vs = &hls->var_streams[i];
@@ -2900,6 +3278,8 @@ static const AVOption options[] = {
     {"http_persistent", "Use persistent HTTP connections", OFFSET(http_persistent), AV_OPT_TYPE_BOOL, {.i64 = 0 }, 0, 1, E },
     {"timeout", "set timeout for socket I/O operations", OFFSET(timeout), AV_OPT_TYPE_DURATION, { .i64 = -1 }, -1, INT_MAX, .flags = E },
     {"ignore_io_errors", "Ignore IO errors for stable long-duration runs with network output", OFFSET(ignore_io_errors), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    {"async_io", "Upload segments and playlists from a separate thread", OFFSET(async_io), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    {"async_queue_size", "Maximum number of uploads waiting for the I/O thread", OFFSET(async_queue_size), AV_OPT_TYPE_INT, { .i64 = 16 }, 1, 1024, E },
     { NULL },
 };
 
@@ -2924,5 +3304,6 @@ AVOutputFormat ff_hls_muxer = {
     .write_header   = hls_write_header,
     .write_packet   = hls_write_packet,
     .write_trailer  = hls_write_trailer,
+    .deinit         = hls_deinit,
     .priv_class     = &hls_class,
 };
@@ -0,0 +1,293 @@
+/*
+ * Persistent demuxer index cache
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Sidecar files holding a demuxer index, so that later opens of the same
+ * input do not have to rebuild it.
+ *
+ * Layout, all values big-endian:
+ *   'FFIC' tag, version, demuxer name (zero terminated),
+ *   input size, input modification time, CRC of the first input bytes,
+ *   demuxer specific payload.
+ *
+ * The tag is written last, once the rest of the cache was written
+ * successfully, so that an incomplete cache is never used.
+ *
+ * The payload written by ff_index_cache_write_index() is the number of
+ * streams followed by, for each stream, its id, codec id, number of index
+ * entries and the entries themselves.
+ */
+
+#include <sys/stat.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/crc.h"
+#include "libavutil/intreadwrite.h"
+#include "avformat.h"
+#include "indexcache.h"
+#include "internal.h"
+
+#define INDEX_CACHE_VERSION     1
+#define INDEX_CACHE_HEADER_SIZE 65536
+#define INDEX_CACHE_ENTRY_SIZE  28
+
+typedef struct IndexCacheKey {
+    int64_t size;
+    int64_t mtime;
+    uint32_t crc;
+} IndexCacheKey;
+
+static int get_cache_key(AVFormatContext *s, IndexCacheKey *key)
+{
+    const AVCRC *crc_table = av_crc_get_table(AV_CRC_32_IEEE_LE);
+    const char *proto = avio_find_protocol_name(s->url);
+    const char *filename = s->url;
+    uint8_t buf[4096];
+    int64_t pos;
+    int len, left = INDEX_CACHE_HEADER_SIZE;
+    struct stat st;
+
+    if (!s->pb || !(s->pb->seekable & AVIO_SEEKABLE_NORMAL))
+        return AVERROR(ENOSYS);
+
+    key->size = avio_size(s->pb);
+    if (key->size < 0)
+        return key->size;
+
+    key->mtime = 0;
+    if (proto && !strcmp(proto, "file")) {
+        av_strstart(filename, "file:", &filename);
+        if (!stat(filename, &st))
+            key->mtime = st.st_mtime;
+    }
+
+    pos = avio_tell(s->pb);
+    if (avio_seek(s->pb, 0, SEEK_SET) < 0)
+        return AVERROR(EIO);
+    key->crc = UINT32_MAX;
+    while (left > 0 && (len = avio_read(s->pb, buf, FFMIN(left, sizeof(buf)))) > 0) {
+        key->crc = av_crc(crc_table, key->crc, buf, len);
+        left -= len;
+    }
+    if (avio_seek(s->pb, pos, SEEK_SET) < 0)
+        return AVERROR(EIO);
+
+    return 0;
+}
+
+int ff_index_cache_open_read(AVFormatContext *s, const char *path,
+                             AVIOContext **pb)
+{
+    IndexCacheKey key;
+    char name[64];
+    int ret;
+
+    *pb = NULL;
+    if ((ret = get_cache_key(s, &key)) < 0)
+        return ret;
+
+    if (s->io_open(s, pb, path, AVIO_FLAG_READ, NULL) < 0) {
+        av_log(s, AV_LOG_VERBOSE, "No index cache found at %s\n", path);
+        return 0;
+    }
+
+    if (avio_rl32(*pb) != MKTAG('F', 'F', 'I', 'C') ||
+        avio_rb32(*pb) != INDEX_CACHE_VERSION)
+        goto stale;
+    avio_get_str(*pb, INT_MAX, name, sizeof(name));
+    if (strcmp(name, s->iformat->name) ||
+        avio_rb64(*pb) != key.size  ||
+        avio_rb64(*pb) != key.mtime ||
+        avio_rb32(*pb) != key.crc   ||
+        avio_feof(*pb))
+        goto stale;
+
+    return 1;
+
+stale:
+    av_log(s, AV_LOG_VERBOSE, "Index cache %s does not match the input\n", path);
+    ff_format_io_close(s, pb);
+    return 0;
+}
+
+int ff_index_cache_open_write(AVFormatContext *s, const char *path,
+                              AVIOContext **pb)
+{
+    IndexCacheKey key;
+    int ret;
+
+    *pb = NULL;
+    if ((ret = get_cache_key(s, &key)) < 0)
+        return ret;
+
+    ret = s->io_open(s, pb, path, AVIO_FLAG_WRITE, NULL);
+    if (ret < 0) {
+        av_log(s, AV_LOG_WARNING, "Could not create index cache %s\n", path);
+        return ret;
+    }
+    if (!((*pb)->seekable & AVIO_SEEKABLE_NORMAL)) {
+        av_log(s, AV_LOG_WARNING, "Index cache %s is not seekable\n", path);
+        ff_format_io_close(s, pb);
+        return AVERROR(ENOSYS);
+    }
+
+    /* the tag is filled in by ff_index_cache_close() */
+    avio_wl32(*pb, 0);
+    avio_wb32(*pb, INDEX_CACHE_VERSION);
+    avio_put_str(*pb, s->iformat->name);
+    avio_wb64(*pb, key.size);
+    avio_wb64(*pb, key.mtime);
+    avio_wb32(*pb, key.crc);
+
+    return 0;
+}
+
+int ff_index_cache_close(AVFormatContext *s, const char *path,
+                         AVIOContext **pb, int ret)
+{
+    if (!*pb)
+        return ret;
+
+    if ((*pb)->write_flag) {
+        avio_flush(*pb);
+        if (ret >= 0 && (*pb)->error < 0)
+            ret = (*pb)->error;
+        if (ret >= 0) {
+            int64_t err = avio_seek(*pb, 0, SEEK_SET);
+            avio_wl32(*pb, MKTAG('F', 'F', 'I', 'C'));
+            avio_flush(*pb);
+            if (err < 0 || (*pb)->error < 0)
+                ret = err < 0 ? err : (*pb)->error;
+        }
+        if (ret < 0)
+            av_log(s, AV_LOG_WARNING, "Index cache %s is incomplete and will "
+                   "be ignored\n", path);
+    }
+    ff_format_io_close(s, pb);
+    return ret;
+}
+
+static AVStream *find_stream(AVFormatContext *s, int id,
+                             enum AVCodecID codec_id)
+{
+    int i;
+
+    for (i = 0; i < s->nb_streams; i++)
+        if (s->streams[i]->id == id &&
+            s->streams[i]->codecpar->codec_id == codec_id)
+            return s->streams[i];
+    return NULL;
+}
+
+int ff_index_cache_read_index(AVFormatContext *s, const char *path)
+{
+    AVIOContext *pb;
+    unsigned nb_streams, nb_entries;
+    int64_t cache_size;
+    int i, j, ret;
+
+    for (i = 0; i < s->nb_streams; i++)
+        if (s->streams[i]->nb_index_entries)
+            return 0;
+
+    ret = ff_index_cache_open_read(s, path, &pb);
+    if (ret <= 0)
+        return ret;
+    cache_size = avio_size(pb);
+
+    nb_streams = avio_rb32(pb);
+    for (i = 0; i < nb_streams && !avio_feof(pb); i++) {
+        int id                = avio_rb32(pb);
+        enum AVCodecID codec_id = avio_rb32(pb);
+        AVStream *st          = find_stream(s, id, codec_id);
+
+        nb_entries = avio_rb32(pb);
+        if (cache_size >= 0 &&
+            nb_entries > (cache_size - avio_tell(pb)) / INDEX_CACHE_ENTRY_SIZE)
+            goto fail;
+        if (!st || st->nb_index_entries) {
+            avio_skip(pb, (int64_t)nb_entries * INDEX_CACHE_ENTRY_SIZE);
+            continue;
+        }
+
+        for (j = 0; j < nb_entries && !avio_feof(pb); j++) {
+            int64_t pos       = avio_rb64(pb);
+            int64_t timestamp = avio_rb64(pb);
+            int size          = avio_rb32(pb);
+            int distance      = avio_rb32(pb);
+            int flags         = avio_rb32(pb);
+
+            if (size < 0 || distance < 0) {
+                ret = AVERROR_INVALIDDATA;
+                goto fail;
+            }
+            ret = ff_add_index_entry(&st->index_entries, &st->nb_index_entries,
+                                     &st->index_entries_allocated_size,
+                                     pos, timestamp, size, distance, flags);
+            if (ret < 0)
+                goto fail;
+        }
+    }
+    if (avio_feof(pb))
+        goto fail;
+
+    av_log(s, AV_LOG_VERBOSE, "Loaded index from %s\n", path);
+    return ff_index_cache_close(s, path, &pb, 1);
+
+fail:
+    av_log(s, AV_LOG_WARNING, "Index cache %s is damaged\n", path);
+    for (i = 0; i < s->nb_streams; i++)
+        s->streams[i]->nb_index_entries = 0;
+    ff_index_cache_close(s, path, &pb, 0);
+    return 0;
+}
+
+int ff_index_cache_write_index(AVFormatContext *s, const char *path)
+{
+    AVIOContext *pb;
+    int i, j, ret;
+
+    ret = ff_index_cache_open_write(s, path, &pb);
+    if (ret < 0)
+        return ret;
+
+    avio_wb32(pb, s->nb_streams);
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+
+        avio_wb32(pb, st->id);
+        avio_wb32(pb, st->codecpar->codec_id);
+        avio_wb32(pb, st->nb_index_entries);
+        for (j = 0; j < st->nb_index_entries; j++) {
+            const AVIndexEntry *ie = &st->index_entries[j];
+            avio_wb64(pb, ie->pos);
+            avio_wb64(pb, ie->timestamp);
+            avio_wb32(pb, ie->size);
+            avio_wb32(pb, ie->min_distance);
+            avio_wb32(pb, ie->flags & 3);
+        }
+    }
+
+    ret = ff_index_cache_close(s, path, &pb, 0);
+    if (ret >= 0)
+        av_log(s, AV_LOG_VERBOSE, "Wrote index to %s\n", path);
+    return ret;
+}
@@ -0,0 +1,79 @@
+/*
+ * Persistent demuxer index cache
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_INDEXCACHE_H
+#define AVFORMAT_INDEXCACHE_H
+
+#include "avformat.h"
+#include "avio.h"
+
+/**
+ * Open the index cache file at path for reading.
+ *
+ * A cache is only accepted if it was written by the same demuxer for an
+ * input with the same size, modification time and leading bytes as the
+ * input of s. The input must be seekable.
+ *
+ * @param pb set to a context positioned at the demuxer specific payload
+ * @return 1 if the cache was opened, 0 if it is missing or stale,
+ *         a negative AVERROR code on failure
+ */
+int ff_index_cache_open_read(AVFormatContext *s, const char *path,
+                             AVIOContext **pb);
+
+/**
+ * Start writing an index cache for the input of s.
+ *
+ * The cache is only marked as valid by a successful ff_index_cache_close(),
+ * so a partially written cache is never used. The output must be seekable.
+ *
+ * @param pb set to a context positioned after the cache header
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_index_cache_open_write(AVFormatContext *s, const char *path,
+                              AVIOContext **pb);
+
+/**
+ * Close an index cache opened by ff_index_cache_open_read() or
+ * ff_index_cache_open_write().
+ *
+ * @param ret status of the caller, a cache being written is discarded
+ *            if it is negative
+ * @return ret, or a negative AVERROR code if committing the cache failed
+ */
+int ff_index_cache_close(AVFormatContext *s, const char *path,
+                         AVIOContext **pb, int ret);
+
+/**
+ * Fill the index of the streams of s from the cache at path. Streams are
+ * matched by id and codec id. Nothing is loaded if any stream already has
+ * index entries.
+ *
+ * @return 1 if the index was loaded, 0 if the cache is missing or stale,
+ *         a negative AVERROR code on failure
+ */
+int ff_index_cache_read_index(AVFormatContext *s, const char *path);
+
+/**
+ * Store the index of all streams of s in the cache at path.
+ */
+int ff_index_cache_write_index(AVFormatContext *s, const char *path);
+
+#endif /* AVFORMAT_INDEXCACHE_H */
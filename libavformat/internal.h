@@ -613,6 +613,13 @@ static inline int ff_rename(const char *oldpath, const char *newpath, void *logc
  */
 int ff_alloc_extradata(AVCodecParameters *par, int size);
 
+/**
+ * Read a packet like av_get_packet(), but reference the data instead of
+ * copying it when the I/O context supports it, e.g. a memory mapped file.
+ * The packet data must then not be modified in place.
+ */
+int ff_get_packet_ref(AVIOContext *s, AVPacket *pkt, int size);
+
 /**
  * Allocate extradata with additional AV_INPUT_BUFFER_PADDING_SIZE at end
  * which is always set to 0 and fill it from pb.
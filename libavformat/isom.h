@@ -273,6 +273,10 @@ typedef struct MOVContext {
     int moov_retry;
     int use_mfra_for;
     int has_looked_for_mfra;
+    int lazy_fragments;     ///< only read fragment headers when they are needed
+    char *index_cache;      ///< path of the sidecar file caching the fragment index
+    int has_looked_for_index_cache;
+    int index_cache_loaded;
     MOVFragmentIndex frag_index;
     int atom_depth;
     unsigned int aax_mode;  ///< 'aax' file has been detected
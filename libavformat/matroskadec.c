@@ -51,6 +51,7 @@
 
 #include "avformat.h"
 #include "avio_internal.h"
+#include "indexcache.h"
 #include "internal.h"
 #include "isom.h"
 #include "matroska.h"
@@ -367,6 +368,13 @@ typedef struct MatroskaDemuxContext {
 
     /* Bandwidth value for WebM DASH Manifest */
     int bandwidth;
+
+    /* Sidecar file caching the index, and whether the index is complete
+     * enough to be written to it */
+    char *index_cache;
+    int index_cache_loaded;
+    int index_complete;
+    int seeked;
 } MatroskaDemuxContext;
 
 typedef struct MatroskaBlock {
@@ -963,8 +971,19 @@ static int ebml_read_ascii(AVIOContext *pb, int size, char **str)
  */
 static int ebml_read_binary(AVIOContext *pb, int length, EbmlBin *bin)
 {
+    AVBufferRef *ref;
     int ret;
 
+    /* reference the data directly if the file is memory mapped */
+    bin->pos = avio_tell(pb);
+    if (ffio_read_buffer_ref(pb, &ref, length) >= 0) {
+        av_buffer_unref(&bin->buf);
+        bin->buf  = ref;
+        bin->data = ref->data;
+        bin->size = length;
+        return 0;
+    }
+
     ret = av_buffer_realloc(&bin->buf, length + AV_INPUT_BUFFER_PADDING_SIZE);
     if (ret < 0)
         return ret;
@@ -1699,6 +1718,8 @@ static void matroska_parse_cues(MatroskaDemuxContext *matroska) {
         if (elem->id == MATROSKA_ID_CUES && !elem->parsed) {
             if (matroska_parse_seekhead_entry(matroska, elem->pos) < 0)
                 matroska->cues_parsing_deferred = -1;
+            else
+                matroska->index_complete = 1;
             elem->parsed = 1;
             break;
         }
@@ -2731,6 +2752,19 @@ static int matroska_read_header(AVFormatContext *s)
 
     matroska_add_index_entries(matroska);
 
+    /* Cues that are only referenced from the SeekHead are parsed on the
+     * first seek, the cached index saves that trip to the end of the file
+     * and covers files without Cues as well. */
+    if (matroska->index_cache && matroska->cues_parsing_deferred >= 0) {
+        res = ff_index_cache_read_index(s, matroska->index_cache);
+        if (res < 0)
+            av_log(s, AV_LOG_WARNING, "Could not use the index cache\n");
+        if (res > 0) {
+            matroska->index_cache_loaded    = 1;
+            matroska->cues_parsing_deferred = 0;
+        }
+    }
+
     matroska_convert_tags(s);
 
     return 0;
@@ -3535,8 +3569,11 @@ static int matroska_read_packet(AVFormatContext *s, AVPacket *pkt)
 
     while (matroska_deliver_packet(matroska, pkt)) {
         int64_t pos = avio_tell(matroska->ctx->pb);
-        if (matroska->done)
+        if (matroska->done) {
+            if (!matroska->seeked)
+                matroska->index_complete = 1;
             return (ret < 0) ? ret : AVERROR_EOF;
+        }
         if (matroska_parse_cluster(matroska) < 0)
             ret = matroska_resync(matroska, pos);
     }
@@ -3552,6 +3589,8 @@ static int matroska_read_seek(AVFormatContext *s, int stream_index,
     AVStream *st = s->streams[stream_index];
     int i, index, index_min;
 
+    matroska->seeked = 1;
+
     /* Parse the CUES now since we need the index data to seek. */
     if (matroska->cues_parsing_deferred > 0) {
         matroska->cues_parsing_deferred = 0;
@@ -3618,6 +3657,10 @@ static int matroska_read_close(AVFormatContext *s)
     MatroskaTrack *tracks = matroska->tracks.elem;
     int n;
 
+    if (matroska->index_cache && !matroska->index_cache_loaded &&
+        matroska->index_complete && s->pb)
+        ff_index_cache_write_index(s, matroska->index_cache);
+
     matroska_clear_queue(matroska);
 
     for (n = 0; n < matroska->tracks.nb_elem; n++)
@@ -4017,6 +4060,18 @@ static const AVOption options[] = {
     { NULL },
 };
 
+static const AVOption matroska_options[] = {
+    { "index_cache", "path of a file caching the seek index", OFFSET(index_cache), AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, AV_OPT_FLAG_DECODING_PARAM },
+    { NULL },
+};
+
+static const AVClass matroska_class = {
+    .class_name = "matroska,webm demuxer",
+    .item_name  = av_default_item_name,
+    .option     = matroska_options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 static const AVClass webm_dash_class = {
     .class_name = "WebM DASH Manifest demuxer",
     .item_name  = av_default_item_name,
@@ -4034,7 +4089,8 @@ AVInputFormat ff_matroska_demuxer = {
     .read_packet    = matroska_read_packet,
     .read_close     = matroska_read_close,
     .read_seek      = matroska_read_seek,
-    .mime_type      = "audio/webm,audio/x-matroska,video/webm,video/x-matroska"
+    .mime_type      = "audio/webm,audio/x-matroska,video/webm,video/x-matroska",
+    .priv_class     = &matroska_class,
 };
 
 AVInputFormat ff_webm_dash_manifest_demuxer = {
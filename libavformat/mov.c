@@ -52,6 +52,7 @@
 #include "avformat.h"
 #include "internal.h"
 #include "avio_internal.h"
+#include "indexcache.h"
 #include "riff.h"
 #include "isom.h"
 #include "libavcodec/get_bits.h"
@@ -1368,9 +1369,166 @@ static void fix_frag_index_entries(MOVFragmentIndex *frag_index, int index,
     }
 }
 
+/* Restore the fragment index saved by mov_write_index_cache(). */
+static int mov_read_index_cache(MOVContext *c)
+{
+    AVIOContext *f;
+    unsigned nb_items, nb_stream_info;
+    int i, j, index, ret;
+
+    ret = ff_index_cache_open_read(c->fc, c->index_cache, &f);
+    if (ret <= 0)
+        return ret;
+
+    nb_items = avio_rb32(f);
+    for (i = 0; i < nb_items && !avio_feof(f); i++) {
+        int64_t moof_offset = avio_rb64(f);
+
+        index = update_frag_index(c, moof_offset);
+        if (index < 0) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        nb_stream_info = avio_rb32(f);
+        for (j = 0; j < nb_stream_info && !avio_feof(f); j++) {
+            MOVFragmentStreamInfo *frag_stream_info;
+            int id                 = avio_rb32(f);
+            int64_t sidx_pts       = avio_rb64(f);
+            int64_t first_tfra_pts = avio_rb64(f);
+            int64_t tfdt_dts       = avio_rb64(f);
+
+            frag_stream_info = get_frag_stream_info(&c->frag_index, index, id);
+            if (frag_stream_info) {
+                frag_stream_info->sidx_pts       = sidx_pts;
+                frag_stream_info->first_tfra_pts = first_tfra_pts;
+                frag_stream_info->tfdt_dts       = tfdt_dts;
+            }
+        }
+    }
+    if (avio_feof(f)) {
+        ret = AVERROR_INVALIDDATA;
+        goto fail;
+    }
+
+    av_log(c->fc, AV_LOG_VERBOSE, "Loaded %u fragments from %s\n",
+           nb_items, c->index_cache);
+    c->frag_index.complete = 1;
+    c->index_cache_loaded  = 1;
+fail:
+    return ff_index_cache_close(c->fc, c->index_cache, &f, ret);
+}
+
+/*
+ * Read the header of the top level box at offset, returns its type or a
+ * negative error code, and sets size to its size.
+ */
+static int64_t mov_read_box_header(AVIOContext *pb, int64_t offset, int64_t end,
+                                   uint64_t *size)
+{
+    uint32_t type;
+
+    if (avio_seek(pb, offset, SEEK_SET) != offset)
+        return AVERROR(EIO);
+    *size = avio_rb32(pb);
+    type  = avio_rl32(pb);
+    if (*size == 1)
+        *size = avio_rb64(pb);
+    else if (!*size)
+        *size = end - offset;
+    if (avio_feof(pb) || *size < 8 || *size > end - offset)
+        return AVERROR_INVALIDDATA;
+    return type;
+}
+
+/*
+ * Read the sequence number of the moof box at offset, and set next to the
+ * offset of the following top level box.
+ */
+static int64_t mov_read_moof_sequence_number(AVIOContext *pb, int64_t offset,
+                                             int64_t end, int64_t *next)
+{
+    uint64_t size, child_size;
+    int64_t type, child = offset + 8;
+
+    type = mov_read_box_header(pb, offset, end, &size);
+    if (type < 0)
+        return type;
+    if (type != MKTAG('m','o','o','f'))
+        return AVERROR_INVALIDDATA;
+    *next = offset + size;
+
+    // the mfhd box is normally the first child
+    while (child < *next) {
+        type = mov_read_box_header(pb, child, *next, &child_size);
+        if (type < 0)
+            return type;
+        if (type == MKTAG('m','f','h','d')) {
+            avio_rb32(pb); // version + flags
+            return avio_rb32(pb);
+        }
+        child += child_size;
+    }
+    return AVERROR_INVALIDDATA;
+}
+
+/*
+ * Check that the fragment index has an entry for every moof box from the
+ * one at offset. The tfra entries only have to list the fragments holding
+ * random access points, so the index read from a mfra box can only be
+ * relied upon once this was checked.
+ *
+ * The moof sequence numbers are increasing, so if the first and the last
+ * indexed fragments are as many sequence numbers apart as there are indexed
+ * fragments, none is missing in between. Only the boxes after the last
+ * indexed fragment are walked, which are normally a mdat and the mfra.
+ * This is a constant number of reads instead of one per fragment.
+ */
+static int mov_frag_index_has_all_moofs(MOVContext *c, AVIOContext *pb, int64_t offset)
+{
+    MOVFragmentIndex *frag_index = &c->frag_index;
+    int64_t pos = avio_tell(pb);
+    int64_t end = avio_size(pb);
+    int64_t last_offset = frag_index->item[frag_index->nb_items - 1].moof_offset;
+    int64_t first_seq, last_seq, next;
+    int ret = 0;
+
+    if (end <= 0 || frag_index->item[0].moof_offset != offset ||
+        last_offset < offset || last_offset >= end)
+        goto end;
+
+    first_seq = mov_read_moof_sequence_number(pb, offset,      end, &next);
+    last_seq  = mov_read_moof_sequence_number(pb, last_offset, end, &next);
+    if (first_seq < 0 || last_seq < 0 ||
+        last_seq - first_seq + 1 != frag_index->nb_items)
+        goto end;
+
+    ret = 1;
+    while (ret && next < end) {
+        uint64_t size;
+        int64_t type = mov_read_box_header(pb, next, end, &size);
+
+        if (type < 0 || type == MKTAG('m','o','o','f'))
+            ret = 0;
+        else if (type == MKTAG('m','f','r','a'))
+            break;
+        next += size;
+    }
+
+end:
+    if (avio_seek(pb, pos, SEEK_SET) != pos)
+        return AVERROR(EIO);
+    return ret;
+}
+
 static int mov_read_moof(MOVContext *c, AVIOContext *pb, MOVAtom atom)
 {
-    if (!c->has_looked_for_mfra && c->use_mfra_for > 0) {
+    if (!c->has_looked_for_index_cache && c->index_cache) {
+        c->has_looked_for_index_cache = 1;
+        if (mov_read_index_cache(c) < 0)
+            av_log(c->fc, AV_LOG_WARNING, "Could not use the index cache %s\n",
+                   c->index_cache);
+    }
+    if (!c->has_looked_for_mfra && (c->use_mfra_for > 0 || c->lazy_fragments)) {
         c->has_looked_for_mfra = 1;
         if (pb->seekable & AVIO_SEEKABLE_NORMAL) {
             int ret;
@@ -1379,6 +1537,18 @@ static int mov_read_moof(MOVContext *c, AVIOContext *pb, MOVAtom atom)
             if ((ret = mov_read_mfra(c, pb)) < 0) {
                 av_log(c->fc, AV_LOG_VERBOSE, "found a moof box but failed to "
                         "read the mfra (may be a live ismv)\n");
+            } else if (c->lazy_fragments && c->frag_index.nb_items) {
+                // If the tfra entries locate every fragment, the remaining
+                // ones can be read when playback or a seek reaches them
+                // instead of during header parsing.
+                ret = mov_frag_index_has_all_moofs(c, pb, avio_tell(pb) - 8);
+                if (ret < 0)
+                    return ret;
+                if (ret)
+                    c->frag_index.complete = 1;
+                else
+                    av_log(c->fc, AV_LOG_VERBOSE, "the mfra does not list "
+                           "every fragment, reading all of them\n");
             }
         } else {
             av_log(c->fc, AV_LOG_VERBOSE, "found a moof box but stream is not "
@@ -4765,7 +4935,13 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     if (entries <= 0)
         return -1;
 
+    // Grow the index geometrically, av_fast_realloc() only adds 1/16 on top
+    // of the requested size, which makes files with many small fragments
+    // reallocate and copy the whole index over and over.
     requested_size = (st->nb_index_entries + entries) * sizeof(AVIndexEntry);
+    if (requested_size < st->index_entries_allocated_size / 2 * 3 &&
+        st->index_entries_allocated_size < UINT_MAX / 3)
+        requested_size = st->index_entries_allocated_size / 2 * 3;
     new_entries = av_fast_realloc(st->index_entries,
                                   &st->index_entries_allocated_size,
                                   requested_size);
@@ -4774,6 +4950,9 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     st->index_entries= new_entries;
 
     requested_size = (st->nb_index_entries + entries) * sizeof(*sc->ctts_data);
+    if (requested_size < sc->ctts_allocated_size / 2 * 3 &&
+        sc->ctts_allocated_size < UINT_MAX / 3)
+        requested_size = sc->ctts_allocated_size / 2 * 3;
     old_ctts_allocated_size = sc->ctts_allocated_size;
     ctts_data = av_fast_realloc(sc->ctts_data, &sc->ctts_allocated_size,
                                 requested_size);
@@ -7365,6 +7544,51 @@ fail:
     return ret;
 }
 
+/* Save the fragment index so that later opens can read fragments lazily. */
+static void mov_write_index_cache(MOVContext *mov)
+{
+    MOVFragmentIndex *frag_index = &mov->frag_index;
+    AVIOContext *f;
+    int i, j, k;
+
+    if (ff_index_cache_open_write(mov->fc, mov->index_cache, &f) < 0)
+        return;
+
+    avio_wb32(f, frag_index->nb_items);
+    for (i = 0; i < frag_index->nb_items; i++) {
+        MOVFragmentIndexItem *item = &frag_index->item[i];
+
+        avio_wb64(f, item->moof_offset);
+        avio_wb32(f, item->nb_stream_info);
+        for (j = 0; j < item->nb_stream_info; j++) {
+            MOVFragmentStreamInfo *frag_stream_info = &item->stream_info[j];
+            int64_t tfdt_dts = frag_stream_info->tfdt_dts;
+
+            // Without a tfdt the fragment timestamps depend on all previous
+            // fragments, store the one computed from them instead.
+            if (tfdt_dts == AV_NOPTS_VALUE && frag_stream_info->index_entry >= 0) {
+                for (k = 0; k < mov->fc->nb_streams; k++) {
+                    AVStream *st = mov->fc->streams[k];
+                    MOVStreamContext *sc = st->priv_data;
+                    if (st->id == frag_stream_info->id &&
+                        frag_stream_info->index_entry < st->nb_index_entries) {
+                        tfdt_dts = st->index_entries[frag_stream_info->index_entry].timestamp +
+                                   sc->time_offset;
+                        break;
+                    }
+                }
+            }
+
+            avio_wb32(f, frag_stream_info->id);
+            avio_wb64(f, frag_stream_info->sidx_pts);
+            avio_wb64(f, frag_stream_info->first_tfra_pts);
+            avio_wb64(f, tfdt_dts);
+        }
+    }
+
+    ff_index_cache_close(mov->fc, mov->index_cache, &f, 0);
+}
+
 static int mov_read_header(AVFormatContext *s)
 {
     MOVContext *mov = s->priv_data;
@@ -7572,6 +7796,12 @@ static int mov_read_header(AVFormatContext *s)
         if (mov->frag_index.item[i].moof_offset <= mov->fragment.moof_offset)
             mov->frag_index.item[i].headers_read = 1;
 
+    // All fragments have been read, unless the index said they can be
+    // read lazily.
+    if (mov->index_cache && !mov->frag_index.complete &&
+        mov->frag_index.nb_items && !(s->flags & AVFMT_FLAG_IGNIDX))
+        mov_write_index_cache(mov);
+
     return 0;
 }
 
@@ -7623,12 +7853,16 @@ static int mov_switch_root(AVFormatContext *s, int64_t target, int index)
     mov->next_root_atom = 0;
     if (index < 0 || index >= mov->frag_index.nb_items)
         index = search_frag_moof_offset(&mov->frag_index, target);
-    if (index < mov->frag_index.nb_items) {
+    if (index < mov->frag_index.nb_items &&
+        mov->frag_index.item[index].moof_offset == target) {
         if (index + 1 < mov->frag_index.nb_items)
             mov->next_root_atom = mov->frag_index.item[index + 1].moof_offset;
         if (mov->frag_index.item[index].headers_read)
             return 0;
         mov->frag_index.item[index].headers_read = 1;
+    } else if (index < mov->frag_index.nb_items) {
+        // target is not an indexed fragment, read up to the next one
+        mov->next_root_atom = mov->frag_index.item[index].moof_offset;
     }
 
     mov->found_mdat = 0;
@@ -7710,7 +7944,12 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
             goto retry;
         }
 
-        ret = av_get_packet(sc->pb, pkt, sample->size);
+        /* the data is modified in place when decrypting or for DV audio */
+        if (!mov->aax_mode && !mov->decryption_key &&
+            !(mov->dv_demux && sc->dv_audio_container))
+            ret = ff_get_packet_ref(sc->pb, pkt, sample->size);
+        else
+            ret = av_get_packet(sc->pb, pkt, sample->size);
         if (ret < 0) {
             if (should_retry(sc->pb, ret)) {
                 mov_current_sample_dec(sc);
@@ -7953,6 +8192,14 @@ static const AVOption mov_options[] = {
         FLAGS, "use_mfra_for" },
     {"pts", "pts", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_MFRA_PTS}, 0, 0,
         FLAGS, "use_mfra_for" },
+    {"lazy_fragments",
+        "use the mfra to read fragment headers only when they are reached or seeked to",
+        OFFSET(lazy_fragments), AV_OPT_TYPE_BOOL, {.i64 = 0},
+        0, 1, FLAGS},
+    {"index_cache",
+        "path of a file caching the fragment index",
+        OFFSET(index_cache), AV_OPT_TYPE_STRING, {.str = NULL},
+        0, 0, FLAGS},
     { "export_all", "Export unrecognized metadata entries", OFFSET(export_all),
         AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, .flags = FLAGS },
     { "export_xmp", "Export full XMP metadata", OFFSET(export_xmp),
@@ -42,6 +42,7 @@
 #include "libavcodec/vc1_common.h"
 #include "libavcodec/raw.h"
 #include "internal.h"
+#include "url.h"
 #include "libavutil/avstring.h"
 #include "libavutil/intfloat.h"
 #include "libavutil/mathematics.h"
@@ -61,6 +62,7 @@ static const AVOption options[] = {
     { "movflags", "MOV muxer flags", offsetof(MOVMuxContext, flags), AV_OPT_TYPE_FLAGS, {.i64 = 0}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "rtphint", "Add RTP hint tracks", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_RTP_HINT}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "moov_size", "maximum moov size so it can be placed at the begin", offsetof(MOVMuxContext, reserved_moov_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, 0 },
+    { "moov_slack", "extra space in percent added to the estimated moov size (reserve_moov)", offsetof(MOVMuxContext, moov_slack), AV_OPT_TYPE_INT, {.i64 = 10}, 0, 1000, AV_OPT_FLAG_ENCODING_PARAM, 0 },
     { "empty_moov", "Make the initial moov atom empty", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_EMPTY_MOOV}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "frag_keyframe", "Fragment at video keyframes", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FRAG_KEYFRAME}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "frag_every_frame", "Fragment at every frame", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FRAG_EVERY_FRAME}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
@@ -68,6 +70,7 @@ static const AVOption options[] = {
     { "frag_custom", "Flush fragments on caller requests", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FRAG_CUSTOM}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "isml", "Create a live smooth streaming feed (for pushing to a publishing point)", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_ISML}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "faststart", "Run a second pass to put the index (moov atom) at the beginning of the file", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_FASTSTART}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
+    { "reserve_moov", "Reserve an estimated space for the moov atom at the beginning of the file", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_RESERVE_MOOV}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "omit_tfhd_offset", "Omit the base data offset in tfhd atoms", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_OMIT_TFHD_OFFSET}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "disable_chpl", "Disable Nero chapter atom", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_DISABLE_CHPL}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
     { "default_base_moof", "Set the default-base-is-moof flag in tfhd atoms", 0, AV_OPT_TYPE_CONST, {.i64 = FF_MOV_FLAG_DEFAULT_BASE_MOOF}, INT_MIN, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM, "movflags" },
@@ -6026,6 +6029,73 @@ static int mov_create_dvd_sub_decoder_specific_info(MOVTrack *track,
     return 0;
 }
 
+/* Upper bounds of the index bytes a sample or a chunk adds to the moov:
+ * stsz, stts and ctts entries per sample, co64 and stsc entries per chunk,
+ * assuming interleaving puts every sample in its own chunk. */
+#define MOV_INDEX_SAMPLE_SIZE   (4 + 8 + 8)
+#define MOV_INDEX_CHUNK_SIZE    (8 + 12)
+#define MOV_INDEX_TRACK_SIZE    1024
+
+static int64_t estimate_nb_samples(AVStream *st)
+{
+    AVCodecParameters *par = st->codecpar;
+    AVRational rate;
+
+    if (st->disposition & AV_DISPOSITION_ATTACHED_PIC)
+        return 1;
+    if (st->nb_frames > 0)
+        return st->nb_frames;
+    if (st->duration <= 0 || st->duration == AV_NOPTS_VALUE)
+        return -1;
+
+    switch (par->codec_type) {
+    case AVMEDIA_TYPE_VIDEO:
+        rate = st->avg_frame_rate.num > 0 ? st->avg_frame_rate : st->r_frame_rate;
+        break;
+    case AVMEDIA_TYPE_AUDIO:
+        rate = (AVRational){ par->sample_rate,
+                             par->frame_size > 0 ? par->frame_size : 1024 };
+        break;
+    default:
+        /* subtitles and data rarely exceed a few samples per second */
+        rate = (AVRational){ 4, 1 };
+        break;
+    }
+    if (rate.num <= 0 || rate.den <= 0)
+        return -1;
+
+    return av_rescale_q_rnd(st->duration, st->time_base, av_inv_q(rate),
+                            AV_ROUND_UP);
+}
+
+/*
+ * Estimate the size of the final moov atom from the sample count of every
+ * stream, known from nb_frames or from the duration and the frame rate.
+ * @return the estimated size, or a negative value if a stream has neither
+ */
+static int64_t estimate_moov_size(AVFormatContext *s)
+{
+    MOVMuxContext *mov = s->priv_data;
+    int64_t size = MOV_INDEX_TRACK_SIZE * (s->nb_streams + 1) + 4 * s->nb_chapters;
+    int i;
+
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        int64_t nb_samples = estimate_nb_samples(st);
+
+        if (nb_samples < 0) {
+            av_log(s, AV_LOG_WARNING, "Cannot estimate the number of samples "
+                   "of stream %d, set its duration or nb_frames\n", i);
+            return -1;
+        }
+        size += nb_samples * (MOV_INDEX_SAMPLE_SIZE + MOV_INDEX_CHUNK_SIZE);
+        if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+            size += nb_samples * 4; /* stss */
+    }
+
+    return size + size * mov->moov_slack / 100;
+}
+
 static int mov_init(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -6077,7 +6147,26 @@ static int mov_init(AVFormatContext *s)
         mov->flags &= ~FF_MOV_FLAG_SKIP_SIDX;
     }
 
-    if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+    if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV) {
+        int64_t size = -1;
+
+        if (mov->flags & FF_MOV_FLAG_FRAGMENT)
+            av_log(s, AV_LOG_WARNING, "reserve_moov is not supported with fragmented output\n");
+        else if (mov->reserved_moov_size > 0)
+            size = mov->reserved_moov_size;
+        else
+            size = estimate_moov_size(s);
+
+        if (size > 0 && size <= INT_MAX) {
+            mov->reserved_moov_size = size;
+        } else {
+            av_log(s, AV_LOG_WARNING, "Not reserving space for the moov atom\n");
+            mov->flags &= ~FF_MOV_FLAG_RESERVE_MOOV;
+        }
+    }
+
+    if (mov->flags & FF_MOV_FLAG_FASTSTART &&
+        !(mov->flags & FF_MOV_FLAG_RESERVE_MOOV)) {
         mov->reserved_moov_size = -1;
     }
 
@@ -6409,7 +6498,11 @@ static int mov_write_header(AVFormatContext *s)
 
     if (mov->reserved_moov_size){
         mov->reserved_header_pos = avio_tell(pb);
-        if (mov->reserved_moov_size > 0)
+        if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV) {
+            avio_wb32(pb, mov->reserved_moov_size);
+            ffio_wfourcc(pb, "free");
+            ffio_fill(pb, 0, mov->reserved_moov_size - 8);
+        } else if (mov->reserved_moov_size > 0)
             avio_skip(pb, mov->reserved_moov_size);
     }
 
@@ -6421,7 +6514,8 @@ static int mov_write_header(AVFormatContext *s)
             !mov->max_fragment_duration && !mov->max_fragment_size)
             mov->flags |= FF_MOV_FLAG_FRAG_KEYFRAME;
     } else {
-        if (mov->flags & FF_MOV_FLAG_FASTSTART)
+        if (mov->flags & FF_MOV_FLAG_FASTSTART &&
+            !(mov->flags & FF_MOV_FLAG_RESERVE_MOOV))
             mov->reserved_header_pos = avio_tell(pb);
         mov_write_mdat_tag(pb, mov);
     }
@@ -6620,6 +6714,46 @@ end:
     return ret;
 }
 
+/*
+ * Write the moov atom into the space reserved with the reserve_moov flag.
+ * If the estimate was too small, fall back to the faststart second pass if
+ * it was requested, or to writing the moov atom at the end of the file.
+ */
+static int mov_write_reserved_moov(AVFormatContext *s, int64_t moov_pos)
+{
+    MOVMuxContext *mov = s->priv_data;
+    AVIOContext *pb = s->pb;
+    int64_t size;
+    int res, moov_size;
+
+    if ((moov_size = get_moov_size(s)) < 0)
+        return moov_size;
+
+    if (moov_size + 8 > mov->reserved_moov_size) {
+        av_log(s, AV_LOG_WARNING, "The reserved moov space is too small, "
+               "needed %d bytes, reserved %d\n", moov_size + 8,
+               mov->reserved_moov_size);
+        avio_seek(pb, moov_pos, SEEK_SET);
+        if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+            av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
+            if ((res = shift_data(s)) < 0)
+                return res;
+            avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
+        }
+        return mov_write_moov_tag(pb, mov, s);
+    }
+
+    avio_seek(pb, mov->reserved_header_pos, SEEK_SET);
+    if ((res = mov_write_moov_tag(pb, mov, s)) < 0)
+        return res;
+    size = mov->reserved_moov_size - (avio_tell(pb) - mov->reserved_header_pos);
+    avio_wb32(pb, size);
+    ffio_wfourcc(pb, "free");
+    ffio_fill(pb, 0, size - 8);
+    avio_seek(pb, moov_pos, SEEK_SET);
+    return 0;
+}
+
 static int mov_write_trailer(AVFormatContext *s)
 {
     MOVMuxContext *mov = s->priv_data;
@@ -6684,7 +6818,10 @@ static int mov_write_trailer(AVFormatContext *s)
         }
         avio_seek(pb, mov->reserved_moov_size > 0 ? mov->reserved_header_pos : moov_pos, SEEK_SET);
 
-        if (mov->flags & FF_MOV_FLAG_FASTSTART) {
+        if (mov->flags & FF_MOV_FLAG_RESERVE_MOOV) {
+            if ((res = mov_write_reserved_moov(s, moov_pos)) < 0)
+                return res;
+        } else if (mov->flags & FF_MOV_FLAG_FASTSTART) {
             av_log(s, AV_LOG_INFO, "Starting second pass: moving the moov atom to the beginning of the file\n");
             res = shift_data(s);
             if (res < 0)
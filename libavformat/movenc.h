@@ -208,6 +208,7 @@ typedef struct MOVMuxContext {
 
     int reserved_moov_size; ///< 0 for disabled, -1 for automatic, size otherwise
     int64_t reserved_header_pos;
+    int moov_slack;         ///< extra space in percent of the estimated moov size
 
     char *major_brand;
 
@@ -258,6 +259,7 @@ typedef struct MOVMuxContext {
 #define FF_MOV_FLAG_NEGATIVE_CTS_OFFSETS  (1 << 19)
 #define FF_MOV_FLAG_FRAG_EVERY_FRAME      (1 << 20)
 #define FF_MOV_FLAG_SKIP_SIDX             (1 << 21)
+#define FF_MOV_FLAG_RESERVE_MOOV          (1 << 22)
 
 int ff_mov_write_packet(AVFormatContext *s, AVPacket *pkt);
 
@@ -35,6 +35,7 @@
 #include "mpegts.h"
 #include "internal.h"
 #include "avio_internal.h"
+#include "indexcache.h"
 #include "mpeg.h"
 #include "isom.h"
 
@@ -150,6 +151,12 @@ struct MpegTSContext {
     int resync_size;
     int merge_pmt_versions;
 
+    /** path of the sidecar file caching the seek index */
+    char *index_cache;
+    int index_cache_loaded;
+    /** end of the byte range read linearly from the start of the data */
+    int64_t index_scan_end;
+
     /******************************************/
     /* private mpegts data */
     /* scan context */
@@ -182,6 +189,8 @@ static const AVOption options[] = {
      {.i64 = 0}, 0, 1, 0 },
     {"skip_clear", "skip clearing programs", offsetof(MpegTSContext, skip_clear), AV_OPT_TYPE_BOOL,
      {.i64 = 0}, 0, 1, 0 },
+    {"index_cache", "path of a file caching the seek index", offsetof(MpegTSContext, index_cache), AV_OPT_TYPE_STRING,
+     {.str = NULL}, 0, 0, AV_OPT_FLAG_DECODING_PARAM },
     { NULL },
 };
 
@@ -2927,6 +2936,15 @@ static int mpegts_read_header(AVFormatContext *s)
     }
 
     seek_back(s, pb, pos);
+
+    if (ts->index_cache) {
+        int ret = ff_index_cache_read_index(s, ts->index_cache);
+        if (ret < 0)
+            av_log(s, AV_LOG_WARNING, "Could not use the index cache\n");
+        ts->index_cache_loaded = ret > 0;
+        ts->index_scan_end     = avio_tell(pb);
+    }
+
     return 0;
 }
 
@@ -2980,9 +2998,46 @@ static int mpegts_raw_read_packet(AVFormatContext *s, AVPacket *pkt)
     return 0;
 }
 
+/* Map a dts to the timestamps returned by av_read_frame(), which are
+ * corrected against the stream wrap reference, see wrap_timestamp(). */
+static int64_t wrap_index_dts(const AVStream *st, int64_t dts)
+{
+    dts &= (1LL << st->pts_wrap_bits) - 1;
+    if (st->pts_wrap_reference != AV_NOPTS_VALUE) {
+        if (st->pts_wrap_behavior == AV_PTS_WRAP_ADD_OFFSET &&
+            dts < st->pts_wrap_reference)
+            return dts + (1LL << st->pts_wrap_bits);
+        else if (st->pts_wrap_behavior == AV_PTS_WRAP_SUB_OFFSET &&
+                 dts >= st->pts_wrap_reference)
+            return dts - (1LL << st->pts_wrap_bits);
+    }
+    return dts;
+}
+
+/* Unwrap a dts next to the last index entry, so that the index stays
+ * ordered across any number of timestamp wraps. */
+static int64_t index_dts(AVStream *st, int64_t dts)
+{
+    int64_t wrap = 1LL << st->pts_wrap_bits, last, delta;
+
+    if (st->pts_wrap_bits >= 63)
+        return dts;
+    if (!st->nb_index_entries)
+        return wrap_index_dts(st, dts);
+    /* the first entry was added before the wrap reference was known */
+    if (st->nb_index_entries == 1)
+        st->index_entries[0].timestamp = wrap_index_dts(st, st->index_entries[0].timestamp);
+    last  = st->index_entries[st->nb_index_entries - 1].timestamp;
+    delta = (dts - last) & (wrap - 1);
+    if (delta >= wrap / 2)
+        delta -= wrap;
+    return last + delta;
+}
+
 static int mpegts_read_packet(AVFormatContext *s, AVPacket *pkt)
 {
     MpegTSContext *ts = s->priv_data;
+    int64_t pos = avio_tell(s->pb);
     int ret, i;
 
     pkt->size = -1;
@@ -3007,6 +3062,21 @@ static int mpegts_read_packet(AVFormatContext *s, AVPacket *pkt)
 
     if (!ret && pkt->size < 0)
         ret = AVERROR_INVALIDDATA;
+
+    if (ts->index_cache && !ts->index_cache_loaded) {
+        /* Build the index while reading, it can only be cached once the
+         * whole file has been read without skipping anything. */
+        if (pos <= ts->index_scan_end)
+            ts->index_scan_end = FFMAX(ts->index_scan_end, avio_tell(s->pb));
+        if (!ret && pkt->dts != AV_NOPTS_VALUE && pkt->pos >= 0) {
+            AVStream *st = s->streams[pkt->stream_index];
+            ff_reduce_index(s, pkt->stream_index);
+            ff_add_index_entry(&st->index_entries, &st->nb_index_entries,
+                               &st->index_entries_allocated_size, pkt->pos,
+                               index_dts(st, pkt->dts), 0, 0,
+                               pkt->flags & AV_PKT_FLAG_KEY ? AVINDEX_KEYFRAME : 0);
+        }
+    }
     return ret;
 }
 
@@ -3024,10 +3094,35 @@ static void mpegts_free(MpegTSContext *ts)
 static int mpegts_read_close(AVFormatContext *s)
 {
     MpegTSContext *ts = s->priv_data;
+
+    if (ts->index_cache && !ts->index_cache_loaded && s->pb &&
+        ts->index_scan_end + ts->raw_packet_size > avio_size(s->pb))
+        ff_index_cache_write_index(s, ts->index_cache);
+
     mpegts_free(ts);
     return 0;
 }
 
+static int mpegts_read_seek(AVFormatContext *s, int stream_index,
+                            int64_t timestamp, int flags)
+{
+    MpegTSContext *ts = s->priv_data;
+    AVStream *st = s->streams[stream_index];
+    int index;
+
+    /* Without a cached index, let the generic code bisect the file. */
+    if (!ts->index_cache_loaded)
+        return -1;
+
+    index = av_index_search_timestamp(st, timestamp, flags);
+    if (index < 0)
+        return -1;
+    if (avio_seek(s->pb, st->index_entries[index].pos, SEEK_SET) < 0)
+        return -1;
+    ff_update_cur_dts(s, st, st->index_entries[index].timestamp);
+    return 0;
+}
+
 static av_unused int64_t mpegts_get_pcr(AVFormatContext *s, int stream_index,
                               int64_t *ppos, int64_t pos_limit)
 {
@@ -3157,6 +3252,7 @@ AVInputFormat ff_mpegts_demuxer = {
     .read_header    = mpegts_read_header,
     .read_packet    = mpegts_read_packet,
     .read_close     = mpegts_read_close,
+    .read_seek      = mpegts_read_seek,
     .read_timestamp = mpegts_get_dts,
     .flags          = AVFMT_SHOW_IDS | AVFMT_TS_DISCONT,
     .priv_class     = &mpegts_class,
@@ -115,6 +115,11 @@ typedef struct MpegTSWrite {
     int64_t last_sdt_ts;
 
     int omit_video_pes_length;
+
+    int batch_packets;
+    uint8_t *batch_buf; ///< TS packets not passed to the AVIOContext yet
+    int batch_buf_size;
+    int batch_len;
 } MpegTSWrite;
 
 /* a PES packet header is generated every DEFAULT_PES_HEADER_FREQ packets */
@@ -738,27 +743,45 @@ fail:
 
 static int64_t get_pcr(const MpegTSWrite *ts, AVIOContext *pb)
 {
-    return av_rescale(avio_tell(pb) + 11, 8 * PCR_TIME_BASE, ts->mux_rate) +
-           ts->first_pcr;
+    return av_rescale(avio_tell(pb) + ts->batch_len + 11,
+                      8 * PCR_TIME_BASE, ts->mux_rate) + ts->first_pcr;
+}
+
+static void mpegts_flush_batch(AVFormatContext *s)
+{
+    MpegTSWrite *ts = s->priv_data;
+
+    avio_write(s->pb, ts->batch_buf, ts->batch_len);
+    ts->batch_len = 0;
 }
 
-static void mpegts_prefix_m2ts_header(AVFormatContext *s)
+/* Return room for the next TS packet in the batch, after the m2ts header. */
+static uint8_t *mpegts_batch_packet(AVFormatContext *s)
 {
     MpegTSWrite *ts = s->priv_data;
+    uint8_t *q;
+
+    if (ts->batch_len + TS_PACKET_SIZE + 4 > ts->batch_buf_size)
+        mpegts_flush_batch(s);
+    q = ts->batch_buf + ts->batch_len;
     if (ts->m2ts_mode) {
-        int64_t pcr = get_pcr(s->priv_data, s->pb);
-        uint32_t tp_extra_header = pcr % 0x3fffffff;
-        tp_extra_header = AV_RB32(&tp_extra_header);
-        avio_write(s->pb, (unsigned char *) &tp_extra_header,
-                   sizeof(tp_extra_header));
+        int64_t pcr = get_pcr(ts, s->pb);
+        AV_WB32(q, pcr % 0x3fffffff);
+        q             += 4;
+        ts->batch_len += 4;
     }
+    ts->batch_len += TS_PACKET_SIZE;
+    return q;
+}
+
+static void mpegts_write_ts_packet(AVFormatContext *s, const uint8_t *packet)
+{
+    memcpy(mpegts_batch_packet(s), packet, TS_PACKET_SIZE);
 }
 
 static void section_write_packet(MpegTSSection *s, const uint8_t *packet)
 {
-    AVFormatContext *ctx = s->opaque;
-    mpegts_prefix_m2ts_header(ctx);
-    avio_write(ctx->pb, packet, TS_PACKET_SIZE);
+    mpegts_write_ts_packet(s->opaque, packet);
 }
 
 static int mpegts_init(AVFormatContext *s)
@@ -780,6 +803,11 @@ static int mpegts_init(AVFormatContext *s)
     // round up to a whole number of TS packets
     ts->pes_payload_size = (ts->pes_payload_size + 14 + 183) / 184 * 184 - 14;
 
+    ts->batch_buf_size = ts->batch_packets * (TS_PACKET_SIZE + 4);
+    ts->batch_buf      = av_malloc(ts->batch_buf_size);
+    if (!ts->batch_buf)
+        return AVERROR(ENOMEM);
+
     ts->tsid = ts->transport_stream_id;
     ts->onid = ts->original_network_id;
     if (!s->nb_programs) {
@@ -1080,8 +1108,7 @@ static void mpegts_insert_null_packet(AVFormatContext *s)
     *q++ = 0xff;
     *q++ = 0x10;
     memset(q, 0x0FF, TS_PACKET_SIZE - (q - buf));
-    mpegts_prefix_m2ts_header(s);
-    avio_write(s->pb, buf, TS_PACKET_SIZE);
+    mpegts_write_ts_packet(s, buf);
 }
 
 /* Write a single transport stream packet with a PCR and no payload */
@@ -1110,8 +1137,76 @@ static void mpegts_insert_pcr_only(AVFormatContext *s, AVStream *st)
 
     /* stuffing bytes */
     memset(q, 0xFF, TS_PACKET_SIZE - (q - buf));
-    mpegts_prefix_m2ts_header(s);
-    avio_write(s->pb, buf, TS_PACKET_SIZE);
+    mpegts_write_ts_packet(s, buf);
+}
+
+/* Number of times count can be incremented before it equals period. */
+static int packets_before(int count, int period)
+{
+    return count < period ? period - count - 1 : INT_MAX;
+}
+
+/*
+ * Return how many of the next packets of the current PES packet carry
+ * nothing but payload: no tables are due before them, and they need
+ * neither a PCR, nor stuffing, nor null packets in front of them.
+ */
+static int mpegts_plain_packets(AVFormatContext *s, MpegTSWriteStream *ts_st,
+                                int payload_size, int64_t dts, int64_t delay)
+{
+    MpegTSWrite *ts = s->priv_data;
+    MpegTSService *service = ts_st->service;
+    /* the last packet may need stuffing */
+    int n = (payload_size - 1) / (TS_PACKET_SIZE - 4);
+
+    if (n <= 0 || ts_st->discontinuity)
+        return 0;
+    if (dts != AV_NOPTS_VALUE &&
+        (ts->last_sdt_ts == AV_NOPTS_VALUE ||
+         dts - ts->last_sdt_ts >= ts->sdt_period*90000.0 ||
+         ts->last_pat_ts == AV_NOPTS_VALUE ||
+         dts - ts->last_pat_ts >= ts->pat_period*90000.0))
+        return 0;
+    n = FFMIN(n, packets_before(ts->sdt_packet_count, ts->sdt_packet_period));
+    n = FFMIN(n, packets_before(ts->pat_packet_count, ts->pat_packet_period));
+
+    if (ts_st->pid == service->pcr_pid) {
+        if (ts->mux_rate > 1)
+            n = FFMIN(n, service->pcr_packet_period - service->pcr_packet_count - 1);
+        else if (service->pcr_packet_count >= service->pcr_packet_period)
+            return 0;
+    }
+    /* the PCR only grows, so if no null packet is needed before the first
+     * packet, none is needed before the following ones either */
+    if (ts->mux_rate > 1 && dts != AV_NOPTS_VALUE &&
+        (dts - get_pcr(ts, s->pb) / 300) > delay)
+        return 0;
+
+    return FFMAX(n, 0);
+}
+
+/* Write n full payload-only packets straight into the batch. */
+static void mpegts_write_plain_packets(AVFormatContext *s,
+                                       MpegTSWriteStream *ts_st,
+                                       const uint8_t *payload, int n)
+{
+    MpegTSWrite *ts = s->priv_data;
+    uint32_t header = 0x47000010 | ts_st->pid << 8;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        uint8_t *q = mpegts_batch_packet(s);
+
+        ts_st->cc = ts_st->cc + 1 & 0xf;
+        AV_WB32(q, header | ts_st->cc);
+        memcpy(q + 4, payload, TS_PACKET_SIZE - 4);
+        payload += TS_PACKET_SIZE - 4;
+    }
+
+    ts->sdt_packet_count += n;
+    ts->pat_packet_count += n;
+    if (ts_st->pid == ts_st->service->pcr_pid && ts->mux_rate > 1)
+        ts_st->service->pcr_packet_count += n;
 }
 
 static void write_pts(uint8_t *q, int fourbits, int64_t pts)
@@ -1186,6 +1281,16 @@ static void mpegts_write_pes(AVFormatContext *s, AVStream *st,
 
     is_start = 1;
     while (payload_size > 0) {
+        if (!is_start) {
+            int n = mpegts_plain_packets(s, ts_st, payload_size, dts, delay);
+            if (n > 0) {
+                mpegts_write_plain_packets(s, ts_st, payload, n);
+                payload      += n * (TS_PACKET_SIZE - 4);
+                payload_size -= n * (TS_PACKET_SIZE - 4);
+                continue;
+            }
+        }
+
         retransmit_si_info(s, force_pat, dts);
         force_pat = 0;
 
@@ -1421,9 +1526,9 @@ static void mpegts_write_pes(AVFormatContext *s, AVStream *st,
 
         payload      += len;
         payload_size -= len;
-        mpegts_prefix_m2ts_header(s);
-        avio_write(s->pb, buf, TS_PACKET_SIZE);
+        mpegts_write_ts_packet(s, buf);
     }
+    mpegts_flush_batch(s);
     ts_st->prev_payload_key = key;
 }
 
@@ -1844,6 +1949,7 @@ static void mpegts_deinit(AVFormatContext *s)
         av_freep(&service);
     }
     av_freep(&ts->services);
+    av_freep(&ts->batch_buf);
 }
 
 static int mpegts_check_bitstream(struct AVFormatContext *s, const AVPacket *pkt)
@@ -1960,6 +2066,9 @@ static const AVOption options[] = {
     { "sdt_period", "SDT retransmission time limit in seconds",
       offsetof(MpegTSWrite, sdt_period), AV_OPT_TYPE_DOUBLE,
       { .dbl = INT_MAX }, 0, INT_MAX, AV_OPT_FLAG_ENCODING_PARAM },
+    { "batch_packets", "Number of TS packets passed to the output at once",
+      offsetof(MpegTSWrite, batch_packets), AV_OPT_TYPE_INT,
+      { .i64 = 64 }, 1, 1024, AV_OPT_FLAG_ENCODING_PARAM },
     { NULL },
 };
 
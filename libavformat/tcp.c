@@ -116,10 +116,6 @@ static int tcp_open(URLContext *h, const char *uri, int flags)
         &port, path, sizeof(path), uri);
     if (strcmp(proto, "tcp"))
         return AVERROR(EINVAL);
-    if (port <= 0 || port >= 65536) {
-        av_log(h, AV_LOG_ERROR, "Port missing in uri\n");
-        return AVERROR(EINVAL);
-    }
     p = strchr(uri, '?');
     if (p) {
         if (av_find_info_tag(buf, sizeof(buf), "listen", p)) {
@@ -136,6 +132,11 @@ static int tcp_open(URLContext *h, const char *uri, int flags)
             s->listen_timeout = strtol(buf, NULL, 10);
         }
     }
+    /* port 0 lets the system pick a free port to listen on */
+    if (port < 0 || port >= 65536 || !port && !s->listen) {
+        av_log(h, AV_LOG_ERROR, "Port missing in uri\n");
+        return AVERROR(EINVAL);
+    }
     if (s->rw_timeout >= 0) {
         s->open_timeout =
         h->rw_timeout   = s->rw_timeout;
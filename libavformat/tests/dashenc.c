@@ -0,0 +1,213 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Test of the dash muxer: the output is kept in memory through custom
+ * io_open/io_close callbacks, which count the uploads of every file, and
+ * the fragments of the media segments are counted from their box headers.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavformat/avformat.h"
+
+#define MAX_FILES  32
+#define FPS        25
+#define DURATION   3        ///< seconds
+#define GOP_SIZE   5
+
+typedef struct OutputFile {
+    char name[64];
+    AVIOContext *pb;        ///< set while the file is open
+    uint8_t *data;          ///< last uploaded content
+    int size;
+    int nb_uploads;
+} OutputFile;
+
+static OutputFile files[MAX_FILES];
+static int nb_files;
+
+static OutputFile *find_file(const char *name)
+{
+    int i;
+
+    for (i = 0; i < nb_files; i++)
+        if (!strcmp(files[i].name, name))
+            return &files[i];
+    if (nb_files == MAX_FILES)
+        return NULL;
+    av_strlcpy(files[nb_files].name, name, sizeof(files[nb_files].name));
+    return &files[nb_files++];
+}
+
+static int io_open(AVFormatContext *s, AVIOContext **pb, const char *url,
+                   int flags, AVDictionary **options)
+{
+    const char *name = strrchr(url, '/');
+    OutputFile *f;
+    int ret;
+
+    /* the muxer only reads its output back to look for a single file sidx */
+    if (!(flags & AVIO_FLAG_WRITE))
+        return AVERROR(ENOENT);
+    if (!(f = find_file(name ? name + 1 : url)) || f->pb)
+        return AVERROR(EINVAL);
+    if ((ret = avio_open_dyn_buf(pb)) < 0)
+        return ret;
+    f->pb = *pb;
+    return 0;
+}
+
+static void io_close(AVFormatContext *s, AVIOContext *pb)
+{
+    int i;
+
+    for (i = 0; i < nb_files; i++) {
+        OutputFile *f = &files[i];
+
+        if (f->pb != pb)
+            continue;
+        av_freep(&f->data);
+        f->size = avio_close_dyn_buf(pb, &f->data);
+        f->pb   = NULL;
+        f->nb_uploads++;
+        return;
+    }
+    avio_close(pb);
+}
+
+/* Count the top level boxes of the given type. */
+static int count_boxes(const OutputFile *f, uint32_t type)
+{
+    int64_t pos = 0, size;
+    int count = 0;
+
+    while (pos + 8 <= f->size) {
+        size = AV_RB32(f->data + pos);
+        if (size == 1 && pos + 16 <= f->size)
+            size = AV_RB64(f->data + pos + 8);
+        else if (!size)
+            size = f->size - pos;
+        if (size < 8)
+            return -1;
+        count += AV_RL32(f->data + pos + 4) == type;
+        pos   += size;
+    }
+    return pos == f->size ? count : -1;
+}
+
+static int mux(const char *frag_type)
+{
+    AVFormatContext *oc = NULL;
+    AVDictionary *opts = NULL;
+    AVStream *st;
+    AVPacket pkt;
+    uint8_t data[1000] = { 0 };
+    int i, ret;
+
+    if ((ret = avformat_alloc_output_context2(&oc, NULL, "dash", "mem://out.mpd")) < 0)
+        return ret;
+    oc->flags   |= AVFMT_FLAG_BITEXACT;
+    oc->io_open  = io_open;
+    oc->io_close = io_close;
+    if (!(st = avformat_new_stream(oc, NULL))) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    st->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+    st->codecpar->codec_id   = AV_CODEC_ID_MPEG4;
+    st->codecpar->width      = 128;
+    st->codecpar->height     = 96;
+    st->codecpar->bit_rate   = 100000;
+    st->time_base            = (AVRational){ 1, FPS };
+    st->avg_frame_rate       = (AVRational){ FPS, 1 };
+
+    av_dict_set(&opts, "use_template", "1", 0);
+    av_dict_set(&opts, "use_timeline", "0", 0);
+    av_dict_set(&opts, "seg_duration", "1", 0);
+    av_dict_set(&opts, "frag_type", frag_type, 0);
+    ret = avformat_write_header(oc, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+        goto end;
+
+    for (i = 0; i < FPS * DURATION; i++) {
+        av_init_packet(&pkt);
+        pkt.data     = data;
+        pkt.size     = sizeof(data);
+        pkt.pts      = pkt.dts = av_rescale_q(i, (AVRational){ 1, FPS }, st->time_base);
+        pkt.duration = av_rescale_q(1, (AVRational){ 1, FPS }, st->time_base);
+        pkt.flags    = i % GOP_SIZE ? 0 : AV_PKT_FLAG_KEY;
+        AV_WB32(data, i);
+        if ((ret = av_write_frame(oc, &pkt)) < 0)
+            goto end;
+    }
+    ret = av_write_trailer(oc);
+
+end:
+    avformat_free_context(oc);
+    return ret;
+}
+
+static void free_files(void)
+{
+    int i;
+
+    for (i = 0; i < nb_files; i++)
+        av_freep(&files[i].data);
+    memset(files, 0, sizeof(files));
+    nb_files = 0;
+}
+
+static int run(const char *frag_type)
+{
+    int i, nb_segments = 0, ret;
+
+    printf("frag_type %s\n", frag_type);
+    if ((ret = mux(frag_type)) < 0) {
+        printf("muxing failed: %s\n", av_err2str(ret));
+        return ret;
+    }
+
+    for (i = 0; i < nb_files; i++) {
+        const OutputFile *f = &files[i];
+
+        if (strncmp(f->name, "chunk-", 6))
+            continue;
+        nb_segments++;
+        printf("%s moof=%d sidx=%d uploads=%d\n", f->name,
+               count_boxes(f, MKTAG('m', 'o', 'o', 'f')),
+               count_boxes(f, MKTAG('s', 'i', 'd', 'x')), f->nb_uploads);
+    }
+    /* only the first live manifest and the final one differ in more than
+     * their publishTime */
+    printf("%d segments, manifest uploads=%d\n", nb_segments,
+           find_file("out.mpd")->nb_uploads);
+    free_files();
+    return 0;
+}
+
+int main(void)
+{
+    if (run("none") < 0 || run("gop") < 0)
+        return 1;
+    return 0;
+}
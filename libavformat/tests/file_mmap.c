@@ -0,0 +1,117 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Test of the packet references of the file protocol mmap mode: large
+ * packets must reference the file data and be followed by zero padding,
+ * without changing the data of the following packets.
+ */
+
+#include <stdio.h>
+
+#include "libavutil/mem.h"
+#include "libavformat/avformat.h"
+#include "libavformat/internal.h"
+
+static const int packet_sizes[] = { 100000, 100, 100000 };
+
+static uint8_t packet_byte(int index, int i)
+{
+    return 0x80 | ((index * 31 + i) & 0x7f);
+}
+
+static int write_file(const char *filename)
+{
+    AVIOContext *pb = NULL;
+    int i, j, ret;
+
+    if ((ret = avio_open(&pb, filename, AVIO_FLAG_WRITE)) < 0)
+        return ret;
+    for (i = 0; i < FF_ARRAY_ELEMS(packet_sizes); i++)
+        for (j = 0; j < packet_sizes[i]; j++)
+            avio_w8(pb, packet_byte(i, j));
+    return avio_closep(&pb);
+}
+
+static int check_packet(const AVPacket *pkt, int index)
+{
+    int i;
+
+    if (pkt->size != packet_sizes[index])
+        return AVERROR(EINVAL);
+    for (i = 0; i < pkt->size; i++)
+        if (pkt->data[i] != packet_byte(index, i))
+            return AVERROR(EINVAL);
+    for (i = 0; i < AV_INPUT_BUFFER_PADDING_SIZE; i++)
+        if (pkt->data[pkt->size + i])
+            return AVERROR(EINVAL);
+    return 0;
+}
+
+static int read_file(const char *filename, const char *mode)
+{
+    AVIOContext *pb = NULL;
+    AVDictionary *options = NULL;
+    AVPacket pkts[FF_ARRAY_ELEMS(packet_sizes)];
+    int i, nb_pkts = 0, ret;
+
+    av_dict_set(&options, "mmap", !strcmp(mode, "mmap") ? "1" : "0", 0);
+    ret = avio_open2(&pb, filename, AVIO_FLAG_READ, NULL, &options);
+    av_dict_free(&options);
+    if (ret < 0)
+        return ret;
+
+    /* keep all the packets, so that the padding of a packet is checked
+     * after the following ones were read */
+    for (i = 0; i < FF_ARRAY_ELEMS(packet_sizes); i++) {
+        if ((ret = ff_get_packet_ref(pb, &pkts[i], packet_sizes[i])) < 0)
+            goto end;
+        nb_pkts++;
+    }
+    for (i = 0; i < nb_pkts; i++) {
+        ret = check_packet(&pkts[i], i);
+        /* only the packets copied in a buffer of their own are writable */
+        printf("%s: packet %d: %d bytes, %s, %s\n", mode, i, pkts[i].size,
+               av_buffer_is_writable(pkts[i].buf) ? "copied" : "referenced",
+               ret < 0 ? "corrupted" : "ok");
+        if (ret < 0)
+            goto end;
+    }
+
+end:
+    for (i = 0; i < nb_pkts; i++)
+        av_packet_unref(&pkts[i]);
+    avio_closep(&pb);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int ret;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <temporary file>\n", argv[0]);
+        return 1;
+    }
+    if ((ret = write_file(argv[1])) < 0 ||
+        (ret = read_file(argv[1], "mmap")) < 0 ||
+        (ret = read_file(argv[1], "read")) < 0)
+        fprintf(stderr, "%s\n", av_err2str(ret));
+    remove(argv[1]);
+    return ret < 0;
+}
@@ -0,0 +1,359 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Test of the hls muxer async_io option: the segments and playlists are
+ * uploaded to a local HTTP server, which checks that every segment is
+ * uploaded before a playlist referencing it, and an upload failure must be
+ * reported by the muxer.
+ */
+
+#include "config.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/bprint.h"
+#include "libavutil/opt.h"
+#include "libavutil/thread.h"
+#include "libavformat/avformat.h"
+#include "libavformat/avio_internal.h"
+#include "libavformat/network.h"
+#include "libavformat/url.h"
+
+#define MAX_UPLOADS     64
+#define NB_PACKETS      200
+#define PACKET_SIZE     384
+#define PACKET_DURATION 1152
+#define SAMPLE_RATE     48000
+
+typedef struct Upload {
+    char resource[64];
+    int64_t size;
+    char *body;             ///< playlists only
+} Upload;
+
+typedef struct TestServer {
+    AVIOContext *server;
+    pthread_t thread;
+    Upload uploads[MAX_UPLOADS];
+    int nb_uploads;
+} TestServer;
+
+/* Read the body of one request, returns 1 when asked to quit. */
+static int serve_client(TestServer *srv, AVIOContext *client)
+{
+    Upload *up = srv->nb_uploads < MAX_UPLOADS ? &srv->uploads[srv->nb_uploads] : NULL;
+    AVBPrint body;
+    uint8_t buf[4096];
+    char *resource = NULL;
+    int ret, n, quit = 0;
+
+    /* the muxer uploads with PUT, POST is expected by default */
+    if ((ret = av_opt_set(client, "method", "PUT", AV_OPT_SEARCH_CHILDREN)) < 0)
+        goto end;
+    /* only read the request headers: the muxer does not wait for a reply,
+     * and the connection is closed once the last chunk of the body is read */
+    while ((ret = avio_handshake(client)) > 0) {
+        av_opt_get(client, "resource", AV_OPT_SEARCH_CHILDREN, (uint8_t **)&resource);
+        if (resource && *resource)
+            break;
+        av_freep(&resource);
+    }
+    if (ret < 0 || !resource)
+        goto end;
+
+    /* the body is read even when asked to quit, so that the connection
+     * gets closed */
+    av_bprint_init(&body, 0, AV_BPRINT_SIZE_UNLIMITED);
+    while ((n = avio_read(client, buf, sizeof(buf))) > 0)
+        av_bprint_append_data(&body, (const char *)buf, n);
+    if (!strcmp(resource, "/quit")) {
+        quit = 1;
+    } else if (up) {
+        av_strlcpy(up->resource, resource, sizeof(up->resource));
+        up->size = body.len;
+        if (av_match_ext(resource, "m3u8"))
+            av_bprint_finalize(&body, &up->body);
+        srv->nb_uploads++;
+    }
+    av_bprint_finalize(&body, NULL);
+
+end:
+    av_freep(&resource);
+    avio_closep(&client);
+    return quit;
+}
+
+static void *server_thread(void *arg)
+{
+    TestServer *srv = arg;
+
+    for (;;) {
+        AVIOContext *client = NULL;
+
+        if (avio_accept(srv->server, &client) < 0 ||
+            serve_client(srv, client))
+            break;
+    }
+    return NULL;
+}
+
+/* Get the local port a socket is bound to. */
+static int get_socket_port(int fd)
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len = sizeof(addr);
+
+    if (getsockname(fd, (struct sockaddr *)&addr, &addr_len) < 0)
+        return ff_neterrno();
+    if (addr.ss_family == AF_INET)
+        return ntohs(((struct sockaddr_in *)&addr)->sin_port);
+#if HAVE_STRUCT_SOCKADDR_IN6
+    if (addr.ss_family == AF_INET6)
+        return ntohs(((struct sockaddr_in6 *)&addr)->sin6_port);
+#endif
+    return AVERROR(EINVAL);
+}
+
+/* Get a port nothing listens on, by binding a socket to a free one and
+ * closing it again. */
+static int get_closed_port(void)
+{
+    struct sockaddr_in addr = { 0 };
+    int fd, port;
+
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((fd = ff_socket(AF_INET, SOCK_STREAM, 0)) < 0)
+        return ff_neterrno();
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        port = ff_neterrno();
+    else
+        port = get_socket_port(fd);
+    closesocket(fd);
+    return port;
+}
+
+/* Listen on a port picked by the system and write the server url. */
+static int start_server(TestServer *srv, char *url, int url_size)
+{
+    AVDictionary *options = NULL;
+    int ret;
+
+    memset(srv, 0, sizeof(*srv));
+    av_dict_set(&options, "listen", "2", 0);
+    /* the listening context has no connection to end a chunked body on */
+    av_dict_set(&options, "chunked_post", "0", 0);
+    ret = avio_open2(&srv->server, "http://127.0.0.1:0", AVIO_FLAG_READ, NULL, &options);
+    av_dict_free(&options);
+    if (ret < 0)
+        return ret;
+    if ((ret = get_socket_port(ffurl_get_file_handle(ffio_geturlcontext(srv->server)))) < 0) {
+        avio_closep(&srv->server);
+        return ret;
+    }
+    snprintf(url, url_size, "http://127.0.0.1:%d", ret);
+    if ((ret = pthread_create(&srv->thread, NULL, server_thread, srv))) {
+        avio_closep(&srv->server);
+        return AVERROR(ret);
+    }
+    return 0;
+}
+
+static void stop_server(TestServer *srv, const char *url)
+{
+    AVIOContext *pb = NULL;
+    AVDictionary *options = NULL;
+    char quit_url[256];
+
+    snprintf(quit_url, sizeof(quit_url), "%s/quit", url);
+    av_dict_set(&options, "method", "PUT", 0);
+    if (avio_open2(&pb, quit_url, AVIO_FLAG_WRITE, NULL, &options) >= 0)
+        avio_closep(&pb);
+    av_dict_free(&options);
+    pthread_join(srv->thread, NULL);
+    avio_closep(&srv->server);
+}
+
+static void free_uploads(TestServer *srv)
+{
+    int i;
+
+    for (i = 0; i < srv->nb_uploads; i++)
+        av_freep(&srv->uploads[i].body);
+}
+
+/* Mux NB_PACKETS audio packets into an hls playlist with async_io. */
+static int mux(const char *url)
+{
+    AVFormatContext *oc = NULL;
+    AVDictionary *options = NULL;
+    AVStream *st;
+    AVPacket pkt;
+    uint8_t data[PACKET_SIZE] = { 0 };
+    int i, ret;
+
+    if ((ret = avformat_alloc_output_context2(&oc, NULL, "hls", url)) < 0)
+        return ret;
+    if (!(st = avformat_new_stream(oc, NULL))) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    st->codecpar->codec_type     = AVMEDIA_TYPE_AUDIO;
+    st->codecpar->codec_id       = AV_CODEC_ID_MP2;
+    st->codecpar->sample_rate    = SAMPLE_RATE;
+    st->codecpar->channels       = 2;
+    st->codecpar->channel_layout = AV_CH_LAYOUT_STEREO;
+    st->time_base                = (AVRational){ 1, SAMPLE_RATE };
+
+    av_dict_set(&options, "hls_time", "1", 0);
+    av_dict_set(&options, "hls_list_size", "0", 0);
+    av_dict_set(&options, "async_io", "1", 0);
+    av_dict_set(&options, "async_queue_size", "2", 0);
+    ret = avformat_write_header(oc, &options);
+    av_dict_free(&options);
+    if (ret < 0)
+        goto end;
+
+    for (i = 0; i < NB_PACKETS; i++) {
+        av_init_packet(&pkt);
+        pkt.data         = data;
+        pkt.size         = sizeof(data);
+        pkt.stream_index = 0;
+        pkt.flags        = AV_PKT_FLAG_KEY;
+        pkt.pts = pkt.dts = av_rescale_q(i * PACKET_DURATION,
+                                         (AVRational){ 1, SAMPLE_RATE }, st->time_base);
+        pkt.duration     = av_rescale_q(PACKET_DURATION,
+                                        (AVRational){ 1, SAMPLE_RATE }, st->time_base);
+        if ((ret = av_write_frame(oc, &pkt)) < 0)
+            break;
+    }
+    i = av_write_trailer(oc);
+    if (ret >= 0)
+        ret = i;
+
+end:
+    avformat_free_context(oc);
+    return ret;
+}
+
+/* Return the index of the upload of resource, or -1. */
+static int find_upload(const TestServer *srv, const char *resource)
+{
+    int i;
+
+    for (i = 0; i < srv->nb_uploads; i++)
+        if (!strcmp(srv->uploads[i].resource, resource))
+            return i;
+    return -1;
+}
+
+static int check_uploads(const TestServer *srv)
+{
+    const Upload *last = &srv->uploads[FFMAX(srv->nb_uploads - 1, 0)];
+    int i, nb_segments = 0;
+
+    if (srv->nb_uploads < 2 || strcmp(last->resource, "/out.m3u8") ||
+        !last->body || !strstr(last->body, "#EXT-X-ENDLIST")) {
+        fprintf(stderr, "The final playlist was not uploaded last\n");
+        return AVERROR(EINVAL);
+    }
+
+    for (i = 0; i < srv->nb_uploads; i++) {
+        const Upload *up = &srv->uploads[i];
+        char name[64];
+        const char *p;
+
+        if (!up->body) {
+            /* segments are uploaded in sequence */
+            snprintf(name, sizeof(name), "/out%d.ts", nb_segments++);
+            if (strcmp(up->resource, name) || up->size <= 0) {
+                fprintf(stderr, "Unexpected upload %s (%"PRId64" bytes), %s "
+                        "expected\n", up->resource, up->size, name);
+                return AVERROR(EINVAL);
+            }
+            continue;
+        }
+
+        /* every segment of a playlist was uploaded before it */
+        for (p = up->body; (p = strstr(p, "out")); p += 3) {
+            int index, seg;
+
+            if (sscanf(p, "out%d.ts", &index) != 1)
+                continue;
+            snprintf(name, sizeof(name), "/out%d.ts", index);
+            seg = find_upload(srv, name);
+            if (seg < 0 || seg >= i) {
+                fprintf(stderr, "%s lists %s before it was uploaded\n",
+                        up->resource, name);
+                return AVERROR(EINVAL);
+            }
+        }
+    }
+    if (nb_segments < 3) {
+        fprintf(stderr, "Only %d segments were uploaded\n", nb_segments);
+        return AVERROR(EINVAL);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    TestServer srv;
+    char server_url[64], url[128];
+    int ret;
+
+#ifdef SIGPIPE
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    avformat_network_init();
+
+    /* upload to a local server, in order */
+    if ((ret = start_server(&srv, server_url, sizeof(server_url))) < 0) {
+        fprintf(stderr, "Failed to start the server: %s\n", av_err2str(ret));
+        return 1;
+    }
+    snprintf(url, sizeof(url), "%s/out.m3u8", server_url);
+    ret = mux(url);
+    stop_server(&srv, server_url);
+    if (ret < 0)
+        fprintf(stderr, "Muxing failed: %s\n", av_err2str(ret));
+    else
+        ret = check_uploads(&srv);
+    free_uploads(&srv);
+    printf("upload: %s\n", ret < 0 ? "fail" : "ok");
+    if (ret < 0)
+        return 1;
+
+    /* nothing listens on the port, the failed uploads must be reported */
+    if ((ret = get_closed_port()) < 0) {
+        fprintf(stderr, "Failed to find a closed port: %s\n", av_err2str(ret));
+        return 1;
+    }
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d/out.m3u8", ret);
+    ret = mux(url);
+    printf("error: %s\n", ret < 0 ? "ok" : "fail");
+    if (ret >= 0)
+        return 1;
+
+    avformat_network_deinit();
+    return 0;
+}
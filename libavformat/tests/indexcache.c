@@ -0,0 +1,237 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Test of the mpegts index cache: the index built while reading a file is
+ * written to the cache, loaded again on the next open, and rejected once
+ * the cache is damaged or the file changed.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavformat/avformat.h"
+
+#define NB_PACKETS     100
+#define FRAME_DURATION 3600
+/* the timestamps wrap around in the middle of the file */
+#define START_DTS      ((1LL << 33) - NB_PACKETS / 2 * FRAME_DURATION)
+
+/* offset of the number of index entries of the first stream in the cache:
+ * tag, version, "mpegts", size, mtime, CRC, number of streams, id, codec id */
+#define NB_ENTRIES_OFFSET (4 + 4 + 7 + 8 + 8 + 4 + 4 + 4 + 4)
+
+static int write_ts(const char *filename)
+{
+    AVFormatContext *oc = NULL;
+    AVStream *st;
+    AVPacket pkt;
+    uint8_t data[1000] = { 0 };
+    int i, ret;
+
+    if ((ret = avformat_alloc_output_context2(&oc, NULL, "mpegts", filename)) < 0)
+        return ret;
+    oc->flags |= AVFMT_FLAG_BITEXACT;
+    if (!(st = avformat_new_stream(oc, NULL))) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    st->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+    st->codecpar->codec_id   = AV_CODEC_ID_MPEG2VIDEO;
+    st->time_base            = (AVRational){ 1, 90000 };
+
+    if ((ret = avio_open(&oc->pb, filename, AVIO_FLAG_WRITE)) < 0 ||
+        (ret = avformat_write_header(oc, NULL)) < 0)
+        goto end;
+    for (i = 0; i < NB_PACKETS; i++) {
+        av_init_packet(&pkt);
+        pkt.data     = data;
+        pkt.size     = sizeof(data);
+        pkt.pts      = pkt.dts = START_DTS + i * FRAME_DURATION;
+        pkt.duration = FRAME_DURATION;
+        AV_WB32(data, i);
+        if ((ret = av_write_frame(oc, &pkt)) < 0)
+            goto end;
+    }
+    ret = av_write_trailer(oc);
+
+end:
+    avio_closep(&oc->pb);
+    avformat_free_context(oc);
+    return ret;
+}
+
+/*
+ * Open the file with the index cache. If read is set, read it through, so
+ * that the cache is written on close, and copy the index built while reading.
+ * Otherwise copy the index loaded from the cache.
+ */
+static int open_ts(const char *filename, const char *cache, int read,
+                   AVIndexEntry **entries, int *nb_entries)
+{
+    AVFormatContext *ic = NULL;
+    AVDictionary *opts = NULL;
+    AVStream *st;
+    AVPacket pkt;
+    int ret;
+
+    av_dict_set(&opts, "index_cache", cache, 0);
+    ret = avformat_open_input(&ic, filename, NULL, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+        return ret;
+    if (ic->nb_streams != 1) {
+        ret = AVERROR_INVALIDDATA;
+        goto end;
+    }
+
+    while (read && (ret = av_read_frame(ic, &pkt)) >= 0)
+        av_packet_unref(&pkt);
+    if (ret == AVERROR_EOF)
+        ret = 0;
+
+    st = ic->streams[0];
+    *nb_entries = st->nb_index_entries;
+    *entries    = av_memdup(st->index_entries,
+                            st->nb_index_entries * sizeof(*st->index_entries));
+    if (st->nb_index_entries && !*entries)
+        ret = AVERROR(ENOMEM);
+
+end:
+    avformat_close_input(&ic);
+    return ret;
+}
+
+static int check_cache(const char *filename, const char *cache,
+                       const char *desc, const AVIndexEntry *ref, int nb_ref)
+{
+    AVIndexEntry *entries = NULL;
+    int i, nb_entries, ret;
+
+    if ((ret = open_ts(filename, cache, 0, &entries, &nb_entries)) < 0)
+        return ret;
+    if (!nb_entries) {
+        printf("%s: cache rejected\n", desc);
+    } else if (nb_entries != nb_ref) {
+        printf("%s: %d entries loaded, %d expected\n", desc, nb_entries, nb_ref);
+        ret = AVERROR(EINVAL);
+    } else {
+        for (i = 0; i < nb_entries; i++)
+            if (entries[i].pos       != ref[i].pos       ||
+                entries[i].timestamp != ref[i].timestamp ||
+                entries[i].flags     != ref[i].flags)
+                break;
+        printf("%s: %d entries loaded, %s\n", desc, nb_entries,
+               i < nb_entries ? "mismatch" : "ok");
+        if (i < nb_entries)
+            ret = AVERROR(EINVAL);
+    }
+    av_free(entries);
+    return ret;
+}
+
+static int patch_file(const char *filename, long offset, const uint8_t *buf,
+                      uint8_t *old, int size)
+{
+    FILE *f = fopen(filename, "r+b");
+    int ret = 0;
+
+    if (!f)
+        return AVERROR(errno);
+    if (fseek(f, offset, SEEK_SET) ||
+        (old && fread(old, 1, size, f) != size) ||
+        fseek(f, offset, SEEK_SET) ||
+        fwrite(buf, 1, size, f) != size)
+        ret = AVERROR(EIO);
+    fclose(f);
+    return ret;
+}
+
+static int run(const char *filename, const char *cache)
+{
+    static const uint8_t nb_entries_bad[4] = { 0x7f, 0xff, 0xff, 0xff };
+    static const uint8_t tag_none[4] = { 0 };
+    static const uint8_t null_ts_packet[188] = { 0x47, 0x1f, 0xff, 0x10 };
+    AVIndexEntry *ref = NULL;
+    uint8_t saved[4];
+    int i, nb_ref, ret;
+
+    if ((ret = write_ts(filename)) < 0 ||
+        (ret = open_ts(filename, cache, 1, &ref, &nb_ref)) < 0)
+        goto end;
+
+    for (i = 1; i < nb_ref; i++)
+        if (ref[i].timestamp <= ref[i - 1].timestamp)
+            break;
+    printf("index: %d entries, timestamps %"PRId64" to %"PRId64", %s\n",
+           nb_ref, nb_ref ? ref[0].timestamp : 0,
+           nb_ref ? ref[nb_ref - 1].timestamp : 0,
+           i < nb_ref ? "not increasing" : "increasing");
+
+    if ((ret = check_cache(filename, cache, "cached", ref, nb_ref)) < 0)
+        goto end;
+
+    if ((ret = patch_file(cache, NB_ENTRIES_OFFSET, nb_entries_bad, saved, 4)) < 0 ||
+        (ret = check_cache(filename, cache, "bad entry count", ref, nb_ref)) < 0 ||
+        (ret = patch_file(cache, NB_ENTRIES_OFFSET, saved, NULL, 4)) < 0)
+        goto end;
+
+    if ((ret = patch_file(cache, 0, tag_none, saved, 4)) < 0 ||
+        (ret = check_cache(filename, cache, "incomplete", ref, nb_ref)) < 0 ||
+        (ret = patch_file(cache, 0, saved, NULL, 4)) < 0)
+        goto end;
+
+    if ((ret = check_cache(filename, cache, "restored", ref, nb_ref)) < 0)
+        goto end;
+
+    {
+        FILE *f = fopen(filename, "ab");
+        if (!f || fwrite(null_ts_packet, 1, sizeof(null_ts_packet), f) != sizeof(null_ts_packet))
+            ret = AVERROR(EIO);
+        if (f)
+            fclose(f);
+        if (ret < 0)
+            goto end;
+    }
+    ret = check_cache(filename, cache, "input changed", ref, nb_ref);
+
+end:
+    av_free(ref);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    char cache[1024];
+    int ret;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <temporary file>\n", argv[0]);
+        return 1;
+    }
+    snprintf(cache, sizeof(cache), "%s.index", argv[1]);
+    remove(cache);
+
+    if ((ret = run(argv[1], cache)) < 0)
+        fprintf(stderr, "%s\n", av_err2str(ret));
+    remove(argv[1]);
+    remove(cache);
+    return ret < 0;
+}
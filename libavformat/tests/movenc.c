@@ -72,11 +72,17 @@ int clear_duration;
 int force_iobuf_size;
 int do_interleave;
 int fake_pkt_duration;
+int stream_duration;
 
 int num_warnings;
 
 int check_faults;
 
+// Seekable output kept in memory, for the modes that rewrite the header
+int seekable;
+uint8_t *mem_buf;
+int64_t mem_size, mem_pos;
+
 
 static void count_warnings(void *avcl, int level, const char *fmt, va_list vl)
 {
@@ -95,8 +101,77 @@ static void reset_count_warnings(void)
     av_log_set_callback(av_log_default_callback);
 }
 
+static int mem_write(void *opaque, uint8_t *buf, int size)
+{
+    int64_t *pos = opaque;
+    if (*pos + size > mem_size) {
+        uint8_t *tmp = av_realloc(mem_buf, *pos + size);
+        if (!tmp)
+            return AVERROR(ENOMEM);
+        mem_buf = tmp;
+        if (*pos > mem_size)
+            memset(mem_buf + mem_size, 0, *pos - mem_size);
+        mem_size = *pos + size;
+    }
+    memcpy(mem_buf + *pos, buf, size);
+    *pos += size;
+    return size;
+}
+
+static int mem_read(void *opaque, uint8_t *buf, int size)
+{
+    int64_t *pos = opaque;
+    size = FFMIN(size, mem_size - *pos);
+    if (size <= 0)
+        return AVERROR_EOF;
+    memcpy(buf, mem_buf + *pos, size);
+    *pos += size;
+    return size;
+}
+
+static int64_t mem_seek(void *opaque, int64_t offset, int whence)
+{
+    int64_t *pos = opaque;
+    switch (whence) {
+    case SEEK_SET: *pos  = offset;            break;
+    case SEEK_CUR: *pos += offset;            break;
+    case SEEK_END: *pos  = mem_size + offset; break;
+    case AVSEEK_SIZE: return mem_size;
+    default: return AVERROR(EINVAL);
+    }
+    return *pos;
+}
+
+// Reopen the memory output for reading, as done by the faststart second pass
+static int io_open(AVFormatContext *s, AVIOContext **pb, const char *url,
+                   int flags, AVDictionary **options)
+{
+    int64_t *pos;
+    uint8_t *buf;
+    if (flags & AVIO_FLAG_WRITE)
+        return AVERROR(EINVAL);
+    pos = av_mallocz(sizeof(*pos));
+    buf = av_malloc(sizeof(iobuf));
+    if (!pos || !buf || !(*pb = avio_alloc_context(buf, sizeof(iobuf), 0, pos,
+                                                   mem_read, NULL, mem_seek))) {
+        av_free(pos);
+        av_free(buf);
+        return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
+static void io_close(AVFormatContext *s, AVIOContext *pb)
+{
+    av_freep(&pb->opaque);
+    av_freep(&pb->buffer);
+    avio_context_free(&pb);
+}
+
 static int io_write(void *opaque, uint8_t *buf, int size)
 {
+    if (seekable)
+        return mem_write(opaque, buf, size);
     out_size += size;
     av_md5_update(md5, buf, size);
     if (out)
@@ -147,11 +222,21 @@ static void init_out(const char *name)
             perror(buf);
     }
     out_size = 0;
+    av_freep(&mem_buf);
+    mem_size = mem_pos = 0;
 }
 
 static void close_out(void)
 {
     int i;
+    if (seekable) {
+        // The data written so far may still be rewritten, only hash the
+        // final content
+        out_size = mem_size;
+        av_md5_update(md5, mem_buf, mem_size);
+        if (out)
+            fwrite(mem_buf, 1, mem_size, out);
+    }
     av_md5_final(md5, hash);
     for (i = 0; i < HASH_SIZE; i++)
         printf("%02x", hash[i]);
@@ -185,10 +270,17 @@ static void init_fps(int bf, int audio_preroll, int fps)
     ctx->oformat = av_guess_format(format, NULL, NULL);
     if (!ctx->oformat)
         exit(1);
-    ctx->pb = avio_alloc_context(iobuf, iobuf_size, AVIO_FLAG_WRITE, NULL, NULL, io_write, NULL);
+    if (seekable) {
+        ctx->pb = avio_alloc_context(iobuf, iobuf_size, AVIO_FLAG_WRITE, &mem_pos, NULL, io_write, mem_seek);
+        ctx->io_open  = io_open;
+        ctx->io_close = io_close;
+    } else {
+        ctx->pb = avio_alloc_context(iobuf, iobuf_size, AVIO_FLAG_WRITE, NULL, NULL, io_write, NULL);
+    }
     if (!ctx->pb)
         exit(1);
-    ctx->pb->write_data_type = io_write_data_type;
+    if (!seekable)
+        ctx->pb->write_data_type = io_write_data_type;
     ctx->flags |= AVFMT_FLAG_BITEXACT;
 
     st = avformat_new_stream(ctx, NULL);
@@ -205,6 +297,10 @@ static void init_fps(int bf, int audio_preroll, int fps)
     if (!st->codecpar->extradata)
         exit(1);
     memcpy(st->codecpar->extradata, h264_extradata, sizeof(h264_extradata));
+    if (stream_duration) {
+        st->duration = stream_duration * st->time_base.den;
+        st->avg_frame_rate = (AVRational){ fps, 1 };
+    }
     video_st = st;
 
     st = avformat_new_stream(ctx, NULL);
@@ -221,6 +317,8 @@ static void init_fps(int bf, int audio_preroll, int fps)
     if (!st->codecpar->extradata)
         exit(1);
     memcpy(st->codecpar->extradata, aac_extradata, sizeof(aac_extradata));
+    if (stream_duration)
+        st->duration = stream_duration * st->time_base.den;
     audio_st = st;
 
     if (avformat_write_header(ctx, &opts) < 0)
@@ -350,6 +448,22 @@ static void finish(void)
     ctx = NULL;
 }
 
+// Return the offset of the first top level atom of the given type in the
+// memory output, or -1 if there is none
+static int64_t find_atom(const char *type)
+{
+    int64_t pos = 0, size;
+    while (pos + 8 <= mem_size) {
+        size = AV_RB32(mem_buf + pos);
+        if (!memcmp(mem_buf + pos + 4, type, 4))
+            return pos;
+        if (size < 8)
+            break;
+        pos += size;
+    }
+    return -1;
+}
+
 static void help(void)
 {
     printf("movenc-test [-w]\n"
@@ -785,6 +899,50 @@ int main(int argc, char **argv)
     finish();
     close_out();
 
+    // Reserve space for the moov atom from the estimate derived from the
+    // stream durations; the moov atom is written into it, before the mdat,
+    // without any second pass.
+    seekable = 1;
+    stream_duration = 2;
+    init_out("reserve-moov");
+    av_dict_set(&opts, "movflags", "reserve_moov", 0);
+    init(0, 0);
+    mux_gops(2);
+    finish();
+    close_out();
+    check(find_atom("moov") >= 0 && find_atom("moov") < find_atom("free") &&
+          find_atom("free") < find_atom("mdat"),
+          "moov not written into the reserved space");
+    stream_duration = 0;
+
+    // Reserve too little space; without faststart, the moov atom ends up
+    // at the end of the file, after the unused reserved space.
+    init_out("reserve-moov-too-small");
+    av_dict_set(&opts, "movflags", "reserve_moov", 0);
+    av_dict_set(&opts, "moov_size", "100", 0);
+    init(0, 0);
+    mux_gops(2);
+    finish();
+    close_out();
+    check(find_atom("free") >= 0 && find_atom("free") < find_atom("mdat") &&
+          find_atom("mdat") < find_atom("moov"),
+          "moov not written at the end of the file");
+
+    // Same, but with faststart, falling back to its second pass, which
+    // moves the moov atom in front of the reserved space and the mdat.
+    init_out("reserve-moov-faststart");
+    av_dict_set(&opts, "movflags", "reserve_moov+faststart", 0);
+    av_dict_set(&opts, "moov_size", "100", 0);
+    init(0, 0);
+    mux_gops(2);
+    finish();
+    close_out();
+    check(find_atom("moov") >= 0 && find_atom("moov") < find_atom("free") &&
+          find_atom("free") < find_atom("mdat"),
+          "moov not moved to the beginning of the file");
+    seekable = 0;
+    av_freep(&mem_buf);
+
     av_free(md5);
 
     return check_faults > 0 ? 1 : 0;
@@ -26,12 +26,12 @@
 
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#define _GNU_SOURCE     /* Needed for recvmmsg() and sendmmsg() with glibc */
 
 #include "avformat.h"
 #include "avio_internal.h"
 #include "libavutil/avassert.h"
 #include "libavutil/parseutils.h"
-#include "libavutil/fifo.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/avstring.h"
 #include "libavutil/opt.h"
@@ -63,6 +63,14 @@
 
 #if HAVE_PTHREAD_CANCEL
 #include <pthread.h>
+#include <stdatomic.h>
+#endif
+
+/* recvmmsg() and sendmmsg() come together with this flag on Linux and BSDs */
+#ifdef MSG_WAITFORONE
+#define UDP_HAVE_MMSG 1
+#else
+#define UDP_HAVE_MMSG 0
 #endif
 
 #ifndef IPV6_ADD_MEMBERSHIP
@@ -73,6 +81,34 @@
 #define UDP_TX_BUF_SIZE 32768
 #define UDP_MAX_PKT_SIZE 65536
 #define UDP_HEADER_SIZE 8
+#define UDP_MAX_BATCH_SIZE 256
+
+#if HAVE_PTHREAD_CANCEL
+/**
+ * Circular buffer of datagrams, each prefixed by its length in 4 bytes,
+ * shared by exactly one writing and one reading thread without locking.
+ * head and tail count the bytes written and read since the start, modulo
+ * SIZE_MAX + 1; size is a power of two so that they stay consistent with
+ * the position in buf when they wrap around.
+ */
+typedef struct UDPRing {
+    uint8_t *buf;
+    size_t size;
+    atomic_size_t head;
+    atomic_size_t tail;
+} UDPRing;
+
+/* Datagrams received or sent by a single recvmmsg() or sendmmsg() call */
+typedef struct UDPBatch {
+#if UDP_HAVE_MMSG
+    struct mmsghdr msgs[UDP_MAX_BATCH_SIZE];
+    struct iovec iov[UDP_MAX_BATCH_SIZE][2];
+#endif
+    struct sockaddr_storage addrs[UDP_MAX_BATCH_SIZE];
+    int lens[UDP_MAX_BATCH_SIZE];
+    uint8_t *bufs;
+} UDPBatch;
+#endif
 
 typedef struct UDPContext {
     const AVClass *class;
@@ -92,18 +128,24 @@ typedef struct UDPContext {
 
     /* Circular Buffer variables for use in UDP receive code */
     int circular_buffer_size;
-    AVFifoBuffer *fifo;
     int circular_buffer_error;
     int64_t bitrate; /* number of bits to send per second */
     int64_t burst_bits;
     int close_req;
+    int batch_size;
+    int64_t overruns;
+    int64_t dropped_packets;
 #if HAVE_PTHREAD_CANCEL
+    /* counted by the receiving thread, added to the above by udp_read() */
+    atomic_uint new_overruns;
+    atomic_uint new_dropped_packets;
+    UDPRing ring;
+    UDPBatch *batch;
     pthread_t circular_buffer_thread;
     pthread_mutex_t mutex;
     pthread_cond_t cond;
     int thread_started;
 #endif
-    uint8_t tmp[UDP_MAX_PKT_SIZE+4];
     int remaining_in_dg;
     char *localaddr;
     int timeout;
@@ -132,6 +174,9 @@ static const AVOption options[] = {
     { "connect",        "set if connect() should be called on socket",     OFFSET(is_connected),   AV_OPT_TYPE_BOOL,   { .i64 =  0 },     0, 1,       .flags = D|E },
     { "fifo_size",      "set the UDP receiving circular buffer size, expressed as a number of packets with size of 188 bytes", OFFSET(circular_buffer_size), AV_OPT_TYPE_INT, {.i64 = 7*4096}, 0, INT_MAX, D },
     { "overrun_nonfatal", "survive in case of UDP receiving circular buffer overrun", OFFSET(overrun_nonfatal), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1,    D },
+    { "batch_size",     "maximum number of datagrams moved between the circular buffer and the socket by one system call", OFFSET(batch_size), AV_OPT_TYPE_INT, { .i64 = 16 }, 1, UDP_MAX_BATCH_SIZE, D|E },
+    { "overruns",       "number of times the receiving circular buffer ran full", OFFSET(overruns), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, D|AV_OPT_FLAG_EXPORT|AV_OPT_FLAG_READONLY },
+    { "dropped_packets", "number of datagrams dropped by receiving circular buffer overruns", OFFSET(dropped_packets), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, D|AV_OPT_FLAG_EXPORT|AV_OPT_FLAG_READONLY },
     { "timeout",        "set raise error timeout (only in read mode)",     OFFSET(timeout),        AV_OPT_TYPE_INT,    { .i64 = 0 },      0, INT_MAX, D },
     { "sources",        "Source list",                                     OFFSET(sources),        AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
     { "block",          "Block list",                                      OFFSET(block),          AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
@@ -454,11 +499,116 @@ static int udp_get_file_handle(URLContext *h)
 }
 
 #if HAVE_PTHREAD_CANCEL
+static void ring_write(UDPRing *r, size_t pos, const uint8_t *data, size_t len)
+{
+    size_t idx   = pos & (r->size - 1);
+    size_t first = FFMIN(len, r->size - idx);
+
+    memcpy(r->buf + idx, data, first);
+    memcpy(r->buf, data + first, len - first);
+}
+
+static void ring_read(UDPRing *r, size_t pos, uint8_t *data, size_t len)
+{
+    size_t idx   = pos & (r->size - 1);
+    size_t first = FFMIN(len, r->size - idx);
+
+    memcpy(data, r->buf + idx, first);
+    memcpy(data + first, r->buf, len - first);
+}
+
+/* Called by the writing thread only. */
+static size_t ring_space(UDPRing *r)
+{
+    return r->size - (atomic_load_explicit(&r->head, memory_order_relaxed) -
+                      atomic_load_explicit(&r->tail, memory_order_acquire));
+}
+
+/* Called by the reading thread only. */
+static size_t ring_avail(UDPRing *r)
+{
+    return atomic_load_explicit(&r->head, memory_order_acquire) -
+           atomic_load_explicit(&r->tail, memory_order_relaxed);
+}
+
+/* Append a datagram, the caller checked that it fits. */
+static void ring_put(UDPRing *r, const uint8_t *data, int len)
+{
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint8_t tmp[4];
+
+    AV_WL32(tmp, len);
+    ring_write(r, head,     tmp,  4);
+    ring_write(r, head + 4, data, len);
+    atomic_store_explicit(&r->head, head + 4 + len, memory_order_release);
+}
+
+/* Return the size of the datagram at pos, which must have been written. */
+static int ring_peek_len(UDPRing *r, size_t pos)
+{
+    uint8_t tmp[4];
+
+    ring_read(r, pos, tmp, 4);
+    return AV_RL32(tmp);
+}
+
+/* Export the statistics of the receiving thread to the AVOptions. */
+static void udp_update_stats(UDPContext *s)
+{
+    s->dropped_packets += atomic_exchange_explicit(&s->new_dropped_packets, 0,
+                                                   memory_order_relaxed);
+    s->overruns        += atomic_exchange_explicit(&s->new_overruns, 0,
+                                                   memory_order_relaxed);
+}
+
+/* Wake up the other thread once the ring changed. */
+static void ring_signal(UDPContext *s)
+{
+    pthread_mutex_lock(&s->mutex);
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->mutex);
+}
+
+/**
+ * Receive at least one and at most batch_size datagrams into s->batch.
+ * @return the number of datagrams or a negative error code
+ */
+static int udp_recv_batch(UDPContext *s)
+{
+    UDPBatch *b = s->batch;
+    socklen_t addr_len = sizeof(b->addrs[0]);
+    int len;
+
+#if UDP_HAVE_MMSG
+    if (s->batch_size > 1) {
+        int i, n;
+
+        for (i = 0; i < s->batch_size; i++)
+            b->msgs[i].msg_hdr.msg_namelen = sizeof(b->addrs[i]);
+        n = recvmmsg(s->udp_fd, b->msgs, s->batch_size, MSG_WAITFORONE, NULL);
+        if (n < 0)
+            return ff_neterrno();
+        for (i = 0; i < n; i++)
+            b->lens[i] = b->msgs[i].msg_len;
+        return n;
+    }
+#endif
+
+    len = recvfrom(s->udp_fd, b->bufs, UDP_MAX_PKT_SIZE, 0,
+                   (struct sockaddr *)&b->addrs[0], &addr_len);
+    if (len < 0)
+        return ff_neterrno();
+    b->lens[0] = len;
+    return 1;
+}
+
 static void *circular_buffer_task_rx( void *_URLContext)
 {
     URLContext *h = _URLContext;
     UDPContext *s = h->priv_data;
+    UDPBatch *b = s->batch;
     int old_cancelstate;
+    int in_overrun = 0;
 
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
     pthread_mutex_lock(&s->mutex);
@@ -467,46 +617,58 @@ static void *circular_buffer_task_rx( void *_URLContext)
         s->circular_buffer_error = AVERROR(EIO);
         goto end;
     }
+    pthread_mutex_unlock(&s->mutex);
+
     while(1) {
-        int len;
-        struct sockaddr_storage addr;
-        socklen_t addr_len = sizeof(addr);
+        int i, n, queued = 0;
 
-        pthread_mutex_unlock(&s->mutex);
         /* Blocking operations are always cancellation points;
            see "General Information" / "Thread Cancelation Overview"
            in Single Unix. */
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
-        len = recvfrom(s->udp_fd, s->tmp+4, sizeof(s->tmp)-4, 0, (struct sockaddr *)&addr, &addr_len);
+        n = udp_recv_batch(s);
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
-        pthread_mutex_lock(&s->mutex);
-        if (len < 0) {
-            if (ff_neterrno() != AVERROR(EAGAIN) && ff_neterrno() != AVERROR(EINTR)) {
-                s->circular_buffer_error = ff_neterrno();
+        if (n < 0) {
+            if (n != AVERROR(EAGAIN) && n != AVERROR(EINTR)) {
+                pthread_mutex_lock(&s->mutex);
+                s->circular_buffer_error = n;
                 goto end;
             }
             continue;
         }
-        if (ff_ip_check_source_lists(&addr, &s->filters))
-            continue;
-        AV_WL32(s->tmp, len);
 
-        if(av_fifo_space(s->fifo) < len + 4) {
-            /* No Space left */
-            if (s->overrun_nonfatal) {
-                av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
-                        "Surviving due to overrun_nonfatal option\n");
+        for (i = 0; i < n; i++) {
+            int len = b->lens[i];
+
+            if (ff_ip_check_source_lists(&b->addrs[i], &s->filters))
                 continue;
-            } else {
-                av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
-                        "To avoid, increase fifo_size URL option. "
-                        "To survive in such case, use overrun_nonfatal option\n");
-                s->circular_buffer_error = AVERROR(EIO);
-                goto end;
+
+            if (ring_space(&s->ring) < len + 4) {
+                /* No Space left */
+                atomic_fetch_add_explicit(&s->new_dropped_packets, 1, memory_order_relaxed);
+                if (!in_overrun)
+                    atomic_fetch_add_explicit(&s->new_overruns, 1, memory_order_relaxed);
+                if (s->overrun_nonfatal) {
+                    if (!in_overrun)
+                        av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
+                               "Surviving due to overrun_nonfatal option\n");
+                    in_overrun = 1;
+                    continue;
+                } else {
+                    av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
+                            "To avoid, increase fifo_size URL option. "
+                            "To survive in such case, use overrun_nonfatal option\n");
+                    pthread_mutex_lock(&s->mutex);
+                    s->circular_buffer_error = AVERROR(EIO);
+                    goto end;
+                }
             }
+            in_overrun = 0;
+            ring_put(&s->ring, b->bufs + (size_t)i * UDP_MAX_PKT_SIZE, len);
+            queued++;
         }
-        av_fifo_generic_write(s->fifo, s->tmp, len+4, NULL);
-        pthread_cond_signal(&s->cond);
+        if (queued)
+            ring_signal(s);
     }
 
 end:
@@ -515,6 +677,79 @@ end:
     return NULL;
 }
 
+/**
+ * Send the first n datagrams queued in the ring, straight from the ring.
+ * @return 0 or a negative error code
+ */
+static int udp_send_batch(UDPContext *s, int n, const int *lens)
+{
+    size_t pos = atomic_load_explicit(&s->ring.tail, memory_order_relaxed);
+    int i, ret;
+
+#if UDP_HAVE_MMSG
+    if (n > 1) {
+        UDPBatch *b = s->batch;
+        int sent = 0;
+
+        for (i = 0; i < n; i++) {
+            struct msghdr *m = &b->msgs[i].msg_hdr;
+            size_t idx   = (pos + 4) % s->ring.size;
+            size_t first = FFMIN(lens[i], s->ring.size - idx);
+
+            b->iov[i][0].iov_base = s->ring.buf + idx;
+            b->iov[i][0].iov_len  = first;
+            b->iov[i][1].iov_base = s->ring.buf;
+            b->iov[i][1].iov_len  = lens[i] - first;
+            memset(m, 0, sizeof(*m));
+            m->msg_iov    = b->iov[i];
+            m->msg_iovlen = first < lens[i] ? 2 : 1;
+            if (!s->is_connected) {
+                m->msg_name    = &s->dest_addr;
+                m->msg_namelen = s->dest_addr_len;
+            }
+            pos += 4 + lens[i];
+        }
+        while (sent < n) {
+            ret = sendmmsg(s->udp_fd, b->msgs + sent, n - sent, 0);
+            if (ret >= 0) {
+                sent += ret;
+            } else {
+                ret = ff_neterrno();
+                if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR))
+                    return ret;
+            }
+        }
+        return 0;
+    }
+#endif
+
+    for (i = 0; i < n; i++) {
+        const uint8_t *p = s->batch->bufs;
+        int len = lens[i];
+
+        ring_read(&s->ring, pos + 4, s->batch->bufs, len);
+        pos += 4 + len;
+        while (len) {
+            av_assert0(len > 0);
+            if (!s->is_connected) {
+                ret = sendto (s->udp_fd, p, len, 0,
+                            (struct sockaddr *) &s->dest_addr,
+                            s->dest_addr_len);
+            } else
+                ret = send(s->udp_fd, p, len, 0);
+            if (ret >= 0) {
+                len -= ret;
+                p   += ret;
+            } else {
+                ret = ff_neterrno();
+                if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR))
+                    return ret;
+            }
+        }
+    }
+    return 0;
+}
+
 static void *circular_buffer_task_tx( void *_URLContext)
 {
     URLContext *h = _URLContext;
@@ -536,31 +771,38 @@ static void *circular_buffer_task_tx( void *_URLContext)
     }
 
     for(;;) {
-        int len;
-        const uint8_t *p;
-        uint8_t tmp[4];
+        int lens[UDP_MAX_BATCH_SIZE];
+        int n = 0, ret;
+        int64_t batch_bits = 0;
+        size_t avail = ring_avail(&s->ring);
+        size_t pos = atomic_load_explicit(&s->ring.tail, memory_order_relaxed);
         int64_t timestamp;
 
-        len=av_fifo_size(s->fifo);
-
-        while (len<4) {
+        while (!avail) {
             if (s->close_req)
                 goto end;
             if (pthread_cond_wait(&s->cond, &s->mutex) < 0) {
                 goto end;
             }
-            len=av_fifo_size(s->fifo);
+            avail = ring_avail(&s->ring);
         }
+        pthread_mutex_unlock(&s->mutex);
 
-        av_fifo_generic_read(s->fifo, tmp, 4, NULL);
-        len=AV_RL32(tmp);
+        /* Take the queued datagrams, without exceeding the allowed burst. */
+        while (avail && n < s->batch_size) {
+            int len = ring_peek_len(&s->ring, pos);
 
-        av_assert0(len >= 0);
-        av_assert0(len <= sizeof(s->tmp));
+            av_assert0(len >= 0);
+            av_assert0(len <= UDP_MAX_PKT_SIZE);
 
-        av_fifo_generic_read(s->fifo, s->tmp, len, NULL);
+            if (n && s->bitrate && batch_bits + len * 8 > s->burst_bits)
+                break;
+            lens[n++]   = len;
+            batch_bits += len * 8;
+            avail      -= 4 + len;
+            pos        += 4 + len;
+        }
 
-        pthread_mutex_unlock(&s->mutex);
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
 
         if (s->bitrate) {
@@ -579,33 +821,18 @@ static void *circular_buffer_task_tx( void *_URLContext)
                     sent_bits = 0;
                 }
             }
-            sent_bits += len * 8;
+            sent_bits += batch_bits;
             target_timestamp = start_timestamp + sent_bits * 1000000 / s->bitrate;
         }
 
-        p = s->tmp;
-        while (len) {
-            int ret;
-            av_assert0(len > 0);
-            if (!s->is_connected) {
-                ret = sendto (s->udp_fd, p, len, 0,
-                            (struct sockaddr *) &s->dest_addr,
-                            s->dest_addr_len);
-            } else
-                ret = send(s->udp_fd, p, len, 0);
-            if (ret >= 0) {
-                len -= ret;
-                p   += ret;
-            } else {
-                ret = ff_neterrno();
-                if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR)) {
-                    pthread_mutex_lock(&s->mutex);
-                    s->circular_buffer_error = ret;
-                    pthread_mutex_unlock(&s->mutex);
-                    return NULL;
-                }
-            }
+        ret = udp_send_batch(s, n, lens);
+        if (ret < 0) {
+            pthread_mutex_lock(&s->mutex);
+            s->circular_buffer_error = ret;
+            pthread_mutex_unlock(&s->mutex);
+            return NULL;
         }
+        atomic_store_explicit(&s->ring.tail, pos, memory_order_release);
 
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
         pthread_mutex_lock(&s->mutex);
@@ -616,6 +843,53 @@ end:
     return NULL;
 }
 
+static int udp_alloc_buffers(URLContext *h, int is_output)
+{
+    UDPContext *s = h->priv_data;
+    UDPBatch *b;
+
+    s->ring.size = 1;
+    while (s->ring.size < s->circular_buffer_size)
+        s->ring.size <<= 1;
+    s->ring.buf  = av_malloc(s->ring.size);
+    s->batch = b = av_mallocz(sizeof(*s->batch));
+    if (!s->ring.buf || !b)
+        return AVERROR(ENOMEM);
+    atomic_init(&s->ring.head, 0);
+    atomic_init(&s->ring.tail, 0);
+    atomic_init(&s->new_overruns, 0);
+    atomic_init(&s->new_dropped_packets, 0);
+
+    /* received datagrams are staged, sent ones are read from the ring */
+    b->bufs = av_malloc(is_output ? UDP_MAX_PKT_SIZE :
+                        (size_t)s->batch_size * UDP_MAX_PKT_SIZE);
+    if (!b->bufs)
+        return AVERROR(ENOMEM);
+
+#if UDP_HAVE_MMSG
+    if (!is_output) {
+        int i;
+        for (i = 0; i < s->batch_size; i++) {
+            struct msghdr *m = &b->msgs[i].msg_hdr;
+
+            b->iov[i][0].iov_base = b->bufs + (size_t)i * UDP_MAX_PKT_SIZE;
+            b->iov[i][0].iov_len  = UDP_MAX_PKT_SIZE;
+            m->msg_iov    = b->iov[i];
+            m->msg_iovlen = 1;
+            m->msg_name   = &b->addrs[i];
+        }
+    }
+#endif
+    return 0;
+}
+
+static void udp_free_buffers(UDPContext *s)
+{
+    if (s->batch)
+        av_freep(&s->batch->bufs);
+    av_freep(&s->batch);
+    av_freep(&s->ring.buf);
+}
 
 #endif
 
@@ -709,6 +983,9 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         if (av_find_info_tag(buf, sizeof(buf), "burst_bits", p)) {
             s->burst_bits = strtoll(buf, NULL, 10);
         }
+        if (av_find_info_tag(buf, sizeof(buf), "batch_size", p)) {
+            s->batch_size = av_clip(strtol(buf, NULL, 10), 1, UDP_MAX_BATCH_SIZE);
+        }
         if (av_find_info_tag(buf, sizeof(buf), "localaddr", p)) {
             av_strlcpy(localaddr, buf, sizeof(localaddr));
         }
@@ -892,7 +1169,8 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         int ret;
 
         /* start the task going */
-        s->fifo = av_fifo_alloc(s->circular_buffer_size);
+        if (udp_alloc_buffers(h, is_output) < 0)
+            goto fail;
         ret = pthread_mutex_init(&s->mutex, NULL);
         if (ret != 0) {
             av_log(h, AV_LOG_ERROR, "pthread_mutex_init failed : %s\n", strerror(ret));
@@ -922,7 +1200,9 @@ static int udp_open(URLContext *h, const char *uri, int flags)
  fail:
     if (udp_fd >= 0)
         closesocket(udp_fd);
-    av_fifo_freep(&s->fifo);
+#if HAVE_PTHREAD_CANCEL
+    udp_free_buffers(s);
+#endif
     ff_ip_reset_filters(&s->filters);
     return AVERROR(EIO);
 }
@@ -946,24 +1226,32 @@ static int udp_read(URLContext *h, uint8_t *buf, int size)
 #if HAVE_PTHREAD_CANCEL
     int avail, nonblock = h->flags & AVIO_FLAG_NONBLOCK;
 
-    if (s->fifo) {
+    if (s->ring.buf) {
+        size_t pos = atomic_load_explicit(&s->ring.tail, memory_order_relaxed);
+
+        udp_update_stats(s);
+
+        /* datagrams are taken without locking, the lock is only needed
+         * to wait for more of them */
+        if (ring_avail(&s->ring)) {
+            int len = ring_peek_len(&s->ring, pos);
+
+            avail = len;
+            if(avail > size){
+                av_log(h, AV_LOG_WARNING, "Part of datagram lost due to insufficient buffer size\n");
+                avail= size;
+            }
+
+            ring_read(&s->ring, pos + 4, buf, avail);
+            atomic_store_explicit(&s->ring.tail, pos + 4 + len, memory_order_release);
+            return avail;
+        }
+
         pthread_mutex_lock(&s->mutex);
         do {
-            avail = av_fifo_size(s->fifo);
-            if (avail) { // >=size) {
-                uint8_t tmp[4];
-
-                av_fifo_generic_read(s->fifo, tmp, 4, NULL);
-                avail= AV_RL32(tmp);
-                if(avail > size){
-                    av_log(h, AV_LOG_WARNING, "Part of datagram lost due to insufficient buffer size\n");
-                    avail= size;
-                }
-
-                av_fifo_generic_read(s->fifo, buf, avail, NULL);
-                av_fifo_drain(s->fifo, AV_RL32(tmp) - avail);
+            if (ring_avail(&s->ring)) {
                 pthread_mutex_unlock(&s->mutex);
-                return avail;
+                return udp_read(h, buf, size);
             } else if(s->circular_buffer_error){
                 int err = s->circular_buffer_error;
                 pthread_mutex_unlock(&s->mutex);
@@ -1007,31 +1295,27 @@ static int udp_write(URLContext *h, const uint8_t *buf, int size)
     int ret;
 
 #if HAVE_PTHREAD_CANCEL
-    if (s->fifo) {
-        uint8_t tmp[4];
-
-        pthread_mutex_lock(&s->mutex);
+    if (s->ring.buf) {
+        int err;
 
         /*
           Return error if last tx failed.
           Here we can't know on which packet error was, but it needs to know that error exists.
         */
-        if (s->circular_buffer_error<0) {
-            int err=s->circular_buffer_error;
-            pthread_mutex_unlock(&s->mutex);
+        pthread_mutex_lock(&s->mutex);
+        err = s->circular_buffer_error;
+        pthread_mutex_unlock(&s->mutex);
+        if (err < 0)
             return err;
-        }
 
-        if(av_fifo_space(s->fifo) < size + 4) {
+        if (size > UDP_MAX_PKT_SIZE)
+            return AVERROR(EINVAL);
+        if (ring_space(&s->ring) < size + 4) {
             /* What about a partial packet tx ? */
-            pthread_mutex_unlock(&s->mutex);
             return AVERROR(ENOMEM);
         }
-        AV_WL32(tmp, size);
-        av_fifo_generic_write(s->fifo, tmp, 4, NULL); /* size of packet */
-        av_fifo_generic_write(s->fifo, (uint8_t *)buf, size, NULL); /* the data */
-        pthread_cond_signal(&s->cond);
-        pthread_mutex_unlock(&s->mutex);
+        ring_put(&s->ring, buf, size);
+        ring_signal(s);
         return size;
     }
 #endif
@@ -1079,9 +1363,14 @@ static int udp_close(URLContext *h)
         pthread_mutex_destroy(&s->mutex);
         pthread_cond_destroy(&s->cond);
     }
+    if (s->ring.buf)
+        udp_update_stats(s);
+    if (s->dropped_packets)
+        av_log(h, AV_LOG_WARNING, "%"PRId64" datagrams dropped in %"PRId64" circular buffer overruns\n",
+               s->dropped_packets, s->overruns);
+    udp_free_buffers(s);
 #endif
     closesocket(s->udp_fd);
-    av_fifo_freep(&s->fifo);
     ff_ip_reset_filters(&s->filters);
     return 0;
 }
@@ -27,6 +27,7 @@
 #include "avio.h"
 #include "libavformat/version.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -86,6 +87,7 @@ typedef struct URLProtocol {
     int (*url_get_multi_file_handle)(URLContext *h, int **handles,
                                      int *numhandles);
     int (*url_get_short_seek)(URLContext *h);
+    int (*url_get_buffer)(URLContext *h, int64_t pos, int size, AVBufferRef **buf);
     int (*url_shutdown)(URLContext *h, int flags);
     int priv_data_size;
     const AVClass *priv_data_class;
@@ -257,6 +259,18 @@ int ffurl_get_multi_file_handle(URLContext *h, int **handles, int *numhandles);
  */
 int ffurl_get_short_seek(URLContext *h);
 
+/**
+ * Get a reference to size bytes of the resource starting at pos, without
+ * copying them, e.g. from a memory mapping. The data must be followed by
+ * AV_INPUT_BUFFER_PADDING_SIZE zero bytes, so that it can be used as packet
+ * data. The protocol may refuse sizes for which a copy is cheaper.
+ * The read position of the URLContext is not changed.
+ *
+ * @return 0 on success, AVERROR(ENOSYS) if the protocol or the current state
+ *         does not allow it, or another negative error code.
+ */
+int ffurl_get_buffer(URLContext *h, int64_t pos, int size, AVBufferRef **buf);
+
 /**
  * Signal the URLContext that we are done reading or writing the stream.
  *
@@ -317,6 +317,23 @@ int av_get_packet(AVIOContext *s, AVPacket *pkt, int size)
     return append_packet_chunked(s, pkt, size);
 }
 
+int ff_get_packet_ref(AVIOContext *s, AVPacket *pkt, int size)
+{
+    AVBufferRef *buf = NULL;
+    int64_t pos = avio_tell(s);
+
+    /* copy the data if the protocol cannot reference it */
+    if (ffio_read_buffer_ref(s, &buf, size) < 0)
+        return av_get_packet(s, pkt, size);
+
+    av_init_packet(pkt);
+    pkt->buf  = buf;
+    pkt->data = buf->data;
+    pkt->size = size;
+    pkt->pos  = pos;
+    return size;
+}
+
 int av_append_packet(AVIOContext *s, AVPacket *pkt, int size)
 {
     if (!pkt->size)
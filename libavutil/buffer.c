@@ -224,6 +224,7 @@ AVBufferPool *av_buffer_pool_init2(int size, void *opaque,
         return NULL;
 
     ff_mutex_init(&pool->mutex, NULL);
+    atomic_init(&pool->top, 0);
 
     pool->size      = size;
     pool->opaque    = opaque;
@@ -242,6 +243,7 @@ AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
         return NULL;
 
     ff_mutex_init(&pool->mutex, NULL);
+    atomic_init(&pool->top, 0);
 
     pool->size     = size;
     pool->alloc    = alloc ? alloc : av_buffer_alloc;
@@ -251,19 +253,25 @@ AVBufferPool *av_buffer_pool_init(int size, AVBufferRef* (*alloc)(int size))
     return pool;
 }
 
+static BufferPoolEntry *pool_entry(AVBufferPool *pool, unsigned index)
+{
+    return &pool->blocks[index >> POOL_BLOCK_BITS][index & (POOL_BLOCK_SIZE - 1)];
+}
+
 /*
  * This function gets called when the pool has been uninited and
  * all the buffers returned to it.
  */
 static void buffer_pool_free(AVBufferPool *pool)
 {
-    while (pool->pool) {
-        BufferPoolEntry *buf = pool->pool;
-        pool->pool = buf->next;
+    unsigned i;
 
+    for (i = 0; i < pool->nb_entries; i++) {
+        BufferPoolEntry *buf = pool_entry(pool, i);
         buf->free(buf->opaque, buf->data);
-        av_freep(&buf);
     }
+    for (i = 0; i < POOL_MAX_BLOCKS; i++)
+        av_freep(&pool->blocks[i]);
     ff_mutex_destroy(&pool->mutex);
 
     if (pool->pool_free)
@@ -285,6 +293,54 @@ void av_buffer_pool_uninit(AVBufferPool **ppool)
         buffer_pool_free(pool);
 }
 
+static void pool_push(AVBufferPool *pool, BufferPoolEntry *buf)
+{
+    intptr_t top, new_top;
+
+    if (!POOL_LOCK_FREE)
+        ff_mutex_lock(&pool->mutex);
+
+    top = atomic_load_explicit(&pool->top, memory_order_relaxed);
+    do {
+        atomic_store_explicit(&buf->next, (uintptr_t)top & POOL_INDEX_MASK,
+                              memory_order_relaxed);
+        new_top = (((uintptr_t)top >> POOL_INDEX_BITS) + 1) << POOL_INDEX_BITS |
+                  (buf->index + 1);
+    } while (!atomic_compare_exchange_weak_explicit(&pool->top, &top, new_top,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+
+    if (!POOL_LOCK_FREE)
+        ff_mutex_unlock(&pool->mutex);
+}
+
+static BufferPoolEntry *pool_pop(AVBufferPool *pool)
+{
+    intptr_t top, new_top;
+    BufferPoolEntry *buf;
+
+    if (!POOL_LOCK_FREE)
+        ff_mutex_lock(&pool->mutex);
+
+    top = atomic_load_explicit(&pool->top, memory_order_acquire);
+    do {
+        uintptr_t index = (uintptr_t)top & POOL_INDEX_MASK;
+        if (!index) {
+            buf = NULL;
+            break;
+        }
+        buf     = pool_entry(pool, index - 1);
+        new_top = (((uintptr_t)top >> POOL_INDEX_BITS) + 1) << POOL_INDEX_BITS |
+                  atomic_load_explicit(&buf->next, memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&pool->top, &top, new_top,
+                                                    memory_order_acquire,
+                                                    memory_order_acquire));
+
+    if (!POOL_LOCK_FREE)
+        ff_mutex_unlock(&pool->mutex);
+    return buf;
+}
+
 static void pool_release_buffer(void *opaque, uint8_t *data)
 {
     BufferPoolEntry *buf = opaque;
@@ -293,37 +349,46 @@ static void pool_release_buffer(void *opaque, uint8_t *data)
     if(CONFIG_MEMORY_POISONING)
         memset(buf->data, FF_MEMORY_POISON, pool->size);
 
-    ff_mutex_lock(&pool->mutex);
-    buf->next = pool->pool;
-    pool->pool = buf;
-    ff_mutex_unlock(&pool->mutex);
+    pool_push(pool, buf);
 
     if (atomic_fetch_add_explicit(&pool->refcount, -1, memory_order_acq_rel) == 1)
         buffer_pool_free(pool);
 }
 
 /* allocate a new buffer and override its free() callback so that
- * it is returned to the pool on free */
+ * it is returned to the pool on free; called with the pool mutex held */
 static AVBufferRef *pool_alloc_buffer(AVBufferPool *pool)
 {
     BufferPoolEntry *buf;
     AVBufferRef     *ret;
+    unsigned index = pool->nb_entries;
+    unsigned block = index >> POOL_BLOCK_BITS;
+
+    /* The pool is full: hand out a buffer that is freed instead of being
+     * returned to the pool, as the pool size is not limited by the API. */
+    if (index >= POOL_MAX_ENTRIES)
+        return pool->alloc2 ? pool->alloc2(pool->opaque, pool->size) :
+                              pool->alloc(pool->size);
+    if (!pool->blocks[block]) {
+        pool->blocks[block] = av_mallocz_array(POOL_BLOCK_SIZE,
+                                               sizeof(*pool->blocks[block]));
+        if (!pool->blocks[block])
+            return NULL;
+    }
 
     ret = pool->alloc2 ? pool->alloc2(pool->opaque, pool->size) :
                          pool->alloc(pool->size);
     if (!ret)
         return NULL;
 
-    buf = av_mallocz(sizeof(*buf));
-    if (!buf) {
-        av_buffer_unref(&ret);
-        return NULL;
-    }
-
+    buf = pool_entry(pool, index);
     buf->data   = ret->buffer->data;
     buf->opaque = ret->buffer->opaque;
     buf->free   = ret->buffer->free;
     buf->pool   = pool;
+    buf->index  = index;
+    atomic_init(&buf->next, 0);
+    pool->nb_entries++;
 
     ret->buffer->opaque = buf;
     ret->buffer->free   = pool_release_buffer;
@@ -336,21 +401,19 @@ AVBufferRef *av_buffer_pool_get(AVBufferPool *pool)
     AVBufferRef *ret;
     BufferPoolEntry *buf;
 
-    ff_mutex_lock(&pool->mutex);
-    buf = pool->pool;
+    buf = pool_pop(pool);
     if (buf) {
         ret = av_buffer_create(buf->data, pool->size, pool_release_buffer,
                                buf, 0);
-        if (ret) {
-            pool->pool = buf->next;
-            buf->next = NULL;
-        }
+        if (!ret)
+            pool_push(pool, buf);
     } else {
+        ff_mutex_lock(&pool->mutex);
         ret = pool_alloc_buffer(pool);
+        ff_mutex_unlock(&pool->mutex);
     }
-    ff_mutex_unlock(&pool->mutex);
 
-    if (ret)
+    if (ret && ret->buffer->free == pool_release_buffer)
         atomic_fetch_add_explicit(&pool->refcount, 1, memory_order_relaxed);
 
     return ret;
@@ -70,12 +70,55 @@ typedef struct BufferPoolEntry {
     void (*free)(void *opaque, uint8_t *data);
 
     AVBufferPool *pool;
-    struct BufferPoolEntry *next;
+
+    /*
+     * Index of this entry in the pool, and index + 1 of the next entry in
+     * the stack of available entries (0 for the last one).
+     */
+    unsigned index;
+    atomic_uint next;
 } BufferPoolEntry;
 
+/*
+ * Entries are allocated in blocks that are never moved nor freed before the
+ * pool itself, so that they can be accessed by index without locking.
+ * Buffers requested beyond POOL_MAX_ENTRIES are not pooled.
+ */
+#define POOL_BLOCK_BITS  8
+#define POOL_BLOCK_SIZE  (1 << POOL_BLOCK_BITS)
+#define POOL_MAX_BLOCKS  256
+#define POOL_MAX_ENTRIES (POOL_BLOCK_SIZE * POOL_MAX_BLOCKS - 1)
+
+/*
+ * The top of the stack of available entries packs the index + 1 of the top
+ * entry in the low half of a pointer-sized word, and a counter incremented
+ * on every update in the high half, which protects the lock-free pop
+ * against the ABA problem.
+ */
+#define POOL_INDEX_BITS  (sizeof(intptr_t) * 4)
+#define POOL_INDEX_MASK  (((uintptr_t)1 << POOL_INDEX_BITS) - 1)
+
+/*
+ * With 32-bit pointers the counter has only 16 bits, which can wrap around
+ * while a pop is preempted between reading the top and exchanging it, so
+ * the stack is then only updated with the pool mutex held.
+ */
+#if UINTPTR_MAX > UINT32_MAX
+#define POOL_LOCK_FREE 1
+#else
+#define POOL_LOCK_FREE 0
+#endif
+
 struct AVBufferPool {
+    /*
+     * Serializes the allocation of new buffers; getting and releasing
+     * buffers already in the pool is lock-free if POOL_LOCK_FREE is set.
+     */
     AVMutex mutex;
-    BufferPoolEntry *pool;
+    atomic_intptr_t top;
+
+    BufferPoolEntry *blocks[POOL_MAX_BLOCKS];
+    unsigned nb_entries;
 
     /*
      * This is used to track when the pool is to be freed.
@@ -27,11 +27,126 @@
 #include "time_internal.h"
 #include "bprint.h"
 
+/**
+ * Minimum number of entries for which a hash index of the keys is kept.
+ * Smaller dictionaries are searched linearly.
+ */
+#define DICT_HASH_MIN_ENTRIES 16
+
 struct AVDictionary {
     int count;
     AVDictionaryEntry *elems;
+    /**
+     * Open addressing hash table of the entries, indexed by the case
+     * insensitive hash of their key. Each slot holds an entry index + 1,
+     * or 0 for an empty slot. NULL when the dictionary is not indexed.
+     */
+    unsigned *hash;
+    unsigned hash_size; ///< number of slots in hash, a power of 2
 };
 
+static unsigned dict_hash_key(const char *key)
+{
+    unsigned h = 0;
+
+    while (*key)
+        h = h * 31 + av_toupper(*key++);
+    return h ^ (h >> 15);
+}
+
+static int dict_match_key(const char *s, const char *key, int flags)
+{
+    unsigned int j;
+
+    if (flags & AV_DICT_MATCH_CASE)
+        for (j = 0; s[j] == key[j] && key[j]; j++)
+            ;
+    else
+        for (j = 0; av_toupper(s[j]) == av_toupper(key[j]) && key[j]; j++)
+            ;
+    if (key[j])
+        return 0;
+    if (s[j] && !(flags & AV_DICT_IGNORE_SUFFIX))
+        return 0;
+    return 1;
+}
+
+static void dict_hash_insert(AVDictionary *m, unsigned idx)
+{
+    unsigned mask = m->hash_size - 1;
+    unsigned slot = dict_hash_key(m->elems[idx].key) & mask;
+
+    while (m->hash[slot])
+        slot = (slot + 1) & mask;
+    m->hash[slot] = idx + 1;
+}
+
+static unsigned dict_hash_find(const AVDictionary *m, unsigned idx)
+{
+    unsigned mask = m->hash_size - 1;
+    unsigned slot = dict_hash_key(m->elems[idx].key) & mask;
+
+    while (m->hash[slot] != idx + 1)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+/**
+ * Remove the entry idx from the index, shifting back the following slots of
+ * the probe sequence so that no tombstones are needed.
+ */
+static void dict_hash_remove(AVDictionary *m, unsigned idx)
+{
+    unsigned mask = m->hash_size - 1;
+    unsigned hole = dict_hash_find(m, idx);
+    unsigned slot = hole;
+
+    m->hash[hole] = 0;
+    for (;;) {
+        unsigned home;
+
+        slot = (slot + 1) & mask;
+        if (!m->hash[slot])
+            break;
+        home = dict_hash_key(m->elems[m->hash[slot] - 1].key) & mask;
+        /* move the entry into the hole unless its home slot lies
+         * cyclically in (hole, slot] */
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            m->hash[hole] = m->hash[slot];
+            m->hash[slot] = 0;
+            hole = slot;
+        }
+    }
+}
+
+/**
+ * Add the last entry of the dictionary to the index, creating or growing
+ * the index as needed. On allocation failure the index is dropped, lookups
+ * then fall back to a linear search.
+ */
+static void dict_hash_add_last(AVDictionary *m)
+{
+    unsigned i, size;
+
+    if (m->hash && 2U * m->count <= m->hash_size) {
+        dict_hash_insert(m, m->count - 1);
+        return;
+    }
+    if (m->count < DICT_HASH_MIN_ENTRIES)
+        return;
+
+    for (size = 2 * DICT_HASH_MIN_ENTRIES; size < 4U * m->count; size <<= 1)
+        ;
+    av_freep(&m->hash);
+    m->hash_size = 0;
+    m->hash = av_mallocz_array(size, sizeof(*m->hash));
+    if (!m->hash)
+        return;
+    m->hash_size = size;
+    for (i = 0; i < m->count; i++)
+        dict_hash_insert(m, i);
+}
+
 int av_dict_count(const AVDictionary *m)
 {
     return m ? m->count : 0;
@@ -40,7 +155,7 @@ int av_dict_count(const AVDictionary *m)
 AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
                                const AVDictionaryEntry *prev, int flags)
 {
-    unsigned int i, j;
+    unsigned int i;
 
     if (!m)
         return NULL;
@@ -50,19 +165,25 @@ AVDictionaryEntry *av_dict_get(const AVDictionary *m, const char *key,
     else
         i = 0;
 
+    if (m->hash && !(flags & AV_DICT_IGNORE_SUFFIX)) {
+        /* exact keys match within the probe sequence of their hash, return
+         * the matching entry with the lowest index not before i */
+        unsigned mask = m->hash_size - 1;
+        unsigned slot = dict_hash_key(key) & mask;
+        unsigned best = m->count;
+
+        for (; m->hash[slot]; slot = (slot + 1) & mask) {
+            unsigned idx = m->hash[slot] - 1;
+            if (idx >= i && idx < best &&
+                dict_match_key(m->elems[idx].key, key, flags))
+                best = idx;
+        }
+        return best < m->count ? &m->elems[best] : NULL;
+    }
+
     for (; i < m->count; i++) {
-        const char *s = m->elems[i].key;
-        if (flags & AV_DICT_MATCH_CASE)
-            for (j = 0; s[j] == key[j] && key[j]; j++)
-                ;
-        else
-            for (j = 0; av_toupper(s[j]) == av_toupper(key[j]) && key[j]; j++)
-                ;
-        if (key[j])
-            continue;
-        if (s[j] && !(flags & AV_DICT_IGNORE_SUFFIX))
-            continue;
-        return &m->elems[i];
+        if (dict_match_key(m->elems[i].key, key, flags))
+            return &m->elems[i];
     }
     return NULL;
 }
@@ -96,6 +217,12 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             av_free(copy_value);
             return 0;
         }
+        if (m->hash) {
+            unsigned idx = tag - m->elems;
+            dict_hash_remove(m, idx);
+            if (idx != m->count - 1)
+                m->hash[dict_hash_find(m, m->count - 1)] = idx + 1;
+        }
         if (flags & AV_DICT_APPEND)
             oldval = tag->value;
         else
@@ -124,10 +251,12 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
             av_freep(&copy_value);
         }
         m->count++;
+        dict_hash_add_last(m);
     } else {
         av_freep(&copy_key);
     }
     if (!m->count) {
+        av_freep(&m->hash);
         av_freep(&m->elems);
         av_freep(pm);
     }
@@ -136,6 +265,7 @@ int av_dict_set(AVDictionary **pm, const char *key, const char *value,
 
 err_out:
     if (m && !m->count) {
+        av_freep(&m->hash);
         av_freep(&m->elems);
         av_freep(pm);
     }
@@ -209,6 +339,7 @@ void av_dict_free(AVDictionary **pm)
             av_freep(&m->elems[m->count].key);
             av_freep(&m->elems[m->count].value);
         }
+        av_freep(&m->hash);
         av_freep(&m->elems);
     }
     av_freep(pm);
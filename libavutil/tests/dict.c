@@ -54,6 +54,8 @@ int main(void)
     AVDictionary *dict = NULL;
     AVDictionaryEntry *e;
     char *buffer = NULL;
+    char key[16];
+    int i, mismatches;
 
     printf("Testing av_dict_get_string() and av_dict_parse_string()\n");
     av_dict_get_string(dict, &buffer, '=', ',');
@@ -132,5 +134,41 @@ int main(void)
     printf("%s\n", e->value);
     av_dict_free(&dict);
 
+    printf("\nTesting av_dict_get() with many entries\n");
+    for (i = 0; i < 1000; i++) {
+        snprintf(key, sizeof(key), "key%d", i);
+        av_dict_set_int(&dict, key, i, 0);
+    }
+    for (i = 0; i < 1000; i += 3) {
+        snprintf(key, sizeof(key), "KEY%d", i);
+        av_dict_set_int(&dict, key, -i, 0);
+    }
+    for (i = 0; i < 1000; i += 5) {
+        snprintf(key, sizeof(key), "key%d", i);
+        av_dict_set(&dict, key, NULL, 0);
+    }
+    for (i = 0; i < 1000; i += 7) {
+        snprintf(key, sizeof(key), "key%d", i);
+        av_dict_set_int(&dict, key, i, AV_DICT_MULTIKEY);
+    }
+    mismatches = 0;
+    for (i = 0; i < 1000; i++) {
+        AVDictionaryEntry *ref = NULL;
+        snprintf(key, sizeof(key), "Key%d", i);
+        e = NULL;
+        do {
+            while ((ref = av_dict_get(dict, "", ref, AV_DICT_IGNORE_SUFFIX)))
+                if (!av_strcasecmp(ref->key, key))
+                    break;
+            e = av_dict_get(dict, key, e, 0);
+            if (e != ref)
+                mismatches++;
+        } while (e && ref);
+        if (av_dict_get(dict, key, NULL, AV_DICT_MATCH_CASE))
+            mismatches++;
+    }
+    printf("%d entries, %d mismatches\n", av_dict_count(dict), mismatches);
+    av_dict_free(&dict);
+
     return 0;
 }
@@ -262,6 +262,9 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     const int chrSrcSliceH           = AV_CEIL_RSHIFT(srcSliceH,   c->chrSrcVSubSample);
     int should_dither                = isNBPS(c->srcFormat) ||
                                        is16BPS(c->srcFormat);
+    /* only a band of the destination is output by slice thread contexts */
+    const int scale_dst              = c->dst_slice_end > 0;
+    int dstEnd                       = dstH;
     int lastDstY;
 
     /* vars which will change and which we need to store back in the context */
@@ -347,6 +350,10 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
+    if (scale_dst) {
+        dstY   = c->dst_slice_start;
+        dstEnd = c->dst_slice_end;
+    }
 
     if (!should_dither) {
         c->chrDither8 = c->lumDither8 = sws_pb_64;
@@ -359,9 +366,14 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     ff_init_slice_from_src(src_slice, (uint8_t**)src, srcStride, c->srcW,
             srcSliceY, srcSliceH, chrSrcSliceY, chrSrcSliceH, 1);
 
-    ff_init_slice_from_src(vout_slice, (uint8_t**)dst, dstStride, c->dstW,
-            dstY, dstH, dstY >> c->chrDstVSubSample,
-            AV_CEIL_RSHIFT(dstH, c->chrDstVSubSample), 0);
+    if (scale_dst)
+        ff_init_slice_from_src(vout_slice, (uint8_t**)dst, dstStride, c->dstW,
+                dstY, dstEnd - dstY, dstY >> c->chrDstVSubSample,
+                AV_CEIL_RSHIFT(dstEnd, c->chrDstVSubSample) - (dstY >> c->chrDstVSubSample), 0);
+    else
+        ff_init_slice_from_src(vout_slice, (uint8_t**)dst, dstStride, c->dstW,
+                dstY, dstH, dstY >> c->chrDstVSubSample,
+                AV_CEIL_RSHIFT(dstH, c->chrDstVSubSample), 0);
     if (srcSliceY == 0) {
         hout_slice->plane[0].sliceY = lastInLumBuf + 1;
         hout_slice->plane[1].sliceY = lastInChrBuf + 1;
@@ -375,7 +387,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         hout_slice->width = dstW;
     }
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
@@ -1000,3 +1012,73 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     av_free(rgb0_tmp);
     return ret;
 }
+
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads)
+{
+    SwsContext *parent = priv;
+    SwsContext      *c = parent->slice_ctx[threadnr];
+    const AVFrame *src = parent->frame_src;
+    AVFrame       *dst = parent->frame_dst;
+    const int    align = 1 << parent->chrDstVSubSample;
+    const uint8_t *src2[4];
+    uint8_t *dst2[4];
+    int srcStride2[4], dstStride2[4];
+    int start, end, ret;
+
+    start = (parent->dstH * (int64_t) jobnr      / nb_jobs) & ~(align - 1);
+    end   = jobnr == nb_jobs - 1 ? parent->dstH :
+            (parent->dstH * (int64_t)(jobnr + 1) / nb_jobs) & ~(align - 1);
+    if (start >= end) {
+        parent->slice_err[jobnr] = 0;
+        return;
+    }
+
+    memcpy(src2,       src->data,     sizeof(src2));
+    memcpy(dst2,       dst->data,     sizeof(dst2));
+    memcpy(srcStride2, src->linesize, sizeof(srcStride2));
+    memcpy(dstStride2, dst->linesize, sizeof(dstStride2));
+    reset_ptr(src2, c->srcFormat);
+    reset_ptr((void*)dst2, c->dstFormat);
+
+    c->dst_slice_start = start;
+    c->dst_slice_end   = end;
+    ret = c->swscale(c, src2, srcStride2, 0, c->srcH, dst2, dstStride2);
+    parent->slice_err[jobnr] = ret < 0 ? ret : 0;
+}
+
+int sws_scale_frame(struct SwsContext *c, AVFrame *dst, const AVFrame *src)
+{
+    int i;
+
+    /* A cascade created after init, e.g. by sws_setColorspaceDetails(),
+     * is only run by sws_scale(). */
+    if (c->slicethread && !c->cascaded_context[0]) {
+        for (i = 0; i < 4; i++)
+            if (src->linesize[i] < 0 || dst->linesize[i] < 0)
+                break;
+        if (i == 4) {
+            if (!check_image_pointers((const uint8_t * const *)src->data,
+                                      c->srcFormat, src->linesize) ||
+                !check_image_pointers((const uint8_t * const *)dst->data,
+                                      c->dstFormat, dst->linesize)) {
+                av_log(c, AV_LOG_ERROR, "bad frame pointers\n");
+                return AVERROR(EINVAL);
+            }
+
+            c->frame_src = src;
+            c->frame_dst = dst;
+            avpriv_slicethread_execute(c->slicethread, c->nb_slice_ctx, 0);
+            c->frame_src = NULL;
+            c->frame_dst = NULL;
+
+            for (i = 0; i < c->nb_slice_ctx; i++)
+                if (c->slice_err[i] < 0)
+                    return c->slice_err[i];
+            return c->dstH;
+        }
+    }
+
+    return sws_scale(c, (const uint8_t * const *)src->data, src->linesize,
+                     0, c->srcH, dst->data, dst->linesize);
+}
@@ -30,6 +30,7 @@
 #include <stdint.h>
 
 #include "libavutil/avutil.h"
+#include "libavutil/frame.h"
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
 #include "version.h"
@@ -218,6 +219,22 @@ int sws_scale(struct SwsContext *c, const uint8_t *const srcSlice[],
               const int srcStride[], int srcSliceY, int srcSliceH,
               uint8_t *const dst[], const int dstStride[]);
 
+/**
+ * Scale a whole frame.
+ *
+ * If the context was initialized with the threads option different from 1,
+ * the destination is split into horizontal bands scaled in parallel.
+ * Conversions that do not support this are done by a single sws_scale()
+ * call. This includes the unscaled special converters, alpha blending and
+ * conversions done through an intermediate format.
+ *
+ * @param c   the scaling context
+ * @param dst the destination frame, with its buffers already allocated
+ * @param src the source frame
+ * @return    the height of the output image or a negative AVERROR code
+ */
+int sws_scale_frame(struct SwsContext *c, AVFrame *dst, const AVFrame *src);
+
 /**
  * @param dstRange flag indicating the while-black range of the output (1=jpeg / 0=mpeg)
  * @param srcRange flag indicating the while-black range of the input (1=jpeg / 0=mpeg)
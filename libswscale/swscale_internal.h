@@ -27,10 +27,12 @@
 #include "libavutil/avassert.h"
 #include "libavutil/avutil.h"
 #include "libavutil/common.h"
+#include "libavutil/frame.h"
 #include "libavutil/intreadwrite.h"
 #include "libavutil/log.h"
 #include "libavutil/pixfmt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/ppc/util_altivec.h"
 
 #define STR(s) AV_TOSTRING(s) // AV_STRINGIFY is too long
@@ -321,6 +323,20 @@ typedef struct SwsContext {
     uint8_t *cascaded1_tmp[4];
     int cascaded_mainindex;
 
+    /* The slice_* fields implement slice threading in sws_scale_frame():
+     * each thread owns an independent context scaling a band of the
+     * destination, delimited by dst_slice_start and dst_slice_end.
+     */
+    int nb_threads;
+    AVSliceThread *slicethread;
+    struct SwsContext **slice_ctx;
+    int *slice_err;
+    int nb_slice_ctx;
+    const AVFrame *frame_src;
+    AVFrame *frame_dst;
+    int dst_slice_start;
+    int dst_slice_end;
+
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
@@ -858,6 +874,9 @@ void ff_get_unscaled_swscale_aarch64(SwsContext *c);
  */
 SwsFunc ff_getSwsFunc(SwsContext *c);
 
+void ff_sws_slice_worker(void *priv, int jobnr, int threadnr,
+                         int nb_jobs, int nb_threads);
+
 void ff_sws_init_input_funcs(SwsContext *c);
 void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2planar1_fn *yuv2plane1,
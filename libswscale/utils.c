@@ -860,6 +860,15 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     const AVPixFmtDescriptor *desc_dst;
     const AVPixFmtDescriptor *desc_src;
     int need_reinit = 0;
+    int i;
+
+    for (i = 0; i < c->nb_slice_ctx; i++) {
+        int ret = sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange,
+                                           table, dstRange, brightness,
+                                           contrast, saturation);
+        if (ret < 0)
+            return ret;
+    }
 
     handle_formats(c);
     desc_dst = av_pix_fmt_desc_get(c->dstFormat);
@@ -1160,6 +1169,61 @@ static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
     }
 }
 
+static av_cold int context_init_threaded(SwsContext *c,
+                                        SwsFilter *src_filter, SwsFilter *dst_filter)
+{
+    int i, ret;
+
+    /* These conversions need a per-frame preparation of the source done in
+     * sws_scale(), or carry state from one line to the next. */
+    if (usePal(c->srcFormat) || c->src0Alpha || c->dst0Alpha ||
+        c->srcXYZ || c->dstXYZ || c->dither == SWS_DITHER_ED)
+        return 0;
+
+    ret = avpriv_slicethread_create(&c->slicethread, (void*)c,
+                                    ff_sws_slice_worker, NULL, c->nb_threads);
+    if (ret == AVERROR(ENOSYS))
+        return 0;
+    if (ret < 0)
+        return ret;
+    if (ret == 1) {
+        avpriv_slicethread_free(&c->slicethread);
+        return 0;
+    }
+
+    c->slice_ctx = av_mallocz_array(ret, sizeof(*c->slice_ctx));
+    c->slice_err = av_mallocz_array(ret, sizeof(*c->slice_err));
+    if (!c->slice_ctx || !c->slice_err)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < ret; i++) {
+        int err;
+
+        c->slice_ctx[i] = sws_alloc_context();
+        if (!c->slice_ctx[i])
+            return AVERROR(ENOMEM);
+        c->nb_slice_ctx++;
+
+        err = av_opt_copy(c->slice_ctx[i], c);
+        if (err < 0)
+            return err;
+        c->slice_ctx[i]->nb_threads = 1;
+
+        err = sws_init_context(c->slice_ctx[i], src_filter, dst_filter);
+        if (err < 0)
+            return err;
+
+        err = sws_setColorspaceDetails(c->slice_ctx[i], c->srcColorspaceTable,
+                                       c->srcRange, c->dstColorspaceTable,
+                                       c->dstRange, c->brightness,
+                                       c->contrast, c->saturation);
+        if (err < 0)
+            return err;
+    }
+
+    return 0;
+}
+
 av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                              SwsFilter *dstFilter)
 {
@@ -1827,7 +1891,12 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     }
 
     c->swscale = ff_getSwsFunc(c);
-    return ff_init_filters(c);
+    ret = ff_init_filters(c);
+    if (ret < 0)
+        return ret;
+    if (c->nb_threads != 1)
+        return context_init_threaded(c, srcFilter, dstFilter);
+    return 0;
 fail: // FIXME replace things by appropriate error codes
     if (ret == RETCODE_USE_CASCADE)  {
         int tmpW = sqrt(srcW * (int64_t)dstW);
@@ -2358,6 +2427,13 @@ void sws_freeContext(SwsContext *c)
     av_freep(&c->cascaded_tmp[0]);
     av_freep(&c->cascaded1_tmp[0]);
 
+    avpriv_slicethread_free(&c->slicethread);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+    av_freep(&c->slice_err);
+    c->nb_slice_ctx = 0;
+
     av_freep(&c->gamma);
     av_freep(&c->inv_gamma);
 
@@ -101,6 +101,60 @@ static void check_sub_left_pred(LLVidEncDSPContext *c)
     }
 }
 
+static void check_sub_png_pred(LLVidEncDSPContext *c)
+{
+    static const int bpps[] = { 1, 2, 3, 4, 6, 8 };
+    int i, j;
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src,  [MAX_STRIDE + 16]);
+    LOCAL_ALIGNED_32(uint8_t, top,  [MAX_STRIDE + 16]);
+
+    declare_func(void, uint8_t *dst, const uint8_t *src, const uint8_t *top,
+                 intptr_t w, int bpp);
+
+    for (j = 0; j < 2; j++) {
+        void (*func)(uint8_t *, const uint8_t *, const uint8_t *, intptr_t, int) =
+            j ? c->sub_png_paeth_pred : c->sub_png_avg_pred;
+
+        if (!check_func(func, j ? "sub_png_paeth_pred" : "sub_png_avg_pred"))
+            continue;
+
+        for (i = 0; i < FF_ARRAY_ELEMS(bpps); i++) {
+            int w = 16 * (1 + rnd() % (MAX_STRIDE / 16));
+
+            randomize_buffers(src, MAX_STRIDE + 16);
+            randomize_buffers(top, MAX_STRIDE + 16);
+            memset(dst0, 0, MAX_STRIDE);
+            memset(dst1, 0, MAX_STRIDE);
+            call_ref(dst0, src + 16, top + 16, w, bpps[i]);
+            call_new(dst1, src + 16, top + 16, w, bpps[i]);
+            if (memcmp(dst0, dst1, MAX_STRIDE))
+                fail();
+        }
+        bench_new(dst1, src + 16, top + 16, MAX_STRIDE, 3);
+    }
+}
+
+static void check_sum_abs_int8(LLVidEncDSPContext *c)
+{
+    int i;
+    LOCAL_ALIGNED_32(uint8_t, src, [MAX_STRIDE + 16]);
+
+    declare_func(int, const uint8_t *src, intptr_t w);
+
+    if (check_func(c->sum_abs_int8, "sum_abs_int8")) {
+        for (i = 0; i < 5; i++) {
+            int w = 16 * (rnd() % (MAX_STRIDE / 16 + 1));
+
+            randomize_buffers(src, MAX_STRIDE + 16);
+            if (call_ref(src + 1, w) != call_new(src + 1, w))
+                fail();
+        }
+        bench_new(src, MAX_STRIDE);
+    }
+}
+
 void checkasm_check_llviddspenc(void)
 {
     LLVidEncDSPContext c;
@@ -111,4 +165,10 @@ void checkasm_check_llviddspenc(void)
 
     check_sub_left_pred(&c);
     report("sub_left_predict");
+
+    check_sub_png_pred(&c);
+    report("sub_png_pred");
+
+    check_sum_abs_int8(&c);
+    report("sum_abs_int8");
 }
@@ -0,0 +1,88 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "libavutil/mem.h"
+
+#include "libavcodec/lpc.h"
+
+#include "checkasm.h"
+
+#define MAX_LEN 4608
+/* zero padding before and after the samples, as in LPCContext.windowed_buffer */
+#define PAD_BEFORE MAX_LPC_ORDER
+#define PAD_AFTER  2
+
+/* The SIMD versions split the sums differently than the C one, so the
+ * results are only compared up to rounding, relative to autoc[0], which
+ * bounds the sum of the absolute products of every lag. */
+#define EPS 1e-12
+
+/* 24 bit samples, the largest the flac encoder feeds the lpc code, followed
+ * by zeros */
+#define randomize_buffer(buf, len)                                        \
+    do {                                                                  \
+        int k;                                                            \
+        for (k = 0; k < len; k++)                                         \
+            buf[k] = (int)(rnd() & 0xffffff) - 0x800000;                  \
+        memset(buf + len, 0, (MAX_LEN + PAD_AFTER - len) * sizeof(*buf)); \
+    } while (0)
+
+static const int lens[] = { 16, 17, 192, 1151, 4096, MAX_LEN };
+
+static void check_compute_autocorr(LPCContext *c)
+{
+    LOCAL_ALIGNED_16(double, buf, [PAD_BEFORE + MAX_LEN + PAD_AFTER]);
+    LOCAL_ALIGNED_16(double, autoc0, [MAX_LPC_ORDER + 1]);
+    LOCAL_ALIGNED_16(double, autoc1, [MAX_LPC_ORDER + 1]);
+    double *data = buf + PAD_BEFORE;
+    int i, lag;
+
+    declare_func(void, const double *data, int len, int lag, double *autoc);
+
+    memset(buf, 0, PAD_BEFORE * sizeof(*buf));
+
+    for (lag = 1; lag <= MAX_LPC_ORDER; lag++) {
+        if (check_func(c->lpc_compute_autocorr, "lpc_compute_autocorr_%d", lag)) {
+            for (i = 0; i < FF_ARRAY_ELEMS(lens); i++) {
+                randomize_buffer(data, lens[i]);
+                call_ref(data, lens[i], lag, autoc0);
+                call_new(data, lens[i], lag, autoc1);
+                if (!double_near_abs_eps_array(autoc0, autoc1,
+                                               fabs(autoc0[0]) * EPS, lag + 1))
+                    fail();
+            }
+            bench_new(data, MAX_LEN, lag, autoc1);
+        }
+    }
+}
+
+void checkasm_check_lpc(void)
+{
+    LPCContext ctx;
+
+    if (ff_lpc_init(&ctx, MAX_LEN, MAX_LPC_ORDER, FF_LPC_TYPE_LEVINSON) < 0)
+        return;
+
+    check_compute_autocorr(&ctx);
+    report("compute_autocorr");
+
+    ff_lpc_end(&ctx);
+}
@@ -0,0 +1,107 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/avcodec.h"
+#include "libavcodec/me_cmp.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+
+#define STRIDE   64
+#define BUF_SIZE (STRIDE * (16 + 1))
+
+/* pix2 differs from pix1 by at most range, like a block and its prediction */
+static void randomize_buffers(uint8_t *pix1, uint8_t *pix2, int range)
+{
+    int i;
+
+    for (i = 0; i < BUF_SIZE; i++) {
+        pix1[i] = rnd();
+        pix2[i] = av_clip_uint8(pix1[i] + (int)(rnd() % (2 * range + 1)) - range);
+    }
+}
+
+static void check_me_cmp(me_cmp_func func, const char *name, int width,
+                         const int *heights, int range)
+{
+    LOCAL_ALIGNED_16(uint8_t, pix1, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, pix2, [BUF_SIZE]);
+    int i, j;
+
+    declare_func_emms(AV_CPU_FLAG_MMX, int, struct MpegEncContext *c,
+                      uint8_t *blk1, uint8_t *blk2, ptrdiff_t stride, int h);
+
+    for (i = 0; heights[i]; i++) {
+        int h = heights[i];
+
+        if (!check_func(func, "%s_%dx%d", name, width, h))
+            continue;
+
+        for (j = 0; j < 4; j++) {
+            /* blk1 is aligned to the block width, blk2 is not aligned */
+            int offset1 = (rnd() % (STRIDE / width - 1)) * width;
+            int offset2 = rnd() % (STRIDE - width - 1);
+            int ref, new;
+
+            randomize_buffers(pix1, pix2, range);
+            ref = call_ref(NULL, pix1 + offset1, pix2 + offset2, STRIDE, h);
+            new = call_new(NULL, pix1 + offset1, pix2 + offset2, STRIDE, h);
+            if (ref != new) {
+                fprintf(stderr, "%s_%dx%d: %d != %d\n", name, width, h, ref, new);
+                fail();
+                break;
+            }
+        }
+        bench_new(NULL, pix1, pix2, STRIDE, h);
+    }
+}
+
+void checkasm_check_motion(void)
+{
+    static const char *const pix_abs_names[4] = {
+        "pix_abs", "pix_abs_x2", "pix_abs_y2", "pix_abs_xy2",
+    };
+    static const int heights16[] = { 8, 16, 0 };
+    static const int heights8[]  = { 4, 8, 16, 0 };
+    static const int heights8x8[] = { 8, 0 };
+    AVCodecContext avctx = {
+        .flags = AV_CODEC_FLAG_BITEXACT,
+    };
+    MECmpContext c;
+    int i;
+
+    ff_me_cmp_init(&c, &avctx);
+
+    check_me_cmp(c.sad[0], "sad", 16, heights16, 255);
+    check_me_cmp(c.sad[1], "sad", 8,  heights8,  255);
+    report("sad");
+
+    for (i = 0; i < 4; i++) {
+        check_me_cmp(c.pix_abs[0][i], pix_abs_names[i], 16, heights16, 255);
+        check_me_cmp(c.pix_abs[1][i], pix_abs_names[i], 8,  heights8,  255);
+    }
+    report("pix_abs");
+
+    /* The SIMD versions saturate the sum of each 8x8 block at 16 bits,
+     * which small differences never reach. */
+    check_me_cmp(c.hadamard8_diff[0], "hadamard8_diff", 16, heights16,  15);
+    check_me_cmp(c.hadamard8_diff[1], "hadamard8_diff", 8,  heights8x8, 15);
+    report("hadamard8_diff");
+}
@@ -0,0 +1,130 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavcodec/avcodec.h"
+#include "libavcodec/proresdsp.h"
+
+/* The SIMD 12-bit IDCT uses the coefficients of the 10-bit one, see
+ * libavcodec/x86/proresdsp.asm, and is only used with the simplemmx IDCT. */
+#define MAX_DIFF_12 2
+
+#define DST_STRIDE 16
+
+/* Quantized coefficients of a random block of pixels, so that the
+ * dequantized coefficients cover the whole range of actual streams. */
+static void randomize_block(int16_t *block, int16_t *qmat, int bits, int type)
+{
+    int max = (1 << bits) - 1;
+    /* the 10-bit coefficients have two more fractional bits */
+    double scale = bits == 10 ? 4.0 : 1.0;
+    int pixels[64];
+    int i, u, v, x, y;
+
+    for (i = 0; i < 64; i++) {
+        switch (type) {
+        case 0:  pixels[i] = rnd() & max;                      break;
+        case 1:  pixels[i] = rnd() & 1 ? max : 0;               break;
+        default: pixels[i] = (i * (max >> 6) + rnd() % 64) & max; break;
+        }
+    }
+
+    for (u = 0; u < 8; u++) {
+        for (v = 0; v < 8; v++) {
+            double sum = 0;
+            int level;
+
+            for (y = 0; y < 8; y++)
+                for (x = 0; x < 8; x++)
+                    sum += (pixels[y * 8 + x] - (1 << (bits - 1))) *
+                           cos(M_PI * (2 * x + 1) * v / 16.0) *
+                           cos(M_PI * (2 * y + 1) * u / 16.0);
+            sum *= 0.25 * scale * (u ? 1 : M_SQRT1_2) * (v ? 1 : M_SQRT1_2);
+
+            i       = u * 8 + v;
+            qmat[i] = 1 + rnd() % 64;
+            level   = lrint(sum / qmat[i]);
+            block[i] = av_clip(level, INT16_MIN / qmat[i], INT16_MAX / qmat[i]);
+        }
+    }
+}
+
+static void check_idct_put(ProresDSPContext *dsp, int bits)
+{
+    LOCAL_ALIGNED_16(int16_t, block,     [64]);
+    LOCAL_ALIGNED_16(int16_t, qmat,      [64]);
+    LOCAL_ALIGNED_16(int16_t, block_ref, [64]);
+    LOCAL_ALIGNED_16(int16_t, block_new, [64]);
+    LOCAL_ALIGNED_16(int16_t, qmat_new,  [64]);
+    LOCAL_ALIGNED_16(uint16_t, dst_ref,  [8 * DST_STRIDE]);
+    LOCAL_ALIGNED_16(uint16_t, dst_new,  [8 * DST_STRIDE]);
+    int max_diff = bits == 12 ? MAX_DIFF_12 : 0;
+    int i, j;
+
+    declare_func(void, uint16_t *out, ptrdiff_t linesize,
+                 int16_t *block, const int16_t *qmat);
+
+    if (!check_func(dsp->idct_put, "prores_idct_put_%d", bits))
+        return;
+
+    for (j = 0; j < 48; j++) {
+        randomize_block(block, qmat, bits, j % 3);
+        /* the reference is the C version, which takes the natural order */
+        memcpy(block_ref, block, 64 * sizeof(*block));
+        for (i = 0; i < 64; i++) {
+            block_new[dsp->idct_permutation[i]] = block[i];
+            qmat_new [dsp->idct_permutation[i]] = qmat[i];
+        }
+        memset(dst_ref, 0, 8 * DST_STRIDE * sizeof(*dst_ref));
+        memset(dst_new, 0, 8 * DST_STRIDE * sizeof(*dst_new));
+
+        call_ref(dst_ref, DST_STRIDE * sizeof(*dst_ref), block_ref, qmat);
+        call_new(dst_new, DST_STRIDE * sizeof(*dst_new), block_new, qmat_new);
+
+        for (i = 0; i < 8 * DST_STRIDE; i++) {
+            if (abs(dst_ref[i] - dst_new[i]) > max_diff) {
+                fail();
+                break;
+            }
+        }
+    }
+
+    bench_new(dst_new, DST_STRIDE * sizeof(*dst_new), block_new, qmat_new);
+}
+
+void checkasm_check_proresdsp(void)
+{
+    static const int bits[] = { 10, 12 };
+    AVCodecContext avctx = { 0 };
+    ProresDSPContext dsp;
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(bits); i++) {
+        avctx.bits_per_raw_sample = bits[i];
+        avctx.idct_algo           = FF_IDCT_SIMPLEMMX;
+        if (ff_proresdsp_init(&dsp, &avctx) < 0)
+            return;
+        check_idct_put(&dsp, bits[i]);
+    }
+
+    report("idct_put");
+}
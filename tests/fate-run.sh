@@ -243,6 +243,35 @@ stream_remux(){
         -f framecrc - || return
 }
 
+# $1=dash manifest, prints its SegmentTemplate and the number of fragments
+# and segment indexes of each media segment
+mp4boxes(){
+    file=$1
+    size=$(wc -c < $file)
+    pos=0
+    while [ $((pos + 8)) -le $size ]; do
+        set -- $(od -A n -t u1 -j $pos -N 16 $file)
+        len=$(( ($1 << 24) | ($2 << 16) | ($3 << 8) | $4 ))
+        [ $len -eq 1 ] && len=$(( (${13} << 24) | (${14} << 16) | (${15} << 8) | ${16} ))
+        [ $len -eq 0 ] && len=$((size - pos))
+        [ $len -lt 8 ] && return 1
+        printf "\\$(printf %o $5)\\$(printf %o $6)\\$(printf %o $7)\\$(printf %o $8)\n"
+        pos=$((pos + len))
+    done
+}
+
+dashfragments(){
+    mpd=$1
+    mpddir=$(dirname $mpd)
+    grep -o '<SegmentTemplate [^>]*>' $mpd
+    for seg in $(ls $mpddir | grep '^chunk-'); do
+        boxes=$(mp4boxes $mpddir/$seg) || return 1
+        moof=$(echo "$boxes" | grep -c '^moof$')
+        sidx=$(echo "$boxes" | grep -c '^sidx$')
+        echo "$seg moof=$moof sidx=$sidx"
+    done
+}
+
 lavffatetest(){
     t="${test#lavf-fate-}"
     ref=${base}/ref/lavf-fate/$t
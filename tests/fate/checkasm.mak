@@ -18,7 +18,10 @@ FATE_CHECKASM = fate-checkasm-aacpsdsp                                  \
                 fate-checkasm-jpeg2000dsp                               \
                 fate-checkasm-llviddsp                                  \
                 fate-checkasm-llviddspenc                               \
+                fate-checkasm-lpc                                       \
+                fate-checkasm-motion                                    \
                 fate-checkasm-pixblockdsp                               \
+                fate-checkasm-proresdsp                                 \
                 fate-checkasm-sbrdsp                                    \
                 fate-checkasm-synth_filter                              \
                 fate-checkasm-sw_rgb                                    \
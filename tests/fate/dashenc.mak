@@ -0,0 +1,10 @@
+tests/data/dash-ldash/out.mpd: TAG = GEN
+tests/data/dash-ldash/out.mpd: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)mkdir -p $(@D) && $(TARGET_EXEC) $(TARGET_PATH)/$< \
+		-f lavfi -i "testsrc=size=128x96:r=25:d=4" -c:v mpeg4 -g 25 -flags +bitexact -fflags +bitexact \
+		-f dash -ldash 1 -use_template 1 -use_timeline 0 -seg_duration 1 -frag_type frames -frag_frames 5 \
+		-y $(TARGET_PATH)/$@ 2> /dev/null
+
+FATE_FFMPEG-$(call ALLYES, DASH_MUXER MP4_MUXER AVDEVICE TESTSRC_FILTER LAVFI_INDEV MPEG4_ENCODER) += fate-dash-ldash-frames
+fate-dash-ldash-frames: tests/data/dash-ldash/out.mpd
+fate-dash-ldash-frames: CMD = dashfragments tests/data/dash-ldash/out.mpd
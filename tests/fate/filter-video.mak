@@ -499,6 +499,9 @@ fate-filter-vflip_crop: CMD = video_filter "vflip,crop=iw-100:ih-100:100:100"
 FATE_FILTER_VSYNTH-$(CONFIG_VFLIP_FILTER) += fate-filter-vflip_vflip
 fate-filter-vflip_vflip: CMD = video_filter "vflip,vflip"
 
+FATE_FILTER_VSYNTH-$(call ALLYES, PIPELINE_FILTER CROP_FILTER VFLIP_FILTER) += fate-filter-pipeline
+fate-filter-pipeline: CMD = video_filter "pipeline=queue_size=1:graph=vflip,pipeline=graph='crop=iw-100\:ih-100\:100\:100'"
+
 FATE_FILTER_VSYNTH-$(call ALLYES, FORMAT_FILTER PERMS_FILTER EDGEDETECT_FILTER) += fate-filter-edgedetect
 fate-filter-edgedetect: CMD = video_filter "format=gray,perms=random,edgedetect" -frames:v 20
 
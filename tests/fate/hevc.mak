@@ -216,7 +216,21 @@ FATE_HEVC += fate-hevc-conformance-$(1)
 fate-hevc-conformance-$(1): CMD = framecrc -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv444p12le
 endef
 
+# tiles decoded in parallel with slice threads must give the same output
+HEVC_SAMPLES_TILES =            \
+    TILES_A_Cisco_2             \
+    TILES_B_Cisco_1             \
+
+define FATE_HEVC_TEST_SLICE_THREADS
+FATE_HEVC += fate-hevc-slice-threads-$(1)
+fate-hevc-slice-threads-$(1): CMD = framecrc -flags unaligned -vsync drop -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv420p
+fate-hevc-slice-threads-$(1): REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(1)
+fate-hevc-slice-threads-$(1): THREADS = 4
+fate-hevc-slice-threads-$(1): THREAD_TYPE = slice
+endef
+
 $(foreach N,$(HEVC_SAMPLES),$(eval $(call FATE_HEVC_TEST,$(N))))
+$(foreach N,$(HEVC_SAMPLES_TILES),$(eval $(call FATE_HEVC_TEST_SLICE_THREADS,$(N))))
 $(foreach N,$(HEVC_SAMPLES_10BIT),$(eval $(call FATE_HEVC_TEST_10BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_422_10BIT),$(eval $(call FATE_HEVC_TEST_422_10BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_422_10BIN),$(eval $(call FATE_HEVC_TEST_422_10BIN,$(N))))
@@ -92,5 +92,10 @@ FATE_LIBAVCODEC-yes += fate-libavcodec-htmlsubtitles
 fate-libavcodec-htmlsubtitles: libavcodec/tests/htmlsubtitles$(EXESUF)
 fate-libavcodec-htmlsubtitles: CMD = run libavcodec/tests/htmlsubtitles
 
+FATE_LIBAVCODEC-$(CONFIG_RAWVIDEO_DECODER) += fate-libavcodec-shared-decoder
+fate-libavcodec-shared-decoder: libavcodec/tests/shared_decoder$(EXESUF)
+fate-libavcodec-shared-decoder: CMD = run libavcodec/tests/shared_decoder
+fate-libavcodec-shared-decoder: CMP = null
+
 FATE-$(CONFIG_AVCODEC) += $(FATE_LIBAVCODEC-yes)
 fate-libavcodec: $(FATE_LIBAVCODEC-yes)
@@ -2,6 +2,20 @@
 #fate-async: libavformat/tests/async$(EXESUF)
 #fate-async: CMD = run libavformat/tests/async
 
+FATE_LIBAVFORMAT-$(call ALLYES, DASH_MUXER MP4_MUXER) += fate-dashenc
+fate-dashenc: libavformat/tests/dashenc$(EXESUF)
+fate-dashenc: CMD = run libavformat/tests/dashenc
+
+FATE_FILE_MMAP-$(HAVE_MMAP) += fate-file-mmap
+FATE_LIBAVFORMAT-$(CONFIG_FILE_PROTOCOL) += $(FATE_FILE_MMAP-yes)
+fate-file-mmap: libavformat/tests/file_mmap$(EXESUF)
+fate-file-mmap: CMD = run libavformat/tests/file_mmap $(TARGET_PATH)/tests/data/fate/file-mmap.bin
+
+FATE_INDEXCACHE-$(call ALLYES, MPEGTS_MUXER MPEGTS_DEMUXER) += fate-indexcache
+FATE_LIBAVFORMAT-$(CONFIG_FILE_PROTOCOL) += $(FATE_INDEXCACHE-yes)
+fate-indexcache: libavformat/tests/indexcache$(EXESUF)
+fate-indexcache: CMD = run libavformat/tests/indexcache $(TARGET_PATH)/tests/data/fate/indexcache.ts
+
 FATE_LIBAVFORMAT-$(CONFIG_NETWORK) += fate-noproxy
 fate-noproxy: libavformat/tests/noproxy$(EXESUF)
 fate-noproxy: CMD = run libavformat/tests/noproxy
@@ -18,6 +32,11 @@ FATE_LIBAVFORMAT-yes += fate-url
 fate-url: libavformat/tests/url$(EXESUF)
 fate-url: CMD = run libavformat/tests/url
 
+FATE_HLSENC_ASYNC_IO-$(call ALLYES, HLS_MUXER MPEGTS_MUXER HTTP_PROTOCOL) += fate-hlsenc-async-io
+FATE_LIBAVFORMAT-$(HAVE_THREADS) += $(FATE_HLSENC_ASYNC_IO-yes)
+fate-hlsenc-async-io: libavformat/tests/hlsenc_async_io$(EXESUF)
+fate-hlsenc-async-io: CMD = run libavformat/tests/hlsenc_async_io
+
 FATE_LIBAVFORMAT-$(CONFIG_MOV_MUXER) += fate-movenc
 fate-movenc: libavformat/tests/movenc$(EXESUF)
 fate-movenc: CMD = run libavformat/tests/movenc
@@ -0,0 +1,130 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Measure the AVBufferPool get/unref throughput as the number of threads
+ * sharing the pool grows.
+ *
+ * make tools/buffer_pool_bench
+ * tools/buffer_pool_bench [max_threads [iterations]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/buffer.h"
+#include "libavutil/error.h"
+#include "libavutil/thread.h"
+#include "libavutil/time.h"
+
+#define BATCH 4
+
+typedef struct ThreadArg {
+    pthread_t thread;
+    AVBufferPool *pool;
+    int iterations;
+    int ret;
+} ThreadArg;
+
+static void *worker(void *opaque)
+{
+    ThreadArg *arg = opaque;
+    AVBufferRef *bufs[BATCH];
+    int i, j;
+
+    for (i = 0; i < arg->iterations; i++) {
+        for (j = 0; j < BATCH; j++) {
+            bufs[j] = av_buffer_pool_get(arg->pool);
+            if (!bufs[j]) {
+                arg->ret = AVERROR(ENOMEM);
+                while (j--)
+                    av_buffer_unref(&bufs[j]);
+                return NULL;
+            }
+        }
+        for (j = 0; j < BATCH; j++)
+            av_buffer_unref(&bufs[j]);
+    }
+    return NULL;
+}
+
+static int run(int nb_threads, int iterations)
+{
+    AVBufferPool *pool;
+    ThreadArg *args;
+    int64_t start, elapsed;
+    int i, ret = 0;
+
+    pool = av_buffer_pool_init(4096, NULL);
+    args = calloc(nb_threads, sizeof(*args));
+    if (!pool || !args) {
+        av_buffer_pool_uninit(&pool);
+        free(args);
+        return AVERROR(ENOMEM);
+    }
+
+    start = av_gettime_relative();
+    for (i = 0; i < nb_threads; i++) {
+        args[i].pool       = pool;
+        args[i].iterations = iterations;
+        if (pthread_create(&args[i].thread, NULL, worker, &args[i])) {
+            ret = AVERROR(EAGAIN);
+            break;
+        }
+    }
+    nb_threads = i;
+    for (i = 0; i < nb_threads; i++) {
+        pthread_join(args[i].thread, NULL);
+        if (args[i].ret < 0)
+            ret = args[i].ret;
+    }
+    elapsed = av_gettime_relative() - start;
+
+    if (!ret && elapsed > 0)
+        printf("%3d threads %12.0f get+unref/s %8.1f ns/op\n", nb_threads,
+               (double)nb_threads * iterations * BATCH * 1000000 / elapsed,
+               elapsed * 1000.0 / ((double)iterations * BATCH));
+
+    av_buffer_pool_uninit(&pool);
+    free(args);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int max_threads = argc > 1 ? atoi(argv[1]) : 32;
+    int iterations  = argc > 2 ? atoi(argv[2]) : 250000;
+    int n, ret;
+
+    if (max_threads <= 0 || iterations <= 0) {
+        fprintf(stderr, "Usage: %s [max_threads [iterations]]\n", argv[0]);
+        return 1;
+    }
+
+    for (n = 1; n <= max_threads; n *= 2) {
+        ret = run(n, iterations);
+        if (ret < 0) {
+            fprintf(stderr, "Benchmark with %d threads failed: %s\n",
+                    n, av_err2str(ret));
+            return 1;
+        }
+    }
+
+    return 0;
+}
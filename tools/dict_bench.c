@@ -0,0 +1,113 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Measure the cost of building an AVDictionary and of looking up each of
+ * its keys, the access pattern of per-frame filter metadata.
+ *
+ * make tools/dict_bench
+ * tools/dict_bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/common.h"
+#include "libavutil/dict.h"
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+
+static int run(int nb_keys, int iterations)
+{
+    char **keys;
+    int64_t set_time = 0, get_time = 0, start;
+    int i, n, ret = 0;
+
+    keys = av_mallocz_array(nb_keys, sizeof(*keys));
+    if (!keys)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < nb_keys; i++) {
+        keys[i] = av_asprintf("lavfi.signalstats.KEY%d", i);
+        if (!keys[i]) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+    }
+
+    for (n = 0; n < iterations; n++) {
+        AVDictionary *dict = NULL;
+
+        start = av_gettime_relative();
+        for (i = 0; i < nb_keys; i++) {
+            ret = av_dict_set(&dict, keys[i], "0.000000", 0);
+            if (ret < 0) {
+                av_dict_free(&dict);
+                goto end;
+            }
+        }
+        set_time += av_gettime_relative() - start;
+
+        start = av_gettime_relative();
+        for (i = 0; i < nb_keys; i++) {
+            if (!av_dict_get(dict, keys[i], NULL, 0)) {
+                ret = AVERROR_BUG;
+                av_dict_free(&dict);
+                goto end;
+            }
+        }
+        get_time += av_gettime_relative() - start;
+
+        av_dict_free(&dict);
+    }
+
+    printf("%5d keys %10.1f ns/set %10.1f ns/get\n", nb_keys,
+           set_time * 1000.0 / ((double)nb_keys * iterations),
+           get_time * 1000.0 / ((double)nb_keys * iterations));
+
+end:
+    for (i = 0; i < nb_keys; i++)
+        av_free(keys[i]);
+    av_free(keys);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static const int nb_keys[] = { 10, 100, 1000 };
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000;
+    int i, ret;
+
+    if (iterations <= 0) {
+        fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    for (i = 0; i < FF_ARRAY_ELEMS(nb_keys); i++) {
+        ret = run(nb_keys[i], iterations);
+        if (ret < 0) {
+            fprintf(stderr, "Benchmark with %d keys failed: %s\n",
+                    nb_keys[i], av_err2str(ret));
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Measure the cost of the filter graph scheduler as the number of filters
+ * in the graph grows.
+ *
+ * The benchmark graph is a tiny video source followed by a chain of null
+ * filters and a buffersink. The filters do no actual work, so the time
+ * spent per frame and per filter is dominated by the scheduling overhead.
+ *
+ * make tools/filter_sched_bench
+ * tools/filter_sched_bench [max_filters [frames]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/bprint.h"
+#include "libavutil/frame.h"
+#include "libavutil/time.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+static int build_graph(AVFilterGraph **rgraph, AVFilterContext **rsink,
+                       int nb_filters, int nb_frames)
+{
+    AVFilterGraph *graph;
+    AVFilterContext *sink = NULL;
+    AVFilterInOut *outputs = NULL;
+    AVBPrint desc;
+    int i, ret;
+
+    graph = avfilter_graph_alloc();
+    if (!graph)
+        return AVERROR(ENOMEM);
+
+    av_bprint_init(&desc, 0, AV_BPRINT_SIZE_UNLIMITED);
+    av_bprintf(&desc, "color=s=16x16:r=25,trim=end_frame=%d", nb_frames);
+    for (i = 0; i < nb_filters; i++)
+        av_bprintf(&desc, ",null");
+    if (!av_bprint_is_complete(&desc)) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    ret = avfilter_graph_create_filter(&sink, avfilter_get_by_name("buffersink"),
+                                       "out", NULL, NULL, graph);
+    if (ret < 0)
+        goto end;
+
+    outputs = avfilter_inout_alloc();
+    if (!outputs) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    outputs->name       = av_strdup("out");
+    outputs->filter_ctx = sink;
+    outputs->pad_idx    = 0;
+    outputs->next       = NULL;
+
+    ret = avfilter_graph_parse_ptr(graph, desc.str, &outputs, NULL, NULL);
+    if (ret < 0)
+        goto end;
+    ret = avfilter_graph_config(graph, NULL);
+
+end:
+    avfilter_inout_free(&outputs);
+    av_bprint_finalize(&desc, NULL);
+    if (ret < 0) {
+        avfilter_graph_free(&graph);
+        return ret;
+    }
+    *rgraph = graph;
+    *rsink  = sink;
+    return 0;
+}
+
+static int run_graph(int nb_filters, int nb_frames)
+{
+    AVFilterGraph *graph = NULL;
+    AVFilterContext *sink;
+    AVFrame *frame;
+    int64_t start, elapsed;
+    int count = 0, ret;
+
+    ret = build_graph(&graph, &sink, nb_filters, nb_frames);
+    if (ret < 0)
+        return ret;
+
+    frame = av_frame_alloc();
+    if (!frame) {
+        avfilter_graph_free(&graph);
+        return AVERROR(ENOMEM);
+    }
+
+    start = av_gettime_relative();
+    while ((ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+        av_frame_unref(frame);
+        count++;
+    }
+    elapsed = av_gettime_relative() - start;
+    if (ret == AVERROR_EOF)
+        ret = 0;
+
+    if (!ret && count)
+        printf("%6u filters %8d frames %12.3f us/frame %10.1f ns/activation\n",
+               graph->nb_filters, count, (double)elapsed / count,
+               elapsed * 1000.0 / ((double)count * graph->nb_filters));
+
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int max_filters = argc > 1 ? atoi(argv[1]) : 1024;
+    int nb_frames   = argc > 2 ? atoi(argv[2]) : 1000;
+    int n, ret;
+
+    if (max_filters <= 0 || nb_frames <= 0) {
+        fprintf(stderr, "Usage: %s [max_filters [frames]]\n", argv[0]);
+        return 1;
+    }
+
+    for (n = 1; n <= max_filters; n *= 2) {
+        ret = run_graph(n, nb_frames);
+        if (ret < 0) {
+            fprintf(stderr, "Benchmark with %d filters failed: %s\n",
+                    n, av_err2str(ret));
+            return 1;
+        }
+    }
+
+    return 0;
+}
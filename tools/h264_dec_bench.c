@@ -0,0 +1,268 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Measure the H.264 decoder throughput on high bitrate intra-only streams,
+ * where most of the time goes into CABAC residual decoding.
+ *
+ * Without an input file, a synthetic 1080p stream is created with the H.264
+ * encoder of the build (usually libx264), coding noisy frames as intra-only
+ * at a low quantizer, which gives well above 100 Mbit/s at 25 fps.
+ *
+ * make tools/h264_dec_bench
+ * tools/h264_dec_bench [threads [runs [input]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/time.h"
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+
+#define SYNTH_WIDTH  1920
+#define SYNTH_HEIGHT 1080
+#define SYNTH_FRAMES 50
+
+typedef struct PacketList {
+    AVPacket *pkts;
+    int nb_pkts;
+    AVCodecParameters *par;
+} PacketList;
+
+static int add_packet(PacketList *list, AVPacket *pkt)
+{
+    int ret = av_reallocp_array(&list->pkts, list->nb_pkts + 1, sizeof(*list->pkts));
+    if (ret < 0)
+        return ret;
+    av_packet_move_ref(&list->pkts[list->nb_pkts++], pkt);
+    return 0;
+}
+
+static void fill_frame(AVFrame *frame, AVLFG *lfg, int n)
+{
+    int x, y, p;
+
+    /* a gradient with strong noise keeps many large coefficients */
+    for (p = 0; p < 3; p++) {
+        int w = p ? frame->width  / 2 : frame->width;
+        int h = p ? frame->height / 2 : frame->height;
+        for (y = 0; y < h; y++) {
+            uint8_t *line = frame->data[p] + y * frame->linesize[p];
+            for (x = 0; x < w; x++)
+                line[x] = av_clip_uint8(((x + y + n) & 0xFF) / 2 +
+                                        (av_lfg_get(lfg) & 0x7F) - 32);
+        }
+    }
+}
+
+static int synthesize(PacketList *list)
+{
+    AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    AVCodecContext *avctx = NULL;
+    AVFrame *frame = NULL;
+    AVPacket pkt;
+    AVLFG lfg;
+    int i, ret;
+
+    if (!codec) {
+        fprintf(stderr, "No H.264 encoder available, an input file is needed\n");
+        return AVERROR_ENCODER_NOT_FOUND;
+    }
+
+    avctx = avcodec_alloc_context3(codec);
+    frame = av_frame_alloc();
+    if (!avctx || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    avctx->width     = SYNTH_WIDTH;
+    avctx->height    = SYNTH_HEIGHT;
+    avctx->pix_fmt   = AV_PIX_FMT_YUV420P;
+    avctx->time_base = (AVRational){ 1, 25 };
+    avctx->gop_size  = 1;
+    avctx->flags    |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    av_opt_set(avctx->priv_data, "qp",    "6",    0);
+    av_opt_set(avctx->priv_data, "coder", "cabac", 0);
+    if ((ret = avcodec_open2(avctx, codec, NULL)) < 0)
+        goto end;
+
+    frame->format = avctx->pix_fmt;
+    frame->width  = avctx->width;
+    frame->height = avctx->height;
+    if ((ret = av_frame_get_buffer(frame, 32)) < 0)
+        goto end;
+
+    av_lfg_init(&lfg, 0x264);
+    av_init_packet(&pkt);
+    for (i = 0; i <= SYNTH_FRAMES; i++) {
+        if (i < SYNTH_FRAMES) {
+            if ((ret = av_frame_make_writable(frame)) < 0)
+                goto end;
+            fill_frame(frame, &lfg, i);
+            frame->pts = i;
+        }
+        ret = avcodec_send_frame(avctx, i < SYNTH_FRAMES ? frame : NULL);
+        if (ret < 0)
+            goto end;
+        while ((ret = avcodec_receive_packet(avctx, &pkt)) >= 0) {
+            if ((ret = add_packet(list, &pkt)) < 0)
+                goto end;
+        }
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto end;
+    }
+
+    list->par = avcodec_parameters_alloc();
+    if (!list->par) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    ret = avcodec_parameters_from_context(list->par, avctx);
+
+end:
+    av_frame_free(&frame);
+    avcodec_free_context(&avctx);
+    return ret;
+}
+
+static int demux(PacketList *list, const char *filename)
+{
+    AVFormatContext *s = NULL;
+    AVPacket pkt;
+    int idx, ret;
+
+    if ((ret = avformat_open_input(&s, filename, NULL, NULL)) < 0)
+        return ret;
+    if ((ret = avformat_find_stream_info(s, NULL)) < 0)
+        goto end;
+    idx = ret = av_find_best_stream(s, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    if (ret < 0)
+        goto end;
+    if (s->streams[idx]->codecpar->codec_id != AV_CODEC_ID_H264) {
+        fprintf(stderr, "%s does not contain H.264 video\n", filename);
+        ret = AVERROR(EINVAL);
+        goto end;
+    }
+
+    list->par = avcodec_parameters_alloc();
+    if (!list->par) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    if ((ret = avcodec_parameters_copy(list->par, s->streams[idx]->codecpar)) < 0)
+        goto end;
+
+    while ((ret = av_read_frame(s, &pkt)) >= 0) {
+        if (pkt.stream_index == idx)
+            ret = add_packet(list, &pkt);
+        av_packet_unref(&pkt);
+        if (ret < 0)
+            goto end;
+    }
+    ret = ret == AVERROR_EOF ? 0 : ret;
+
+end:
+    avformat_close_input(&s);
+    return ret;
+}
+
+static int run(const PacketList *list, int threads, int runs)
+{
+    AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+    AVCodecContext *avctx = NULL;
+    AVFrame *frame = av_frame_alloc();
+    int64_t start, elapsed = 0, bytes = 0;
+    int i, r, nb_frames = 0, ret;
+
+    if (!frame)
+        return AVERROR(ENOMEM);
+
+    for (r = 0; r < runs; r++) {
+        avctx = avcodec_alloc_context3(codec);
+        if (!avctx) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        if ((ret = avcodec_parameters_to_context(avctx, list->par)) < 0)
+            goto end;
+        avctx->thread_count = threads;
+        if ((ret = avcodec_open2(avctx, codec, NULL)) < 0)
+            goto end;
+
+        start = av_gettime_relative();
+        for (i = 0; i <= list->nb_pkts; i++) {
+            ret = avcodec_send_packet(avctx, i < list->nb_pkts ? &list->pkts[i] : NULL);
+            if (ret < 0)
+                goto end;
+            while ((ret = avcodec_receive_frame(avctx, frame)) >= 0)
+                nb_frames++;
+            if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+                goto end;
+            if (i < list->nb_pkts)
+                bytes += list->pkts[i].size;
+        }
+        elapsed += av_gettime_relative() - start;
+        avcodec_free_context(&avctx);
+    }
+    ret = 0;
+
+    if (elapsed > 0)
+        printf("%dx%d %2d threads %8.2f fps %9.2f Mbit/s of bitstream\n",
+               list->par->width, list->par->height, threads,
+               nb_frames * 1000000.0 / elapsed, bytes * 8.0 / elapsed);
+
+end:
+    av_frame_free(&frame);
+    avcodec_free_context(&avctx);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    PacketList list = { 0 };
+    int threads = argc > 1 ? atoi(argv[1]) : 1;
+    int runs    = argc > 2 ? atoi(argv[2]) : 5;
+    int i, ret;
+
+    if (threads < 0 || runs <= 0) {
+        fprintf(stderr, "Usage: %s [threads [runs [input]]]\n", argv[0]);
+        return 1;
+    }
+
+    ret = argc > 3 ? demux(&list, argv[3]) : synthesize(&list);
+    if (ret >= 0 && !list.nb_pkts)
+        ret = AVERROR_INVALIDDATA;
+    if (ret >= 0)
+        ret = run(&list, threads, runs);
+    if (ret < 0)
+        fprintf(stderr, "Benchmark failed: %s\n", av_err2str(ret));
+
+    for (i = 0; i < list.nb_pkts; i++)
+        av_packet_unref(&list.pkts[i]);
+    av_freep(&list.pkts);
+    avcodec_parameters_free(&list.par);
+    return ret < 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Measure the MJPEG encoder throughput at 1080p and 2160p, with the default
+ * and the optimal Huffman tables.
+ *
+ * make tools/mjpeg_enc_bench
+ * tools/mjpeg_enc_bench [threads [frames]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/common.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/opt.h"
+#include "libavutil/time.h"
+#include "libavcodec/avcodec.h"
+
+static void fill_frame(AVFrame *frame, int n)
+{
+    int x, y;
+
+    for (y = 0; y < frame->height; y++)
+        for (x = 0; x < frame->width; x++)
+            frame->data[0][y * frame->linesize[0] + x] = x + y + n * 3;
+    for (y = 0; y < frame->height / 2; y++) {
+        for (x = 0; x < frame->width / 2; x++) {
+            frame->data[1][y * frame->linesize[1] + x] = 128 + y + n * 2;
+            frame->data[2][y * frame->linesize[2] + x] = 64 + x + n * 5;
+        }
+    }
+}
+
+static int run(int width, int height, const char *huffman,
+               int threads, int nb_frames)
+{
+    AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    AVCodecContext *avctx = NULL;
+    AVFrame *frame = NULL;
+    AVPacket pkt;
+    int64_t start, elapsed, bytes = 0;
+    int i, ret;
+
+    if (!codec)
+        return AVERROR_ENCODER_NOT_FOUND;
+
+    avctx = avcodec_alloc_context3(codec);
+    frame = av_frame_alloc();
+    if (!avctx || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    avctx->width        = width;
+    avctx->height       = height;
+    avctx->pix_fmt      = AV_PIX_FMT_YUVJ420P;
+    avctx->time_base    = (AVRational){ 1, 60 };
+    avctx->thread_count = threads;
+    avctx->thread_type  = FF_THREAD_SLICE;
+    av_opt_set(avctx->priv_data, "huffman", huffman, 0);
+    if ((ret = avcodec_open2(avctx, codec, NULL)) < 0)
+        goto end;
+
+    frame->format = avctx->pix_fmt;
+    frame->width  = width;
+    frame->height = height;
+    if ((ret = av_frame_get_buffer(frame, 32)) < 0)
+        goto end;
+
+    av_init_packet(&pkt);
+    start = av_gettime_relative();
+    for (i = 0; i < nb_frames; i++) {
+        fill_frame(frame, i);
+        frame->pts = i;
+        if ((ret = avcodec_send_frame(avctx, frame)) < 0)
+            goto end;
+        while ((ret = avcodec_receive_packet(avctx, &pkt)) >= 0) {
+            bytes += pkt.size;
+            av_packet_unref(&pkt);
+        }
+        if (ret != AVERROR(EAGAIN))
+            goto end;
+    }
+    elapsed = av_gettime_relative() - start;
+    ret = 0;
+
+    if (elapsed > 0)
+        printf("%4dx%-4d %-7s %2d threads %8.2f fps %10"PRId64" bytes/frame\n",
+               width, height, huffman, avctx->thread_count,
+               nb_frames * 1000000.0 / elapsed, bytes / nb_frames);
+
+end:
+    av_frame_free(&frame);
+    avcodec_free_context(&avctx);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct {
+        int width, height;
+    } sizes[] = { { 1920, 1080 }, { 3840, 2160 } };
+    static const char *const huffman[] = { "default", "optimal" };
+    int threads   = argc > 1 ? atoi(argv[1]) : 0;
+    int nb_frames = argc > 2 ? atoi(argv[2]) : 120;
+    int i, j, ret;
+
+    if (threads < 0 || nb_frames <= 0) {
+        fprintf(stderr, "Usage: %s [threads [frames]]\n", argv[0]);
+        return 1;
+    }
+
+    for (i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        for (j = 0; j < FF_ARRAY_ELEMS(huffman); j++) {
+            ret = run(sizes[i].width, sizes[i].height, huffman[j],
+                      threads, nb_frames);
+            if (ret < 0) {
+                fprintf(stderr, "Encoding %dx%d failed: %s\n",
+                        sizes[i].width, sizes[i].height, av_err2str(ret));
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
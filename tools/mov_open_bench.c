@@ -0,0 +1,106 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Measure how long the mov demuxer takes to open a (fragmented) MP4 file
+ * and seek into the middle of it, with and without the lazy_fragments
+ * option. The bytes read and seeks done while opening are printed too, as
+ * they matter most when reading over the network.
+ *
+ * make tools/mov_open_bench
+ * tools/mov_open_bench file.mp4 [iterations]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/dict.h"
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+
+static int run(const char *filename, int lazy, int iterations)
+{
+    int64_t open_time = 0, seek_time = 0, start;
+    int64_t open_bytes = 0;
+    int nb_index_entries = 0, open_seeks = 0;
+    int i, j, ret = 0;
+
+    for (i = 0; i < iterations; i++) {
+        AVFormatContext *s = NULL;
+        AVDictionary *opts = NULL;
+        AVPacket pkt;
+
+        av_dict_set(&opts, "lazy_fragments", lazy ? "1" : "0", 0);
+        start = av_gettime_relative();
+        ret = avformat_open_input(&s, filename, av_find_input_format("mov"), &opts);
+        open_time += av_gettime_relative() - start;
+        av_dict_free(&opts);
+        if (ret < 0)
+            return ret;
+
+        open_bytes = s->pb->bytes_read;
+        open_seeks = s->pb->seek_count;
+        nb_index_entries = 0;
+        for (j = 0; j < s->nb_streams; j++)
+            nb_index_entries += s->streams[j]->nb_index_entries;
+
+        start = av_gettime_relative();
+        if (s->duration > 0)
+            ret = avformat_seek_file(s, -1, INT64_MIN, s->duration / 2,
+                                     INT64_MAX, 0);
+        if (ret >= 0)
+            ret = av_read_frame(s, &pkt);
+        seek_time += av_gettime_relative() - start;
+        if (ret >= 0)
+            av_packet_unref(&pkt);
+
+        avformat_close_input(&s);
+        if (ret < 0 && ret != AVERROR_EOF)
+            return ret;
+    }
+
+    printf("lazy_fragments=%d %10.3f ms/open %10.3f ms/seek %9d index entries after open "
+           "%12"PRId64" bytes read %6d seeks at open\n",
+           lazy, open_time / 1000.0 / iterations, seek_time / 1000.0 / iterations,
+           nb_index_entries, open_bytes, open_seeks);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 2 ? atoi(argv[2]) : 10;
+    int lazy, ret;
+
+    if (argc < 2 || iterations <= 0) {
+        fprintf(stderr, "Usage: %s file.mp4 [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    for (lazy = 0; lazy <= 1; lazy++) {
+        ret = run(argv[1], lazy, iterations);
+        if (ret < 0) {
+            fprintf(stderr, "Failed to open or seek in %s: %s\n",
+                    argv[1], av_err2str(ret));
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Measure the MPEG-TS muxer throughput.
+ *
+ * A 20 Mbit/s video stream and a 192 kbit/s audio stream with random payload
+ * are muxed into an output which only counts the bytes, so that the time
+ * spent is the time of the muxer alone. The muxrate defaults to VBR (0), the
+ * batch_packets option of the muxer can be given to compare batch sizes.
+ *
+ * make tools/mpegts_mux_bench
+ * tools/mpegts_mux_bench [muxrate [batch_packets [seconds]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/error.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/time.h"
+#include "libavformat/avformat.h"
+
+#define VIDEO_BITRATE 20000000
+#define AUDIO_BITRATE   192000
+#define FRAME_RATE          25
+#define AUDIO_FRAME_SIZE  1152
+#define SAMPLE_RATE      48000
+#define IO_BUFFER_SIZE   32768
+
+static int write_packet(void *opaque, uint8_t *buf, int size)
+{
+    int64_t *bytes = opaque;
+    *bytes += size;
+    return size;
+}
+
+static int add_stream(AVFormatContext *s, enum AVMediaType type,
+                      enum AVCodecID codec_id)
+{
+    AVStream *st = avformat_new_stream(s, NULL);
+
+    if (!st)
+        return AVERROR(ENOMEM);
+    st->codecpar->codec_type = type;
+    st->codecpar->codec_id   = codec_id;
+    if (type == AVMEDIA_TYPE_VIDEO) {
+        st->codecpar->width    = 1920;
+        st->codecpar->height   = 1080;
+        st->codecpar->bit_rate = VIDEO_BITRATE;
+        st->time_base          = (AVRational){ 1, FRAME_RATE };
+    } else {
+        st->codecpar->sample_rate    = SAMPLE_RATE;
+        st->codecpar->channels       = 2;
+        st->codecpar->channel_layout = AV_CH_LAYOUT_STEREO;
+        st->codecpar->frame_size     = AUDIO_FRAME_SIZE;
+        st->codecpar->bit_rate       = AUDIO_BITRATE;
+        st->time_base                = (AVRational){ 1, SAMPLE_RATE };
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *muxrate = argc > 1 ? argv[1] : "0";
+    const char *batch   = argc > 2 ? argv[2] : NULL;
+    int seconds         = argc > 3 ? atoi(argv[3]) : 600;
+    const int video_size = VIDEO_BITRATE / 8 / FRAME_RATE;
+    const int audio_size = AUDIO_BITRATE / 8 * AUDIO_FRAME_SIZE / SAMPLE_RATE;
+    AVFormatContext *s = NULL;
+    AVDictionary *opts = NULL;
+    uint8_t *payload = NULL, *io_buf = NULL;
+    int64_t bytes = 0, start, elapsed, video_pts = 0, audio_pts = 0;
+    AVLFG lfg;
+    int i, ret;
+
+    if (seconds <= 0) {
+        fprintf(stderr, "Usage: %s [muxrate [batch_packets [seconds]]]\n", argv[0]);
+        return 1;
+    }
+
+    payload = av_malloc(video_size);
+    io_buf  = av_malloc(IO_BUFFER_SIZE);
+    if (!payload || !io_buf) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    /* random payload, without start codes the muxer would have to handle */
+    av_lfg_init(&lfg, 0x47);
+    for (i = 0; i < video_size; i++)
+        payload[i] = av_lfg_get(&lfg) | 0x01;
+
+    if ((ret = avformat_alloc_output_context2(&s, NULL, "mpegts", NULL)) < 0)
+        goto end;
+    s->pb = avio_alloc_context(io_buf, IO_BUFFER_SIZE, 1, &bytes,
+                               NULL, write_packet, NULL);
+    if (!s->pb) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    io_buf = NULL;
+    s->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    if ((ret = add_stream(s, AVMEDIA_TYPE_VIDEO, AV_CODEC_ID_MPEG2VIDEO)) < 0 ||
+        (ret = add_stream(s, AVMEDIA_TYPE_AUDIO, AV_CODEC_ID_MP2)) < 0)
+        goto end;
+
+    av_dict_set(&opts, "muxrate", muxrate, 0);
+    if (batch)
+        av_dict_set(&opts, "batch_packets", batch, 0);
+    if ((ret = avformat_write_header(s, &opts)) < 0)
+        goto end;
+
+    start = av_gettime_relative();
+    while (video_pts < seconds * FRAME_RATE) {
+        AVPacket pkt;
+        int video = av_compare_ts(video_pts, (AVRational){ 1, FRAME_RATE },
+                                  audio_pts, (AVRational){ 1, SAMPLE_RATE }) <= 0;
+
+        av_init_packet(&pkt);
+        pkt.data         = payload;
+        pkt.stream_index = !video;
+        if (video) {
+            pkt.size     = video_size;
+            pkt.pts      = video_pts++;
+            pkt.duration = 1;
+            if (pkt.pts % FRAME_RATE == 0)
+                pkt.flags |= AV_PKT_FLAG_KEY;
+        } else {
+            pkt.size     = audio_size;
+            pkt.pts      = audio_pts;
+            pkt.duration = AUDIO_FRAME_SIZE;
+            audio_pts   += AUDIO_FRAME_SIZE;
+        }
+        pkt.dts = pkt.pts;
+        av_packet_rescale_ts(&pkt, video ? (AVRational){ 1, FRAME_RATE } :
+                                           (AVRational){ 1, SAMPLE_RATE },
+                             s->streams[pkt.stream_index]->time_base);
+        if ((ret = av_write_frame(s, &pkt)) < 0)
+            goto end;
+    }
+    if ((ret = av_write_trailer(s)) < 0)
+        goto end;
+    avio_flush(s->pb);
+    elapsed = av_gettime_relative() - start;
+
+    if (elapsed > 0)
+        printf("muxrate %s: %8.2f MB/s, %6.1fx realtime, %"PRId64" TS packets\n",
+               muxrate, bytes / (double)elapsed, seconds * 1000000.0 / elapsed,
+               bytes / 188);
+
+end:
+    if (ret < 0)
+        fprintf(stderr, "Benchmark failed: %s\n", av_err2str(ret));
+    av_dict_free(&opts);
+    if (s && s->pb) {
+        av_freep(&s->pb->buffer);
+        avio_context_free(&s->pb);
+    }
+    avformat_free_context(s);
+    av_free(io_buf);
+    av_free(payload);
+    return ret < 0;
+}